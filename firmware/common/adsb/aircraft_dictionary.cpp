@@ -8,7 +8,36 @@
 #include "macros.hh"
 #include "unit_conversions.hh"
 
-const float kRadiansToDegrees = 360.0f / (2.0f * M_PI);
+const float kDegreesPerBAM = 360.0f / 4294967296.0f;  // 2^32 BAM per turn.
+
+// Aircraft and side table entries, plus each aircraft's share of the hash index and the expiry list.
+static_assert(sizeof(Aircraft) + sizeof(AircraftDetails) + sizeof(CPRPacketPair) + sizeof(ADSBMessageCache) +
+                      sizeof(PendingADSBMessage) +
+                      (sizeof(FixedHashMap<Aircraft, AircraftDictionary::kMaxNumAircraft>) -
+                       sizeof(Aircraft) * AircraftDictionary::kMaxNumAircraft +
+                       sizeof(IndexedLinkedList<AircraftDictionary::kMaxNumAircraft>)) /
+                          AircraftDictionary::kMaxNumAircraft <=
+                  AircraftDictionary::kMaxNumBytesPerAircraft,
+              "AircraftDictionary exceeds its RAM budget per aircraft.");
+
+/**
+ * CPR Packet Pair
+ */
+
+bool CPRPacketPair::SetCPRLatLon(uint32_t n_lat_cpr, uint32_t n_lon_cpr, bool odd, bool surface, bool redigesting) {
+    if (n_lat_cpr > kCPRLatLonMaxCount || n_lon_cpr > kCPRLatLonMaxCount) {
+        return false;  // counts out of bounds, don't parse
+    }
+
+    CPRPacket &packet = odd ? last_odd_packet : last_even_packet;
+    packet.received_timestamp_ms = get_time_since_boot_ms();
+    // Equation 5.5 is skipped, counts are kept as 17-bit fractions of a zone.
+    packet.n_lat = n_lat_cpr;
+    packet.n_lon = n_lon_cpr;
+    packet.surface = surface;
+
+    return true;
+}
 
 /**
  * Aircraft
@@ -22,39 +51,48 @@ Aircraft::Aircraft() {
     // memset(callsign, '\0', kCallSignMaxNumChars + 1);  // clear out callsign string, including extra EOS character
 }
 
-bool Aircraft::DecodePosition() {
-    if (!(last_odd_packet_.received_timestamp_ms > 0 && last_even_packet_.received_timestamp_ms > 0)) {
+bool Aircraft::DecodePosition(CPRPacketPair &cpr_packets) {
+    CPRPacketPair::CPRPacket &last_odd_packet = cpr_packets.last_odd_packet;
+    CPRPacketPair::CPRPacket &last_even_packet = cpr_packets.last_even_packet;
+    if (!(last_odd_packet.received_timestamp_ms > 0 && last_even_packet.received_timestamp_ms > 0)) {
         CONSOLE_WARNING("Aircraft::DecodePosition",
                         "Unable to decode position without receiving an odd and even packet pair.\r\n");
         return false;  // need both an even and an odd packet to be able to decode position
     }
+    if (last_odd_packet.surface || last_even_packet.surface) {
+        CONSOLE_WARNING("Aircraft::DecodePosition", "Unable to globally decode a surface position.\r\n");
+        return false;
+    }
+
+    // All CPR math is done with integers: lat / lon counts are 17-bit fractions of a zone, and angles are in BAM.
 
     // Equation 5.6
-    int32_t lat_zone_index = floorf(59.0f * last_even_packet_.lat_cpr - 60.0f * last_odd_packet_.lat_cpr + 0.5f);
+    int32_t lat_zone_index = (kCPRNumLatZonesOdd * static_cast<int32_t>(last_even_packet.n_lat) -
+                              kCPRNumLatZonesEven * static_cast<int32_t>(last_odd_packet.n_lat) +
+                              static_cast<int32_t>(kCPRNumCounts >> 1)) >>
+                             kCPRCountNumBits;
 
     bool calculate_odd =
-        last_odd_packet_.calculated_timestamp_ms > last_odd_packet_.received_timestamp_ms ? false : true;
+        last_odd_packet.calculated_timestamp_ms > last_odd_packet.received_timestamp_ms ? false : true;
     bool calculate_even =
-        last_even_packet_.calculated_timestamp_ms > last_even_packet_.received_timestamp_ms ? false : true;
+        last_even_packet.calculated_timestamp_ms > last_even_packet.received_timestamp_ms ? false : true;
 
     if (calculate_odd) {
-        // Equation 5.7
-        last_odd_packet_.lat = kCPRdLatOdd * ((lat_zone_index % 59) + last_odd_packet_.lat_cpr);
-        // Equation 5.8: wrap latitude to between -90 and +90 degrees.
-        last_odd_packet_.lat = WrapCPRDecodeLatitude(last_odd_packet_.lat);
+        // Equation 5.7, 5.8: latitude wraps to between -90 and +90 degrees when stored as a signed BAM angle.
+        last_odd_packet.lat_bam = CPRZoneToBAM(CPRMod(lat_zone_index, kCPRNumLatZonesOdd), last_odd_packet.n_lat,
+                                               kCPRNumLatZonesOdd);
         // Calculate NL, which will be used later to calculate the number of longitude zones in this latitude band.
-        last_odd_packet_.nl_cpr = CalcNLCPRFromLat(last_odd_packet_.lat);
-        last_odd_packet_.calculated_timestamp_ms = get_time_since_boot_ms();
+        last_odd_packet.nl_cpr = CalcNLCPRFromLatBAM(last_odd_packet.lat_bam);
+        last_odd_packet.calculated_timestamp_ms = get_time_since_boot_ms();
     }
 
     if (calculate_even) {
-        // Equation 5.7
-        last_even_packet_.lat = kCPRdLatEven * ((lat_zone_index % 60) + last_even_packet_.lat_cpr);
-        // Equation 5.8: wrap latitude to between -90 and +90 degrees.
-        last_even_packet_.lat = WrapCPRDecodeLatitude(last_even_packet_.lat);
+        // Equation 5.7, 5.8: latitude wraps to between -90 and +90 degrees when stored as a signed BAM angle.
+        last_even_packet.lat_bam = CPRZoneToBAM(CPRMod(lat_zone_index, kCPRNumLatZonesEven), last_even_packet.n_lat,
+                                                kCPRNumLatZonesEven);
         // Calculate NL, which will be used later to calculate the number of longitude zones in this latitude band.
-        last_even_packet_.nl_cpr = CalcNLCPRFromLat(last_even_packet_.lat);
-        last_even_packet_.calculated_timestamp_ms = get_time_since_boot_ms();
+        last_even_packet.nl_cpr = CalcNLCPRFromLatBAM(last_even_packet.lat_bam);
+        last_even_packet.calculated_timestamp_ms = get_time_since_boot_ms();
     }
 
     /**
@@ -70,95 +108,267 @@ bool Aircraft::DecodePosition() {
      * incorrectly.
      */
 
-    if (last_odd_packet_.nl_cpr != last_even_packet_.nl_cpr) {
+    if (last_odd_packet.nl_cpr != last_even_packet.nl_cpr) {
         // Invalidate position if position pair is split across different latitude bands.
         WriteBitFlag(BitFlag::kBitFlagPositionValid, false);  // keep last known good coordinates, but mark as invalid
         CONSOLE_WARNING("Aircraft::DecodePosition",
                         "NL_cpr disagrees between odd (%d) and even (%d) packets. Can't decode "
                         "position.\r\n",
-                        last_odd_packet_.nl_cpr, last_even_packet_.nl_cpr);
+                        last_odd_packet.nl_cpr, last_even_packet.nl_cpr);
         return false;
     }
 
     // From here on out, can just focus on the most recent packet since that's what we're using for our position.
-    bool received_odd_last = last_odd_packet_.received_timestamp_ms > last_even_packet_.received_timestamp_ms;
-    CPRPacket &last_packet = received_odd_last ? last_odd_packet_ : last_even_packet_;
-    latitude_deg = last_packet.lat;  // Publish latitude.
+    bool received_odd_last = last_odd_packet.received_timestamp_ms > last_even_packet.received_timestamp_ms;
+    CPRPacketPair::CPRPacket &last_packet = received_odd_last ? last_odd_packet : last_even_packet;
+    latitude_deg_e7 = BAMToDegE7(last_packet.lat_bam);  // Publish latitude.
 
     // Equation 5.10
-    int32_t lon_zone_index = floorf(last_even_packet_.lon_cpr * (last_packet.nl_cpr - 1) -
-                                    last_odd_packet_.lon_cpr * last_packet.nl_cpr + 0.5f);
+    int32_t nl_cpr = last_packet.nl_cpr;
+    int32_t lon_zone_index = (static_cast<int32_t>(last_even_packet.n_lon) * (nl_cpr - 1) -
+                              static_cast<int32_t>(last_odd_packet.n_lon) * nl_cpr +
+                              static_cast<int32_t>(kCPRNumCounts >> 1)) >>
+                             kCPRCountNumBits;
 
     // Equation 5.11: Use nl_lat_cpr to calculate actual number of longitude zones
-    uint16_t num_lon_zones = received_odd_last ? MAX(last_packet.nl_cpr - 1, 1) : MAX(last_packet.nl_cpr, 1);
-    // Equation 5.12: longitude zone size
-    float d_lon = 360.0f / num_lon_zones;
+    uint16_t num_lon_zones = received_odd_last ? MAX(nl_cpr - 1, 1) : MAX(nl_cpr, 1);
 
-    // Equation 5.13 (calc longitude), 5.15 (wrap longitude to between -180 and +180 degrees)
-    longitude_deg = WrapCPRDecodeLongitude(d_lon * ((lon_zone_index % num_lon_zones) + last_packet.lon_cpr));
+    // Equation 5.12 (longitude zone size), 5.13 (calc longitude), 5.15 (wrap longitude to between -180 and +180
+    // degrees, free with a signed BAM angle).
+    longitude_deg_e7 =
+        BAMToDegE7(CPRZoneToBAM(CPRMod(lon_zone_index, num_lon_zones), last_packet.n_lon, num_lon_zones));
+    last_position_timestamp_ms = get_time_since_boot_ms();
     WriteBitFlag(BitFlag::kBitFlagPositionValid, true);  // TODO: Add "reasonable validation" that position is valid.
     return true;
 }
 
-bool Aircraft::SetCPRLatLon(uint32_t n_lat_cpr, uint32_t n_lon_cpr, bool odd, bool redigesting) {
-    if (n_lat_cpr > kCPRLatLonMaxCount || n_lon_cpr > kCPRLatLonMaxCount) {
-        return false;  // counts out of bounds, don't parse
+bool Aircraft::DecodePositionLocal(const CPRPacketPair &cpr_packets, int32_t ref_lat_deg_e7, int32_t ref_lon_deg_e7) {
+    const CPRPacketPair::CPRPacket &last_odd_packet = cpr_packets.last_odd_packet;
+    const CPRPacketPair::CPRPacket &last_even_packet = cpr_packets.last_even_packet;
+    if (last_odd_packet.received_timestamp_ms == 0 && last_even_packet.received_timestamp_ms == 0) {
+        CONSOLE_WARNING("Aircraft::DecodePositionLocal", "Unable to decode position without receiving a packet.\r\n");
+        return false;
+    }
+    bool received_odd_last = last_odd_packet.received_timestamp_ms > last_even_packet.received_timestamp_ms;
+    const CPRPacketPair::CPRPacket &last_packet = received_odd_last ? last_odd_packet : last_even_packet;
+
+    // Surface zones are a quarter of the size of airborne zones, which is the same as having 4x as many zones in a
+    // full turn.
+    uint16_t zone_multiplier = last_packet.surface ? 4 : 1;
+
+    // Locally unambiguous decode: pick the zone that puts the decoded latitude closest to the reference latitude.
+    uint16_t num_lat_zones = (received_odd_last ? kCPRNumLatZonesOdd : kCPRNumLatZonesEven) * zone_multiplier;
+    int32_t lat_zone_index = CalcCPRLocalZoneIndex(DegE7ToBAM(ref_lat_deg_e7), last_packet.n_lat, num_lat_zones);
+    int32_t lat_bam = CPRZoneToBAM(lat_zone_index, last_packet.n_lat, num_lat_zones);
+    if (lat_bam > kBAM90Deg || lat_bam < -kBAM90Deg) {
+        CONSOLE_WARNING("Aircraft::DecodePositionLocal", "Decoded invalid latitude %ld (1e-7 deg).\r\n",
+                        BAMToDegE7(lat_bam));
+        return false;
     }
 
-    CPRPacket &packet = odd ? last_odd_packet_ : last_even_packet_;
-    packet.received_timestamp_ms = get_time_since_boot_ms();
-    packet.n_lat = n_lat_cpr;
-    packet.n_lon = n_lon_cpr;
-    // Equation 5.5
-    packet.lat_cpr = static_cast<float>(n_lat_cpr) / kCPRLatLonMaxCount;
-    packet.lon_cpr = static_cast<float>(n_lon_cpr) / kCPRLatLonMaxCount;
+    // Longitude zone size depends on the number of longitude zones at the decoded latitude.
+    uint16_t nl_cpr = CalcNLCPRFromLatBAM(lat_bam);
+    uint16_t num_lon_zones = (received_odd_last ? MAX(nl_cpr - 1, 1) : MAX(nl_cpr, 1)) * zone_multiplier;
+    int32_t lon_zone_index = CalcCPRLocalZoneIndex(DegE7ToBAM(ref_lon_deg_e7), last_packet.n_lon, num_lon_zones);
 
+    latitude_deg_e7 = BAMToDegE7(lat_bam);
+    longitude_deg_e7 = BAMToDegE7(CPRZoneToBAM(lon_zone_index, last_packet.n_lon, num_lon_zones));
+    last_position_timestamp_ms = get_time_since_boot_ms();
+    WriteBitFlag(BitFlag::kBitFlagPositionValid, true);
     return true;
 }
 
+/**
+ * Aircraft Candidate Table
+ */
+
+void AircraftCandidateTable::Clear() {
+    for (Candidate &candidate : candidates_) {
+        candidate = Candidate();
+    }
+}
+
+uint16_t AircraftCandidateTable::RecordSighting(uint32_t icao_address, uint32_t timestamp_ms, uint32_t ttl_ms) {
+    Candidate *set = GetSet(icao_address);
+    Candidate *replace = &set[0];
+    uint32_t replace_age_ms = 0;
+    for (uint16_t i = 0; i < kNumWays; i++) {
+        Candidate &candidate = set[i];
+        uint32_t age_ms =
+            candidate.num_sightings == 0 ? UINT32_MAX : timestamp_ms - candidate.first_sighting_timestamp_ms;
+        if (age_ms <= ttl_ms && candidate.icao_address == icao_address) {
+            if (candidate.num_sightings < UINT8_MAX) {
+                candidate.num_sightings++;
+            }
+            return candidate.num_sightings;
+        }
+        // Replace the oldest entry. Unused and expired entries are always older than entries that are still live.
+        if (age_ms > replace_age_ms) {
+            replace = &candidate;
+            replace_age_ms = age_ms;
+        }
+    }
+    replace->icao_address = icao_address;
+    replace->num_sightings = 1;
+    replace->first_sighting_timestamp_ms = timestamp_ms;
+    return replace->num_sightings;
+}
+
+void AircraftCandidateTable::Remove(uint32_t icao_address) {
+    Candidate *set = GetSet(icao_address);
+    for (uint16_t i = 0; i < kNumWays; i++) {
+        if (set[i].num_sightings > 0 && set[i].icao_address == icao_address) {
+            set[i] = Candidate();
+        }
+    }
+}
+
+/**
+ * Recent ICAO Address Set
+ */
+
+void RecentICAOAddressSet::Clear() {
+    for (Entry &entry : entries_) {
+        entry = Entry();
+    }
+}
+
+void RecentICAOAddressSet::Insert(uint32_t icao_address, uint32_t timestamp_ms) {
+    Entry *set = &entries_[GetSetIndex(icao_address)];
+    Entry *replace = &set[0];
+    uint32_t replace_age_ms = 0;
+    for (uint16_t i = 0; i < kNumWays; i++) {
+        Entry &entry = set[i];
+        if (entry.in_use && entry.icao_address == icao_address) {
+            replace = &entry;
+            break;
+        }
+        // Replace the least recently seen entry. Unused entries are always replaced first.
+        uint32_t age_ms = entry.in_use ? timestamp_ms - entry.last_seen_timestamp_ms : UINT32_MAX;
+        if (age_ms > replace_age_ms) {
+            replace = &entry;
+            replace_age_ms = age_ms;
+        }
+    }
+    replace->icao_address = icao_address;
+    replace->in_use = 1;
+    replace->last_seen_timestamp_ms = timestamp_ms;
+}
+
+bool RecentICAOAddressSet::Contains(uint32_t icao_address, uint32_t timestamp_ms, uint32_t ttl_ms) const {
+    const Entry *set = &entries_[GetSetIndex(icao_address)];
+    for (uint16_t i = 0; i < kNumWays; i++) {
+        if (set[i].in_use && set[i].icao_address == icao_address) {
+            return timestamp_ms - set[i].last_seen_timestamp_ms <= ttl_ms;
+        }
+    }
+    return false;
+}
+
 /**
  * Aircraft Dictionary
  */
 
 void AircraftDictionary::Init() {
-    dict.clear();  // Remove all aircraft from the unordered map.
+    dict.Clear();  // Remove all aircraft from the map.
+    expiry_list_.Clear();
+    candidate_table_.Clear();
+    recent_icao_addresses_.Clear();
+    stats_num_packets_corrected_1_bit = 0;
+    stats_num_packets_corrected_2_bit = 0;
+    stats_num_aircraft_evicted = 0;
+    stats_num_aircraft_rejected = 0;
+    stats_num_candidates_promoted = 0;
+    stats_num_candidates_unallocated = 0;
+    stats_num_comm_b_unknown = 0;
+    stats_num_comm_b_ambiguous = 0;
+    stats_num_adsb_message_cache_hits = 0;
+    stats_num_adsb_message_cache_misses = 0;
+    stats_num_surface_positions_undecodable = 0;
 }
 
-void AircraftDictionary::Update(uint32_t timestamp_ms) {
-    // Iterate over each key-value pair in the unordered_map
-    for (auto it = dict.begin(); it != dict.end(); /* No increment here */) {
-        if (timestamp_ms - it->second.last_message_timestamp_ms > config_.aircraft_prune_interval_ms) {
-            it = dict.erase(it);  // Remove stale aircraft entry.
-        } else {
-            it++;  // Move to the next aircraft entry.
+uint16_t AircraftDictionary::Update(uint32_t timestamp_ms) {
+    uint16_t num_aircraft_pruned = 0;
+    // Stale aircraft are at the front of the expiry list, stop at the first one that isn't stale.
+    for (uint16_t slot = expiry_list_.Front(); slot != IndexedLinkedList<kMaxNumAircraft>::kInvalidIndex;
+         slot = expiry_list_.Front()) {
+        Aircraft *aircraft = dict.GetBySlotIndex(slot);
+        // Signed comparison, so that aircraft with messages newer than timestamp_ms aren't treated as very old.
+        if (static_cast<int32_t>(timestamp_ms - aircraft->last_message_timestamp_ms) <=
+            static_cast<int32_t>(config_.aircraft_prune_interval_ms)) {
+            break;
         }
+        expiry_list_.Remove(slot);
+        dict.Erase(aircraft->icao_address);  // Remove stale aircraft entry.
+        num_aircraft_pruned++;
     }
+    return num_aircraft_pruned;
 }
 
 bool AircraftDictionary::IngestDecodedTransponderPacket(DecodedTransponderPacket &packet) {
+    // Only an extended squitter that passed its CRC without help is trusted to add a new aircraft on its own. DF18
+    // isn't, since it's also used by non-transponder devices and for rebroadcasts of aircraft with non-ICAO addresses.
+    bool trusted = packet.IsValid() &&
+                   packet.GetDownlinkFormat() == DecodedTransponderPacket::kDownlinkFormatExtendedSquitter;
     if (!packet.IsValid()) {
-        if (packet.GetPacketBufferLenBits() == DecodedTransponderPacket::kSquitterPacketLenBits &&
-            ContainsAircraft(packet.GetICAOAddress())) {
-            // Packet is a 56-bit Squitter packet that is incapable of validating itself, and its CRC was validated
-            // against the ICAO addresses in the aircraft dictionary.
+        if (packet.HasAddressParity() &&
+            (ContainsAircraft(packet.GetICAOAddress()) ||
+             recent_icao_addresses_.Contains(packet.GetICAOAddress(), get_time_since_boot_ms(),
+                                             config_.recent_icao_address_ttl_ms))) {
+            // Packet is an Address / Parity packet that is incapable of validating itself, and its CRC was validated
+            // against the ICAO addresses in the aircraft dictionary or recently seen in all-call replies.
             packet.ForceValid();
             // Continue to add packet to dictionary.
+        } else if (uint16_t num_bits_corrected = packet.CorrectBitErrors(config_.max_num_bits_to_correct)) {
+            // Packet is 112 bits and was repaired using its CRC syndrome.
+            if (num_bits_corrected == 1) {
+                stats_num_packets_corrected_1_bit++;
+            } else {
+                stats_num_packets_corrected_2_bit++;
+            }
+            // Continue to add packet to dictionary.
         } else {
             // Packet is 112 bits, should have been able to validate itself. Something is borked.
             return false;
         }
     }
-
     uint16_t downlink_format = packet.GetDownlinkFormat();
+    // Bit error correction can "repair" a packet into one with the wrong ICAO address, and Address / Parity packets
+    // with bit errors validate against the wrong address, so don't let them add a new aircraft until the address has
+    // been confirmed. All-call replies never add aircraft.
+    if (!trusted && downlink_format != DecodedTransponderPacket::kDownlinkFormatAllCallReply &&
+        !ContainsAircraft(packet.GetICAOAddress()) && !ConfirmCandidateAircraft(packet.GetICAOAddress())) {
+        return false;
+    }
+
     switch (downlink_format) {
+        // Mode C Packet.
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatAltitudeReply:  // DF = 4
+            IngestModeCPacket(ModeCPacket(packet));
+            break;
         // Mode A Packet.
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatAltitudeReply:
-            IngestModeCPacket(ModeAPacket(packet));
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatIdentityReply:  // DF = 5
+            IngestModeAPacket(ModeAPacket(packet));
             break;
-        // Mode C Packet.
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatIdentityReply:
-            IngestModeAPacket(ModeCPacket(packet));
+        // Comm-B Packets, which carry a Comm-B message along with the Mode C altitude or Mode A identity.
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatCommBAltitudeReply:  // DF = 20
+            if (IngestModeCPacket(ModeCPacket(packet))) {
+                IngestCommBPacket(CommBPacket(packet));
+            }
             break;
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatCommBIdentityReply:  // DF = 21
+            if (IngestModeAPacket(ModeAPacket(packet))) {
+                IngestCommBPacket(CommBPacket(packet));
+            }
+            break;
+        // ACAS Packets.
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatShortRangeAirToAirSurveillance:  // DF = 0
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatLongRangeAirToAirSurveillance:   // DF = 16
+            IngestAirAirSurveillancePacket(AirAirSurveillancePacket(packet));
+            break;
+        // All-call reply or acquisition squitter.
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatAllCallReply:
+            return IngestAllCallReplyPacket(AllCallReplyPacket(packet));
         // ADS-B Packets.
         case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatExtendedSquitter:                // DF = 17
         case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatExtendedSquitterNonTransponder:  // DF = 18
@@ -166,11 +376,7 @@ bool AircraftDictionary::IngestDecodedTransponderPacket(DecodedTransponderPacket
             // Handle ADS-B Packets.
             return IngestADSBPacket(ADSBPacket(packet));
             break;
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatShortRangeAirToAirSurveillance:  // DF = 0
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatLongRangeAirToAirSurveillance:   // DF = 16
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatCommBAltitudeReply:              // DF = 20
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatCommBIdentityReply:              // DF = 21
-        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatCommDExtendedLengthMessage:      // DF = 24
+        case DecodedTransponderPacket::DownlinkFormat::kDownlinkFormatCommDExtendedLengthMessage:  // DF = 24
             // Silently handle currently unsupported downlink formats.
             break;
 
@@ -182,8 +388,10 @@ bool AircraftDictionary::IngestDecodedTransponderPacket(DecodedTransponderPacket
     return true;
 }
 
-bool AircraftDictionary::IngestModeAPacket(ModeAPacket packet) {
-    if (!packet.IsValid() || packet.GetDownlinkFormat() != ModeAPacket::kDownlinkFormatIdentityReply) {
+bool AircraftDictionary::IngestModeAPacket(const ModeAPacket &packet) {
+    uint16_t downlink_format = packet.GetDownlinkFormat();
+    if (!packet.IsValid() || (downlink_format != DecodedTransponderPacket::kDownlinkFormatIdentityReply &&
+                              downlink_format != DecodedTransponderPacket::kDownlinkFormatCommBIdentityReply)) {
         return false;
     }
 
@@ -195,17 +403,23 @@ bool AircraftDictionary::IngestModeAPacket(ModeAPacket packet) {
                         icao_address);
         return false;  // unable to find or create new aircraft in dictionary
     }
+    DecodePendingMessages(*aircraft_ptr);  // Lazily decoded ADS-B messages were received before this reply.
     aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne, packet.IsAirborne());
     aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagAlert, packet.HasAlert());
     aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagIdent, packet.HasIdent());
+    UpdateLastMessageTimestamp(*aircraft_ptr);
     aircraft_ptr->squawk = packet.GetSquawk();
-    aircraft_ptr->IncrementNumFramesReceived(false);
+    // DF=4 and DF=5 replies are counted as Mode A/C frames, to match ADSBee's frame statistics.
+    aircraft_ptr->IncrementNumFramesReceived(
+        downlink_format == DecodedTransponderPacket::kDownlinkFormatCommBIdentityReply);
 
     return true;
 }
 
-bool AircraftDictionary::IngestModeCPacket(ModeCPacket packet) {
-    if (!packet.IsValid() || packet.GetDownlinkFormat() != ModeCPacket::kDownlinkFormatAltitudeReply) {
+bool AircraftDictionary::IngestModeCPacket(const ModeCPacket &packet) {
+    uint16_t downlink_format = packet.GetDownlinkFormat();
+    if (!packet.IsValid() || (downlink_format != DecodedTransponderPacket::kDownlinkFormatAltitudeReply &&
+                              downlink_format != DecodedTransponderPacket::kDownlinkFormatCommBAltitudeReply)) {
         return false;
     }
 
@@ -217,150 +431,453 @@ bool AircraftDictionary::IngestModeCPacket(ModeCPacket packet) {
                         icao_address);
         return false;  // unable to find or create new aircraft in dictionary
     }
+    DecodePendingMessages(*aircraft_ptr);  // Lazily decoded ADS-B messages were received before this reply.
     aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne, packet.IsAirborne());
     aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagAlert, packet.HasAlert());
     aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagIdent, packet.HasIdent());
-    aircraft_ptr->baro_altitude_ft = packet.GetAltitudeFt();
-    aircraft_ptr->IncrementNumFramesReceived(false);
+    UpdateLastMessageTimestamp(*aircraft_ptr);
+    ApplyReplyAltitude(*aircraft_ptr, packet.GetAltitudeFt());
+    aircraft_ptr->IncrementNumFramesReceived(
+        downlink_format == DecodedTransponderPacket::kDownlinkFormatCommBAltitudeReply);
 
     return true;
 }
 
-bool AircraftDictionary::IngestADSBPacket(ADSBPacket packet) {
-    if (!packet.IsValid() || packet.GetDownlinkFormat() != ADSBPacket::kDownlinkFormatExtendedSquitter) {
-        return false;  // Only allow valid DF17 packets.
+bool AircraftDictionary::IngestAirAirSurveillancePacket(const AirAirSurveillancePacket &packet) {
+    uint16_t downlink_format = packet.GetDownlinkFormat();
+    if (!packet.IsValid() ||
+        (downlink_format != DecodedTransponderPacket::kDownlinkFormatShortRangeAirToAirSurveillance &&
+         downlink_format != DecodedTransponderPacket::kDownlinkFormatLongRangeAirToAirSurveillance)) {
+        return false;
     }
 
     uint32_t icao_address = packet.GetICAOAddress();
     Aircraft *aircraft_ptr = GetAircraftPtr(icao_address);
     if (aircraft_ptr == nullptr) {
-        CONSOLE_WARNING("AircraftDictionary::IngestADSBPacket",
+        CONSOLE_WARNING("AircraftDictionary::IngestAirAirSurveillancePacket",
                         "Unable to find or create new aircraft with ICAO address 0x%lx in dictionary.\r\n",
                         icao_address);
         return false;  // unable to find or create new aircraft in dictionary
     }
-    aircraft_ptr->last_message_timestamp_ms = get_time_since_boot_ms();
+    DecodePendingMessages(*aircraft_ptr);  // Lazily decoded ADS-B messages were received before this reply.
+    aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne, packet.IsAirborne());
+    UpdateLastMessageTimestamp(*aircraft_ptr);
+    ApplyReplyAltitude(*aircraft_ptr, packet.GetAltitudeFt());
+    aircraft_ptr->IncrementNumFramesReceived(true);
 
-    bool ret = false;
-    uint16_t typecode = packet.GetTypeCode();
-    switch (typecode) {
-        case ADSBPacket::kTypeCodeAircraftID:      // TC = 1 (Aircraft Identification)
-        case ADSBPacket::kTypeCodeAircraftID + 1:  // TC = 2 (Aircraft Identification)
-        case ADSBPacket::kTypeCodeAircraftID + 2:  // TC = 3 (Aircraft Identification)
-        case ADSBPacket::kTypeCodeAircraftID + 3:  // TC = 4 (Aircraft Identification)
-            ret = ApplyAircraftIDMessage(*aircraft_ptr, packet);
-            break;
-        case ADSBPacket::kTypeCodeSurfacePosition:      // TC = 5 (Surface Position)
-        case ADSBPacket::kTypeCodeSurfacePosition + 1:  // TC = 6 (Surface Position)
-        case ADSBPacket::kTypeCodeSurfacePosition + 2:  // TC = 7 (Surface Position)
-        case ADSBPacket::kTypeCodeSurfacePosition + 3:  // TC = 8 (Surface Position)
-            ret = ApplySurfacePositionMessage(*aircraft_ptr, packet);
-            break;
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt:      // TC = 9 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 1:  // TC = 10 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 2:  // TC = 11 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 3:  // TC = 12 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 4:  // TC = 13 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 5:  // TC = 14 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 6:  // TC = 15 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 7:  // TC = 16 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 8:  // TC = 17 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionBaroAlt + 9:  // TC = 18 (Airborne Position w/ Baro Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionGNSSAlt:      // TC = 20 (Airborne Position w/ GNSS Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionGNSSAlt + 1:  // TC = 21 (Airborne Position w/ GNSS Altitude)
-        case ADSBPacket::kTypeCodeAirbornePositionGNSSAlt + 2:  // TC = 22 (Airborne Position w/ GNSS Altitude)
-            ret = ApplyAirbornePositionMessage(*aircraft_ptr, packet);
-            break;
-        case ADSBPacket::kTypeCodeAirborneVelocities:  // TC = 19 (Airborne Velocities)
-            ret = ApplyAirborneVelocitiesMessage(*aircraft_ptr, packet);
-            break;
-        case ADSBPacket::kTypeCodeReserved:      // TC = 23 (Reserved)
-        case ADSBPacket::kTypeCodeReserved + 1:  // TC = 24 (Reserved)
-        case ADSBPacket::kTypeCodeReserved + 2:  // TC = 25 (Reserved)
-        case ADSBPacket::kTypeCodeReserved + 3:  // TC = 26 (Reserved)
-        case ADSBPacket::kTypeCodeReserved + 4:  // TC = 27 (Reserved)
-            ret = false;
-            break;
-        case ADSBPacket::kTypeCodeAircraftStatus:  // TC = 28 (Aircraft Status)
-            ret = ApplyAircraftStatusMessage(*aircraft_ptr, packet);
+    return true;
+}
+
+bool AircraftDictionary::IngestCommBPacket(const CommBPacket &packet) {
+    uint16_t downlink_format = packet.GetDownlinkFormat();
+    if (!packet.IsValid() || (downlink_format != DecodedTransponderPacket::kDownlinkFormatCommBAltitudeReply &&
+                              downlink_format != DecodedTransponderPacket::kDownlinkFormatCommBIdentityReply)) {
+        return false;
+    }
+
+    Aircraft *aircraft_ptr = dict.Find(packet.GetICAOAddress());
+    if (aircraft_ptr == nullptr) {
+        return false;  // Comm-B messages are only ingested for aircraft that have already been added by the reply.
+    }
+    DecodePendingMessages(*aircraft_ptr);
+    AircraftDetails &details = GetAircraftDetails(*aircraft_ptr);
+
+    switch (packet.InferBDS()) {
+        case CommBPacket::kBDS40SelectedVerticalIntention: {
+            int32_t selected_altitude_ft;
+            if (packet.GetMCPSelectedAltitudeFt(selected_altitude_ft) ||
+                packet.GetFMSSelectedAltitudeFt(selected_altitude_ft)) {
+                details.selected_altitude_ft = selected_altitude_ft;
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagSelectedAltitudeValid, true);
+            }
+            packet.GetBaroPressureSettingMbE1(details.baro_pressure_setting_mb_e1);
             break;
-        case ADSBPacket::kTypeCodeTargetStateAndStatusInfo:  // TC = 29 (Target state and status info)
-            ret = ApplyTargetStateAndStatusInfoMessage(*aircraft_ptr, packet);
+        }
+        case CommBPacket::kBDS50TrackAndTurnReport: {
+            if (packet.GetRollAngleDeg(details.roll_deg)) {
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagRollAngleValid, true);
+            }
+            packet.GetTrueAirspeedKts(details.true_airspeed_kts);
+            if (details.HasRecentADSBVelocity()) {
+                break;  // ADS-B velocities take precedence.
+            }
+            uint16_t ground_speed_kts;
+            if (packet.GetGroundSpeedKts(ground_speed_kts)) {
+                aircraft_ptr->velocity_kts = ground_speed_kts;
+                aircraft_ptr->velocity_source = Aircraft::VelocitySource::kVelocitySourceGroundSpeed;
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedHorizontalVelocity, true);
+            }
+            if (packet.GetTrueTrackDeg(aircraft_ptr->track_deg)) {
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedTrack, true);
+            }
             break;
-        case ADSBPacket::kTypeCodeAircraftOperationStatus:  // TC = 31 (Aircraft operation status)
-            ret = ApplyAircraftOperationStatusMessage(*aircraft_ptr, packet);
+        }
+        case CommBPacket::kBDS60HeadingAndSpeedReport:
+            if (packet.GetMagneticHeadingDeg(details.heading_deg)) {
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagHeadingValid, true);
+            }
+            packet.GetIndicatedAirspeedKts(details.indicated_airspeed_kts);
+            packet.GetMachE3(details.mach_e3);
+            if (details.HasRecentADSBVelocity()) {
+                break;  // ADS-B velocities take precedence.
+            }
+            // Inertial vertical rate is a geometric rate like the GNSS rate in ADS-B, use it if there's no baro rate.
+            if (packet.GetBaroVerticalRateFpm(aircraft_ptr->vertical_rate_fpm)) {
+                aircraft_ptr->vertical_rate_source = Aircraft::VerticalRateSource::kVerticalRateSourceBaro;
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedVerticalVelocity, true);
+            } else if (packet.GetInertialVerticalRateFpm(aircraft_ptr->vertical_rate_fpm)) {
+                aircraft_ptr->vertical_rate_source = Aircraft::VerticalRateSource::kVerticalRateSourceGNSS;
+                aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedVerticalVelocity, true);
+            }
             break;
+        case CommBPacket::kBDSAmbiguous:
+            stats_num_comm_b_ambiguous++;
+            return false;
         default:
-            CONSOLE_ERROR("AircraftDictionary::IngestADSBPacket", "Received ADSB message with unsupported typecode %d.",
-                          typecode);
-            ret = false;  // kTypeCodeInvalid, etc.
+            stats_num_comm_b_unknown++;
+            return false;
+    }
+    return true;
+}
+
+bool AircraftDictionary::IngestAllCallReplyPacket(const AllCallReplyPacket &packet) {
+    if (!packet.IsValid() || packet.GetDownlinkFormat() != DecodedTransponderPacket::kDownlinkFormatAllCallReply) {
+        return false;
+    }
+
+    uint32_t icao_address = packet.GetICAOAddress();
+    if (!IsAllocatedICAOAddress(icao_address)) {
+        // All-call replies with a nonzero interrogator code overlay it on the parity, so a corrupted reply can validate
+        // with a bogus address. Don't let it vouch for Address / Parity packets.
+        stats_num_candidates_unallocated++;
+        return false;
+    }
+    recent_icao_addresses_.Insert(icao_address, get_time_since_boot_ms());
+    // All-call replies carry too little information to be worth tracking a new aircraft for.
+    Aircraft *aircraft_ptr = dict.Find(icao_address);
+    if (aircraft_ptr == nullptr) {
+        return true;
+    }
+    DecodePendingMessages(*aircraft_ptr);
+    UpdateLastMessageTimestamp(*aircraft_ptr);
+    ADSBPacket::Capability capability = packet.GetCapability();
+    if (capability == ADSBPacket::kCALevel2PlusTransponderOnSurfaceCanSetCA7 ||
+        capability == ADSBPacket::kCALevel2PlusTransponderAirborneCanSetCA7) {
+        aircraft_ptr->WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne,
+                                   capability == ADSBPacket::kCALevel2PlusTransponderAirborneCanSetCA7);
+    }
+    GetAircraftDetails(*aircraft_ptr).transponder_capability = capability;
+    // Identification messages also write the capability, so a repeated one must be decoded again.
+    GetADSBMessageCache(*aircraft_ptr).Invalidate(ADSBMessageCache::kMessageClassAircraftID);
+    aircraft_ptr->IncrementNumFramesReceived(true);
+    return true;
+}
+
+// Table 3.3 from The 1090Mhz Riddle (Junzi Sun), pg. 37.
+constexpr AircraftDictionary::ADSBMessageHandler AircraftDictionary::kADSBMessageHandlers[ADSBPacket::kNumTypeCodes] = {
+    nullptr,                                                    // TC = 0 (No position information)
+    &AircraftDictionary::ApplyAircraftIDMessage,                // TC = 1 (Aircraft Identification)
+    &AircraftDictionary::ApplyAircraftIDMessage,                // TC = 2 (Aircraft Identification)
+    &AircraftDictionary::ApplyAircraftIDMessage,                // TC = 3 (Aircraft Identification)
+    &AircraftDictionary::ApplyAircraftIDMessage,                // TC = 4 (Aircraft Identification)
+    &AircraftDictionary::ApplySurfacePositionMessage,           // TC = 5 (Surface Position)
+    &AircraftDictionary::ApplySurfacePositionMessage,           // TC = 6 (Surface Position)
+    &AircraftDictionary::ApplySurfacePositionMessage,           // TC = 7 (Surface Position)
+    &AircraftDictionary::ApplySurfacePositionMessage,           // TC = 8 (Surface Position)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 9 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 10 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 11 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 12 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 13 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 14 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 15 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 16 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 17 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 18 (Airborne Position w/ Baro Altitude)
+    &AircraftDictionary::ApplyAirborneVelocitiesMessage,        // TC = 19 (Airborne Velocities)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 20 (Airborne Position w/ GNSS Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 21 (Airborne Position w/ GNSS Altitude)
+    &AircraftDictionary::ApplyAirbornePositionMessage,          // TC = 22 (Airborne Position w/ GNSS Altitude)
+    nullptr,                                                    // TC = 23 (Reserved)
+    nullptr,                                                    // TC = 24 (Reserved)
+    nullptr,                                                    // TC = 25 (Reserved)
+    nullptr,                                                    // TC = 26 (Reserved)
+    nullptr,                                                    // TC = 27 (Reserved)
+    &AircraftDictionary::ApplyAircraftStatusMessage,            // TC = 28 (Aircraft Status)
+    &AircraftDictionary::ApplyTargetStateAndStatusInfoMessage,  // TC = 29 (Target state and status info)
+    nullptr,                                                    // TC = 30 (Reserved)
+    &AircraftDictionary::ApplyAircraftOperationStatusMessage,   // TC = 31 (Aircraft operation status)
+};
+
+bool AircraftDictionary::IngestADSBPacket(const ADSBPacket &packet) {
+    if (!packet.IsValid() || packet.GetDownlinkFormat() != DecodedTransponderPacket::kDownlinkFormatExtendedSquitter) {
+        return false;  // Only allow valid DF17 packets.
+    }
+
+    uint32_t icao_address = packet.GetICAOAddress();
+    Aircraft *aircraft_ptr = GetAircraftPtr(icao_address);
+    if (aircraft_ptr == nullptr) {
+        CONSOLE_WARNING("AircraftDictionary::IngestADSBPacket",
+                        "Unable to find or create new aircraft with ICAO address 0x%lx in dictionary.\r\n",
+                        icao_address);
+        return false;  // unable to find or create new aircraft in dictionary
+    }
+    UpdateLastMessageTimestamp(*aircraft_ptr);
+
+    // Typecode is a 5-bit field, so it's always a valid index into the handler table.
+    ADSBMessageHandler handler = kADSBMessageHandlers[packet.GetTypeCode()];
+    if (handler == nullptr) {
+        return false;  // TC = 0 (No position information), reserved, or unsupported typecode.
+    }
+
+    uint64_t me = packet.GetNBitWord64FromMessage<ADSBPacket::kMENumBits, 0>();
+    if (config_.lazy_decode) {
+        // Apply messages in the order they were received in. A pending message that would be overwritten by this one
+        // is dropped instead, before the cache is checked, so that it can't be applied after a newer cache hit.
+        PendingADSBMessage &pending = GetPendingADSBMessage(*aircraft_ptr);
+        if (pending.IsReplacedBy(me)) {
+            pending.Clear();
+        } else {
+            DecodePendingMessages(*aircraft_ptr);
+        }
+    }
+
+    // Messages that repeat the last message of their class would decode to the same values, only count them.
+    ADSBMessageCache::MessageClass message_class = ADSBMessageCache::GetMessageClass(packet.GetTypeCode());
+    ADSBMessageCache &cache = GetADSBMessageCache(*aircraft_ptr);
+    if (message_class != ADSBMessageCache::kMessageClassNone) {
+        if (cache.Contains(message_class, packet.GetCapability(), me)) {
+            stats_num_adsb_message_cache_hits++;
+            aircraft_ptr->IncrementNumFramesReceived(true);
+            return true;
+        }
+        stats_num_adsb_message_cache_misses++;
+    }
+
+    if (config_.lazy_decode && PendingADSBMessage::IsDeferrable(packet.GetTypeCode())) {
+        // Decoded when the aircraft is read, or when the next message from it arrives.
+        GetPendingADSBMessage(*aircraft_ptr).Store(packet.GetCapability(), me);
+        aircraft_ptr->IncrementNumFramesReceived(true);
+        return true;
+    }
+
+    bool ret = (this->*handler)(*aircraft_ptr, packet);
+    if (message_class != ADSBMessageCache::kMessageClassNone) {
+        if (ret) {
+            cache.Store(message_class, packet.GetCapability(), me);
+        } else {
+            cache.Invalidate(message_class);
+        }
     }
     if (ret) aircraft_ptr->IncrementNumFramesReceived(true);  // Count the received Mode S frame.
     return ret;
 }
 
-uint16_t AircraftDictionary::GetNumAircraft() { return dict.size(); }
+uint16_t AircraftDictionary::GetNumAircraft() { return dict.Size(); }
 
 bool AircraftDictionary::InsertAircraft(const Aircraft &aircraft) {
-    auto itr = dict.find(aircraft.icao_address);
-    if (itr != dict.end()) {
-        // Overwriting an existing aircraft
-        itr->second = aircraft;
-        return true;
+    bool inserted;
+    Aircraft *aircraft_ptr = dict.GetOrInsert(aircraft.icao_address, inserted);
+    if (aircraft_ptr == nullptr && EvictAircraft()) {
+        aircraft_ptr = dict.GetOrInsert(aircraft.icao_address, inserted);
     }
-
-    if (dict.size() >= kMaxNumAircraft) {
+    if (aircraft_ptr == nullptr) {
+        stats_num_aircraft_rejected++;
         CONSOLE_INFO("AIrcraftDictionary::InsertAircraft",
                      "Failed to add aircraft to dictionary, max number of aircraft is %d.", kMaxNumAircraft);
         return false;  // not enough room to add this aircraft
     }
-
-    dict[aircraft.icao_address] = aircraft;  // add the new aircraft to the dictionary
+    *aircraft_ptr = aircraft;  // Overwrites the existing aircraft, if there is one.
+    GetAircraftDetails(*aircraft_ptr) = AircraftDetails();
+    GetCPRPacketPair(*aircraft_ptr) = CPRPacketPair();
+    GetADSBMessageCache(*aircraft_ptr) = ADSBMessageCache();
+    GetPendingADSBMessage(*aircraft_ptr) = PendingADSBMessage();
+
+    // Keep the expiry list sorted. Inserted aircraft are usually the newest, so search backwards from the tail.
+    uint16_t slot = dict.GetSlotIndex(aircraft_ptr);
+    expiry_list_.Remove(slot);
+    uint16_t next_slot = IndexedLinkedList<kMaxNumAircraft>::kInvalidIndex;
+    for (uint16_t prev_slot = expiry_list_.Back(); prev_slot != IndexedLinkedList<kMaxNumAircraft>::kInvalidIndex;
+         prev_slot = expiry_list_.Prev(prev_slot)) {
+        if (static_cast<int32_t>(dict.GetBySlotIndex(prev_slot)->last_message_timestamp_ms -
+                                 aircraft.last_message_timestamp_ms) <= 0) {
+            break;
+        }
+        next_slot = prev_slot;
+    }
+    expiry_list_.InsertBefore(slot, next_slot);
     return true;
 }
 
 bool AircraftDictionary::RemoveAircraft(uint32_t icao_address) {
-    auto itr = dict.find(icao_address);
-    if (itr != dict.end()) {
-        dict.erase(itr);
-        return true;
+    Aircraft *aircraft = dict.Find(icao_address);
+    if (aircraft == nullptr) {
+        return false;  // aircraft not found
     }
-    return false;  // aircraft was not found in the dictionary
+    expiry_list_.Remove(dict.GetSlotIndex(aircraft));
+    return dict.Erase(icao_address);
 }
 
-bool AircraftDictionary::GetAircraft(uint32_t icao_address, Aircraft &aircraft_out) const {
-    auto itr = dict.find(icao_address);
-    if (itr != dict.end()) {
-        aircraft_out = itr->second;
+bool AircraftDictionary::GetAircraft(uint32_t icao_address, Aircraft &aircraft_out) {
+    Aircraft *aircraft = dict.Find(icao_address);
+    if (aircraft != nullptr) {
+        DecodePendingMessages(*aircraft);
+        aircraft_out = *aircraft;
         return true;
     }
     return false;  // aircraft not found
 }
 
-bool AircraftDictionary::ContainsAircraft(uint32_t icao_address) const {
-    auto itr = dict.find(icao_address);
-    if (itr != dict.end()) {
+bool AircraftDictionary::GetAircraftDetails(uint32_t icao_address, AircraftDetails &details_out) {
+    Aircraft *aircraft = dict.Find(icao_address);
+    if (aircraft != nullptr) {
+        DecodePendingMessages(*aircraft);
+        details_out = aircraft_details_[dict.GetSlotIndex(aircraft)];
         return true;
     }
-    return false;
+    return false;  // aircraft not found
+}
+
+bool AircraftDictionary::ContainsAircraft(uint32_t icao_address) const { return dict.Contains(icao_address); }
+
+void AircraftDictionary::DecodePendingMessages() {
+    if (!config_.lazy_decode) {
+        return;  // Messages are decoded during ingestion.
+    }
+    for (Aircraft &aircraft : dict) {
+        DecodePendingMessages(aircraft);
+    }
+}
+
+void AircraftDictionary::DecodePendingMessages(Aircraft &aircraft) {
+    PendingADSBMessage &pending = GetPendingADSBMessage(aircraft);
+    if (!pending.IsPending()) {
+        return;
+    }
+    uint8_t capability = pending.GetCapability();
+    uint64_t me = pending.GetME();
+    // Rebuild the DF=17 packet that the ME field came from, so that it can go through the usual handler.
+    RawTransponderPacket raw_packet;
+    raw_packet.buffer_len_bits = DecodedTransponderPacket::kExtendedSquitterPacketLenBits;
+    raw_packet.frame.message = me;
+    raw_packet.frame.header_and_parity =
+        static_cast<uint64_t>((DecodedTransponderPacket::kDownlinkFormatExtendedSquitter << 27) |
+                              (capability << 24) | aircraft.icao_address)
+        << ModeSFrame::kParityNumBits;
+    raw_packet.frame.header_and_parity |= raw_packet.frame.CalculateCRC24(raw_packet.buffer_len_bits);
+    pending.Clear();
+
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket(raw_packet);
+    ADSBPacket packet = ADSBPacket(tpacket);
+    bool ret = (this->*kADSBMessageHandlers[packet.GetTypeCode()])(aircraft, packet);
+    ADSBMessageCache::MessageClass message_class = ADSBMessageCache::GetMessageClass(packet.GetTypeCode());
+    if (message_class != ADSBMessageCache::kMessageClassNone) {
+        if (ret) {
+            GetADSBMessageCache(aircraft).Store(message_class, capability, me);
+        } else {
+            // Don't skip the next copy of a message that couldn't be decoded.
+            GetADSBMessageCache(aircraft).Invalidate(message_class);
+        }
+    }
 }
 
 Aircraft *AircraftDictionary::GetAircraftPtr(uint32_t icao_address) {
-    auto itr = dict.find(icao_address);
-    if (itr != dict.end()) {
-        return &(itr->second);  // return address of existing aircraft
-    } else if (dict.size() < kMaxNumAircraft) {
-        Aircraft new_aircraft = Aircraft(icao_address);
-        dict[icao_address] = new_aircraft;
-        return &(dict[icao_address]);  // insert new aircraft and return its address
+    bool inserted;
+    Aircraft *aircraft = dict.GetOrInsert(icao_address, inserted);  // Single probe for lookup and insertion.
+    if (aircraft == nullptr) {
+        // Dictionary is full and the aircraft isn't in it.
+        if (!EvictAircraft()) {
+            stats_num_aircraft_rejected++;
+            return nullptr;
+        }
+        aircraft = dict.GetOrInsert(icao_address, inserted);
+    }
+    if (inserted) {
+        // Slot may hold a stale aircraft, reset it.
+        *aircraft = Aircraft(icao_address);
+        GetAircraftDetails(*aircraft) = AircraftDetails();
+        GetCPRPacketPair(*aircraft) = CPRPacketPair();
+        GetADSBMessageCache(*aircraft) = ADSBMessageCache();
+        GetPendingADSBMessage(*aircraft) = PendingADSBMessage();
+        UpdateLastMessageTimestamp(*aircraft);
     }
-    return nullptr;  // can't find the aircraft or insert a new one
+    return aircraft;  // nullptr if the aircraft wasn't found and the dictionary is full
 }
 
 /**
  * Private functions and associated helpers.
  */
 
+void AircraftDictionary::ApplyReplyAltitude(Aircraft &aircraft, int32_t altitude_ft) {
+    if (altitude_ft == kAltitudeDecodeErrorGillhamDecodeError ||
+        altitude_ft == kAltitudeDecodeErrorNotAvailableOrInvalid) {
+        return;  // Don't overwrite a good altitude with an error value.
+    }
+    aircraft.baro_altitude_ft = altitude_ft;
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedBaroAltitude, true);
+}
+
+bool AircraftDictionary::ConfirmCandidateAircraft(uint32_t icao_address) {
+    if (!IsAllocatedICAOAddress(icao_address)) {
+        stats_num_candidates_unallocated++;
+        return false;
+    }
+    if (candidate_table_.RecordSighting(icao_address, get_time_since_boot_ms(), config_.candidate_ttl_ms) <
+        config_.candidate_min_num_sightings) {
+        return false;
+    }
+    candidate_table_.Remove(icao_address);
+    stats_num_candidates_promoted++;
+    return true;
+}
+
+bool AircraftDictionary::EvictAircraft() {
+    const uint16_t kNoSlot = IndexedLinkedList<kMaxNumAircraft>::kInvalidIndex;
+    // Search from the least recently heard from aircraft, so that ties are broken in favor of evicting stale aircraft.
+    uint16_t slot = expiry_list_.Front();
+    uint16_t evict_slot = slot;
+    switch (config_.eviction_policy) {
+        case kEvictionPolicyEvictStalest:
+            for (uint16_t i = 0; i < config_.eviction_search_depth && slot != kNoSlot;
+                 i++, slot = expiry_list_.Next(slot)) {
+                if (!dict.GetBySlotIndex(slot)->HasDecodedPosition()) {
+                    evict_slot = slot;
+                    break;
+                }
+            }
+            break;
+        case kEvictionPolicyEvictLowestFrameRate: {
+            uint16_t evict_slot_without_position = kNoSlot;
+            uint16_t min_frames = UINT16_MAX, min_frames_without_position = UINT16_MAX;
+            for (; slot != kNoSlot; slot = expiry_list_.Next(slot)) {
+                Aircraft *aircraft = dict.GetBySlotIndex(slot);
+                uint16_t frames = aircraft->stats_frames_received_in_last_interval;
+                if (aircraft->HasDecodedPosition()) {
+                    if (frames < min_frames) {
+                        min_frames = frames;
+                        evict_slot = slot;
+                    }
+                } else if (frames < min_frames_without_position) {
+                    min_frames_without_position = frames;
+                    evict_slot_without_position = slot;
+                }
+            }
+            if (evict_slot_without_position != kNoSlot) {
+                evict_slot = evict_slot_without_position;
+            }
+            break;
+        }
+        default:
+            return false;  // kEvictionPolicyRejectNew
+    }
+    if (evict_slot == kNoSlot) {
+        return false;  // Nothing to evict.
+    }
+    RemoveAircraft(dict.GetBySlotIndex(evict_slot)->icao_address);
+    stats_num_aircraft_evicted++;
+    return true;
+}
+
 /**
  * Returns the Wake Vortex value of the aircraft that sent a given ADS-B packet.
  * @param[in] packet ADS-B Packet to extract the AirframeType value from. Must be
@@ -368,8 +885,8 @@ Aircraft *AircraftDictionary::GetAircraftPtr(uint32_t icao_address) {
  * kAirframeTypeInvalid if there is no matching wake vortex value.
  */
 Aircraft::AirframeType ExtractAirframeType(const ADSBPacket &packet) {
-    uint16_t typecode = packet.GetNBitWordFromMessage(5, 0);
-    uint16_t category = packet.GetNBitWordFromMessage(3, 5);
+    uint16_t typecode = packet.GetNBitWordFromMessage<5, 0>();
+    uint16_t category = packet.GetNBitWordFromMessage<3, 5>();
 
     // Table 4.1 from The 1090Mhz Riddle (Junzi Sun), pg. 42.
     if (category == 0) {
@@ -457,66 +974,138 @@ Aircraft::AirframeType ExtractAirframeType(const ADSBPacket &packet) {
     }
 }
 
-bool AircraftDictionary::ApplyAircraftIDMessage(Aircraft &aircraft, ADSBPacket packet) {
+bool AircraftDictionary::ApplyAircraftIDMessage(Aircraft &aircraft, const ADSBPacket &packet) {
+    AircraftDetails &details = GetAircraftDetails(aircraft);
     aircraft.airframe_type = ExtractAirframeType(packet);
-    aircraft.transponder_capability = packet.GetCapability();
+    details.transponder_capability = packet.GetCapability();
+    // ME[9-50] - Callsign characters, 6 bits each. Unpack them all with a single read.
+    const uint16_t kCallsignCharNumBits = 6;
+    uint64_t callsign_chars =
+        packet.GetNBitWord64FromMessage<kCallsignCharNumBits * Aircraft::kCallSignMaxNumChars, 8>();
     for (uint16_t i = 0; i < Aircraft::kCallSignMaxNumChars; i++) {
-        char callsign_char = LookupCallsignChar(packet.GetNBitWordFromMessage(6, 8 + (6 * i)));
-        if (callsign_char == ' ') break;  // ignore trailing spaces
+        char callsign_char = LookupCallsignChar(
+            (callsign_chars >> (kCallsignCharNumBits * (Aircraft::kCallSignMaxNumChars - 1 - i))) & 0b111111);
+        if (callsign_char == ' ') {
+            // Ignore trailing spaces, and clear what's left of a previous, longer callsign.
+            memset(aircraft.callsign + i, '\0', Aircraft::kCallSignMaxNumChars - i);
+            break;
+        }
         aircraft.callsign[i] = callsign_char;
     }
 
     return true;
 }
 
-bool AircraftDictionary::ApplySurfacePositionMessage(Aircraft &aircraft, ADSBPacket packet) {
+bool AircraftDictionary::ApplySurfacePositionMessage(Aircraft &aircraft, const ADSBPacket &packet) {
+    AircraftDetails &details = GetAircraftDetails(aircraft);
     aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne, false);
 
-    if (aircraft.NICBitIsValid(Aircraft::NICBit::kNICBitA) && aircraft.NICBitIsValid(Aircraft::NICBit::kNICBitC)) {
+    if (details.NICBitIsValid(Aircraft::NICBit::kNICBitA) && details.NICBitIsValid(Aircraft::NICBit::kNICBitC)) {
         // Assign NIC based on NIC supplement bits A and C and received TypeCode.
-        switch ((packet.GetTypeCode() << 3) | (aircraft.nic_bits & 0b101)) {
+        switch ((packet.GetTypeCode() << 3) | (details.nic_bits & 0b101)) {
             case (5 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan7p5Meters;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan7p5Meters;
                 break;
             case (6 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan25Meters;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan25Meters;
                 break;
             case (7 << 3) | 0b100:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan75Meters;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan75Meters;
                 break;
             case (7 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p1NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p1NauticalMiles;
                 break;
             case (8 << 3) | 0b101:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p2NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p2NauticalMiles;
                 break;
             case (8 << 3) | 0b100:
                 // Should be <0.3NM, but NIC value is shared with <0.6NM.
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p6NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p6NauticalMiles;
                 break;
             case (8 << 3) | 0b001:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p6NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p6NauticalMiles;
                 break;
             case (8 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCUnknown;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCUnknown;
                 break;
             default:
                 CONSOLE_WARNING("AircraftDictionary::ApplySurfacePositionMessage",
                                 "Unable to assign NIC with typecode %d and nic_bits %d.", packet.GetTypeCode(),
-                                aircraft.nic_bits);
+                                details.nic_bits);
         }
     }
 
-    return false;
+    // ME[5-11] - Movement
+    float ground_speed_kts = SurfaceMovementToGroundSpeedKts(packet.GetNBitWordFromMessage<7, 5>());
+    if (ground_speed_kts == kSurfaceMovementNotAvailable) {
+        aircraft.velocity_source = Aircraft::VelocitySource::kVelocitySourceNotAvailable;
+    } else {
+        aircraft.velocity_source = Aircraft::VelocitySource::kVelocitySourceGroundSpeed;
+        aircraft.velocity_kts = ground_speed_kts;
+        aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedHorizontalVelocity, true);
+        details.last_adsb_velocity_timestamp_ms = get_time_since_boot_ms();
+    }
+
+    // ME[12] - Ground Track Status, ME[13-19] - Ground Track
+    if (packet.GetNBitWordFromMessage<1, 12>()) {
+        aircraft.track_deg = packet.GetNBitWordFromMessage<7, 13>() * (360.0f / 128.0f);
+        aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedTrack, true);
+    }
+
+    // ME[20] - Time (T) flag, set if the position was measured on a UTC-synchronized epoch. Ignored, since positions
+    // are timestamped when they're received.
+
+    // ME[21] - CPR Format
+    bool odd = packet.GetNBitWordFromMessage<1, 21>();
+
+    // ME[22-55] - CPR Latitude and Longitude
+    CPRPacketPair &cpr_packets = GetCPRPacketPair(aircraft);
+    cpr_packets.SetCPRLatLon(packet.GetNBitWordFromMessage<17, 22>(), packet.GetNBitWordFromMessage<17, 39>(), odd,
+                             true);
+    return DecodeCPRPosition(aircraft, cpr_packets, true);
+}
+
+bool AircraftDictionary::DecodeCPRPosition(Aircraft &aircraft, CPRPacketPair &cpr_packets, bool surface) {
+    // Prefer a local decode against the aircraft's last known position, since it only needs a single packet. Global
+    // decoding with an odd / even pair is used to bootstrap airborne positions, falling back to a local decode against
+    // the receiver position if a pair isn't available yet. Surface positions can't be decoded globally, so they
+    // always use the aircraft's last (airborne or surface) position or the receiver position as a reference. Taxiing
+    // aircraft are slow, so their last position stays usable as a reference for longer.
+    bool position_decoded = false;
+    if (aircraft.HasRecentPosition(surface ? Aircraft::kCPRSurfaceLocalDecodeMaxAgeMs
+                                           : Aircraft::kCPRLocalDecodeMaxAgeMs)) {
+        position_decoded =
+            aircraft.DecodePositionLocal(cpr_packets, aircraft.latitude_deg_e7, aircraft.longitude_deg_e7);
+    } else if (cpr_packets.CanDecodePosition()) {
+        position_decoded = aircraft.DecodePosition(cpr_packets);
+    } else if (config_.receiver_position_valid) {
+        position_decoded = aircraft.DecodePositionLocal(cpr_packets, config_.receiver_latitude_deg_e7,
+                                                        config_.receiver_longitude_deg_e7);
+    } else {
+        if (surface) {
+            // Surface positions don't get any more decodable with more packets, only a reference position helps.
+            stats_num_surface_positions_undecodable++;
+        }
+        return true;  // Not enough information to attempt a decode yet.
+    }
+
+    if (!position_decoded) {
+        CONSOLE_WARNING("AircraftDictionary::DecodeCPRPosition", "Position decode failed for aircraft 0x%lx.\r\n",
+                        aircraft.icao_address);
+        return false;
+    }
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition, true);
+    return true;
 }
 
-bool AircraftDictionary::ApplyAirbornePositionMessage(Aircraft &aircraft, ADSBPacket packet) {
+bool AircraftDictionary::ApplyAirbornePositionMessage(Aircraft &aircraft, const ADSBPacket &packet) {
+    AircraftDetails &details = GetAircraftDetails(aircraft);
     aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne, true);
     uint16_t typecode = packet.GetTypeCode();
 
     bool decode_successful = true;
     // ME[5-6] - Surveillance Status
-    uint8_t surveillance_status = packet.GetNBitWordFromMessage(2, 5);
+    uint8_t surveillance_status = packet.GetNBitWordFromMessage<2, 5>();
     switch (surveillance_status) {
         case 0:  // No condition.
             aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagAlert, false);
@@ -535,66 +1124,66 @@ bool AircraftDictionary::ApplyAirbornePositionMessage(Aircraft &aircraft, ADSBPa
     }
 
     // ME[7] - NIC B Supplement (Formerly Single Antenna Flag)
-    aircraft.WriteNICBit(Aircraft::NICBit::kNICBitB, packet.GetNBitWordFromMessage(1, 7));
+    details.WriteNICBit(Aircraft::NICBit::kNICBitB, packet.GetNBitWordFromMessage<1, 7>());
 
-    if (aircraft.NICBitIsValid(Aircraft::NICBit::kNICBitA) && aircraft.NICBitIsValid(Aircraft::NICBit::kNICBitB)) {
+    if (details.NICBitIsValid(Aircraft::NICBit::kNICBitA) && details.NICBitIsValid(Aircraft::NICBit::kNICBitB)) {
         // Assign NIC based on NIC supplement bits A and B and received TypeCode.
-        switch ((typecode << 3) | (aircraft.nic_bits & 0b101)) {
+        switch ((typecode << 3) | (details.nic_bits & 0b101)) {
             case (9 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan7p5Meters;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan7p5Meters;
                 break;
             case (10 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan25Meters;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan25Meters;
                 break;
             case (11 << 3) | 0b110:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan75Meters;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan75Meters;
                 break;
             case (11 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p1NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p1NauticalMiles;
                 break;
             case (12 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p2NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p2NauticalMiles;
                 break;
             case (13 << 3) | 0b010:  // Should be <0.3NM, but NIC value is shared with <0.6NM.
             case (13 << 3) | 0b000:  // Should be <0.5NM, but NIC value is shared with <0.6NM.
             case (13 << 3) | 0b110:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p6NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan0p6NauticalMiles;
                 break;
             case (14 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan1NauticalMile;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan1NauticalMile;
                 break;
             case (15 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan2NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan2NauticalMiles;
                 break;
             case (16 << 3) | 0b110:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan4NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan4NauticalMiles;
                 break;
             case (16 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan8NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan8NauticalMiles;
                 break;
             case (17 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan20NauticalMiles;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan20NauticalMiles;
                 break;
             case (18 << 3) | 0b000:
-                aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCUnknown;
+                details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCUnknown;
                 break;
             default:
                 // Check for TypeCodes that can determine a NIC without needing to consult NIC supplement bits.
                 switch (typecode) {
                     case 20:
-                        aircraft.navigation_integrity_category =
+                        details.navigation_integrity_category =
                             Aircraft::NICRadiusOfContainment::kROCLessThan7p5Meters;
                         break;
                     case 21:
-                        aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan25Meters;
+                        details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCLessThan25Meters;
                         break;
                     case 22:
-                        aircraft.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCUnknown;
+                        details.navigation_integrity_category = Aircraft::NICRadiusOfContainment::kROCUnknown;
                         break;
                     default:
                         CONSOLE_WARNING("AircraftDictionary::ApplyAirbornePositionMessage",
                                         "Unable to assign NIC with typecode %d and nic_bits %d.", typecode,
-                                        aircraft.nic_bits);
+                                        details.nic_bits);
                 }
         }
     }
@@ -602,27 +1191,32 @@ bool AircraftDictionary::ApplyAirbornePositionMessage(Aircraft &aircraft, ADSBPa
     // ME[8-19] - Encoded Altitude
     switch (packet.GetTypeCodeEnum()) {
         case ADSBPacket::TypeCode::kTypeCodeAirbornePositionBaroAlt: {
-            uint16_t encoded_altitude_ft_with_q_bit = static_cast<uint16_t>(packet.GetNBitWordFromMessage(12, 8));
-            if (encoded_altitude_ft_with_q_bit == 0) {
+            uint16_t encoded_altitude = static_cast<uint16_t>(packet.GetNBitWordFromMessage<12, 8>());
+            // The encoded altitude is a Mode C altitude code without the M bit, which is always 0 (feet) in ADS-B.
+            // Reinsert it so that both 25ft increment (Q=1) and Gillham coded (Q=0, above 50175ft) altitudes can be
+            // looked up in the Mode C altitude table.
+            int32_t baro_altitude_ft =
+                AltitudeCodeToAltitudeFt(((encoded_altitude & 0b111111000000) << 1) | (encoded_altitude & 0b111111));
+            if (encoded_altitude == 0) {
                 aircraft.altitude_source = Aircraft::AltitudeSource::kAltitudeNotAvailable;
                 CONSOLE_WARNING("AIrcraftDictionary::ApplyAirbornePositionMessage",
                                 "Altitude information not available for aircraft 0x%lx.", aircraft.icao_address);
                 decode_successful = false;
+            } else if (baro_altitude_ft == kAltitudeDecodeErrorGillhamDecodeError) {
+                CONSOLE_WARNING("AIrcraftDictionary::ApplyAirbornePositionMessage",
+                                "Invalid Gillham coded altitude 0x%x for aircraft 0x%lx.", encoded_altitude,
+                                aircraft.icao_address);
+                decode_successful = false;
             } else {
                 aircraft.altitude_source = Aircraft::AltitudeSource::kAltitudeSourceBaro;
-                bool q_bit = (encoded_altitude_ft_with_q_bit & (0b000000010000)) ? true : false;
-                // Remove Q bit.
-                uint16_t encoded_altitude_ft = ((encoded_altitude_ft_with_q_bit & 0b111111100000) >> 1) |
-                                               (encoded_altitude_ft_with_q_bit & 0b1111);
-                aircraft.baro_altitude_ft = q_bit ? (encoded_altitude_ft * 25) - 1000 : 25 * encoded_altitude_ft;
-                // FIXME: Does not currently support baro altitudes above 50175ft. Something about grey codes?
+                aircraft.baro_altitude_ft = baro_altitude_ft;
                 aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedBaroAltitude, true);
             }
             break;
         }
         case ADSBPacket::TypeCode::kTypeCodeAirbornePositionGNSSAlt: {
             aircraft.altitude_source = Aircraft::AltitudeSource::kAltitudeSourceGNSS;
-            uint16_t gnss_altitude_m = static_cast<uint16_t>(packet.GetNBitWordFromMessage(12, 8));
+            uint16_t gnss_altitude_m = static_cast<uint16_t>(packet.GetNBitWordFromMessage<12, 8>());
             aircraft.gnss_altitude_ft = MetersToFeet(gnss_altitude_m);
             aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedGNSSAltitude, true);
             break;
@@ -637,35 +1231,23 @@ bool AircraftDictionary::ApplyAirbornePositionMessage(Aircraft &aircraft, ADSBPa
     // TODO: figure out if we need this
 
     // ME[21] - CPR Format
-    bool odd = packet.GetNBitWordFromMessage(1, 21);
+    bool odd = packet.GetNBitWordFromMessage<1, 21>();
 
     // ME[32-?]
-    aircraft.SetCPRLatLon(packet.GetNBitWordFromMessage(17, 22), packet.GetNBitWordFromMessage(17, 39), odd);
-    if (aircraft.CanDecodePosition()) {
-        if (!aircraft.DecodePosition()) {
-            CONSOLE_WARNING("ApplyAirbornePositionMessage", "DecodePosition failed for aircraft 0x%lx.\r\n",
-                            aircraft.icao_address);
-            decode_successful = false;
-        } else {
-            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition, true);
-        }
-    }
+    CPRPacketPair &cpr_packets = GetCPRPacketPair(aircraft);
+    cpr_packets.SetCPRLatLon(packet.GetNBitWordFromMessage<17, 22>(), packet.GetNBitWordFromMessage<17, 39>(), odd);
+    decode_successful &= DecodeCPRPosition(aircraft, cpr_packets, false);
 
     return decode_successful;
 }
 
-inline float wrapped_atan2f(float y, float x) {
-    float val = atan2f(y, x);
-    return val < 0.0f ? (val + (2.0f * M_PI)) : val;
-}
-
-bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSBPacket packet) {
+bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, const ADSBPacket &packet) {
     aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne, true);
     bool decode_successful = true;
 
     // Decode horizontal velocity.
     ADSBPacket::AirborneVelocitiesSubtype subtype =
-        static_cast<ADSBPacket::AirborneVelocitiesSubtype>(packet.GetNBitWordFromMessage(3, 5));
+        static_cast<ADSBPacket::AirborneVelocitiesSubtype>(packet.GetNBitWordFromMessage<3, 5>());
     bool is_supersonic = false;
     switch (subtype) {
         case ADSBPacket::AirborneVelocitiesSubtype::kAirborneVelocitiesGroundSpeedSupersonic:
@@ -673,8 +1255,8 @@ bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSB
             // Cascade into ground speed calculation.
         case ADSBPacket::AirborneVelocitiesSubtype::kAirborneVelocitiesGroundSpeedSubsonic: {
             // Ground speed calculation.
-            int v_ew_kts_plus_1 = static_cast<int>(packet.GetNBitWordFromMessage(10, 14));
-            int v_ns_kts_plus_1 = static_cast<int>(packet.GetNBitWordFromMessage(10, 25));
+            int v_ew_kts_plus_1 = static_cast<int>(packet.GetNBitWordFromMessage<10, 14>());
+            int v_ns_kts_plus_1 = static_cast<int>(packet.GetNBitWordFromMessage<10, 25>());
             if (v_ew_kts_plus_1 == 0 || v_ns_kts_plus_1 == 0) {
                 aircraft.velocity_source = Aircraft::VelocitySource::kVelocitySourceNotAvailable;
                 CONSOLE_WARNING("AircraftDictionary::ApplyAirborneVelocitiesMessage",
@@ -682,16 +1264,19 @@ bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSB
                 decode_successful = false;
             } else {
                 aircraft.velocity_source = Aircraft::VelocitySource::kVelocitySourceGroundSpeed;
-                bool direction_is_east_to_west = static_cast<bool>(packet.GetNBitWordFromMessage(1, 13));
+                bool direction_is_east_to_west = static_cast<bool>(packet.GetNBitWordFromMessage<1, 13>());
                 int v_x_kts = (v_ew_kts_plus_1 - 1) * (direction_is_east_to_west ? -1 : 1);
-                bool direction_is_north_to_south = static_cast<bool>(packet.GetNBitWordFromMessage(1, 24));
+                bool direction_is_north_to_south = static_cast<bool>(packet.GetNBitWordFromMessage<1, 24>());
                 int v_y_kts = (v_ns_kts_plus_1 - 1) * (direction_is_north_to_south ? -1 : 1);
                 if (is_supersonic) {
                     v_x_kts *= 4;
                     v_y_kts *= 4;
                 }
-                aircraft.velocity_kts = sqrtf(v_x_kts * v_x_kts + v_y_kts * v_y_kts);
-                aircraft.track_deg = wrapped_atan2f(v_x_kts, v_y_kts) * kRadiansToDegrees;
+                uint32_t ground_speed_kts_e3;
+                uint32_t track_bam;
+                CalcGroundSpeedAndTrack(v_x_kts, v_y_kts, ground_speed_kts_e3, track_bam);
+                aircraft.velocity_kts = ground_speed_kts_e3 * 0.001f;
+                aircraft.track_deg = track_bam * kDegreesPerBAM;
             }
             break;
         }
@@ -700,18 +1285,18 @@ bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSB
             // Cascade into airspeed calculation.
         }
         case ADSBPacket::AirborneVelocitiesSubtype::kAirborneVelocitiesAirspeedSubsonic: {
-            int airspeed_kts_plus_1 = static_cast<int>(packet.GetNBitWordFromMessage(10, 25));
+            int airspeed_kts_plus_1 = static_cast<int>(packet.GetNBitWordFromMessage<10, 25>());
             if (airspeed_kts_plus_1 == 0) {
                 CONSOLE_WARNING("AircraftDictionary::ApplyAirborneVelocitiesMessage",
                                 "Airspeed not available for aircraft 0x%lx.", aircraft.icao_address);
                 decode_successful = false;
             } else {
                 aircraft.velocity_kts = (airspeed_kts_plus_1 - 1) * (is_supersonic ? 4 : 1);
-                bool is_true_airspeed = static_cast<bool>(packet.GetNBitWordFromMessage(1, 24));
+                bool is_true_airspeed = static_cast<bool>(packet.GetNBitWordFromMessage<1, 24>());
                 aircraft.velocity_source = is_true_airspeed
                                                ? Aircraft::VelocitySource::kVelocitySourceAirspeedTrue
                                                : Aircraft::VelocitySource::kVelocitySourceAirspeedIndicated;
-                aircraft.track_deg = static_cast<float>((packet.GetNBitWordFromMessage(10, 14) * 360) / 1024.0f);
+                aircraft.track_deg = static_cast<float>((packet.GetNBitWordFromMessage<10, 14>() * 360) / 1024.0f);
             }
 
             break;
@@ -724,17 +1309,21 @@ bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSB
     }
     aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedTrack, true);
     aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagUpdatedHorizontalVelocity, true);
+    if (decode_successful) {
+        GetAircraftDetails(aircraft).last_adsb_velocity_timestamp_ms = get_time_since_boot_ms();
+    }
 
     // Decode vertical rate.
-    int vertical_rate_magnitude_fpm = packet.GetNBitWordFromMessage(9, 37);
+    int vertical_rate_magnitude_fpm = packet.GetNBitWordFromMessage<9, 37>();
     if (vertical_rate_magnitude_fpm == 0) {
         aircraft.vertical_rate_source = Aircraft::VerticalRateSource::kVerticalRateNotAvailable;
         CONSOLE_WARNING("AircraftDictionary::ApplyAirborneVelocitiesMessage",
                         "Vertical rate not available for aircraft 0x%lx.", aircraft.icao_address);
         decode_successful = false;
     } else {
-        aircraft.vertical_rate_source = static_cast<Aircraft::VerticalRateSource>(packet.GetNBitWordFromMessage(1, 35));
-        bool vertical_rate_sign_is_negative = packet.GetNBitWordFromMessage(1, 36);
+        aircraft.vertical_rate_source =
+            static_cast<Aircraft::VerticalRateSource>(packet.GetNBitWordFromMessage<1, 35>());
+        bool vertical_rate_sign_is_negative = packet.GetNBitWordFromMessage<1, 36>();
         if (vertical_rate_sign_is_negative) {
             aircraft.vertical_rate_fpm = -(vertical_rate_magnitude_fpm - 1) * 64;
         } else {
@@ -744,8 +1333,8 @@ bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSB
     }
 
     // Decode altitude difference between GNSS and barometric altitude.
-    bool gnss_alt_below_baro_alt = static_cast<bool>(packet.GetNBitWordFromMessage(1, 48));
-    uint16_t encoded_gnss_alt_baro_alt_difference_ft = static_cast<uint16_t>(packet.GetNBitWordFromMessage(7, 49));
+    bool gnss_alt_below_baro_alt = static_cast<bool>(packet.GetNBitWordFromMessage<1, 48>());
+    uint16_t encoded_gnss_alt_baro_alt_difference_ft = static_cast<uint16_t>(packet.GetNBitWordFromMessage<7, 49>());
     if (encoded_gnss_alt_baro_alt_difference_ft == 0) {
         CONSOLE_WARNING("AircraftDictionary::ApplyAirborneVelocitiesMessage",
                         "Difference between GNSS and baro altitude not available for aircraft 0x%lx.",
@@ -772,52 +1361,132 @@ bool AircraftDictionary::ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSB
     return decode_successful;
 }
 
-bool AircraftDictionary::ApplyAircraftStatusMessage(Aircraft &aircraft, ADSBPacket packet) { return false; }
+bool AircraftDictionary::ApplyAircraftStatusMessage(Aircraft &aircraft, const ADSBPacket &packet) {
+    // ME[5-7] - Subtype Code
+    switch (packet.GetNBitWordFromMessage<3, 5>()) {
+        case ADSBPacket::AircraftStatusSubtype::kAircraftStatusSubtypeEmergencyPriorityStatus:  // ST = 1
+        {
+            // ME[8-10] - Emergency / Priority Status
+            aircraft.emergency_state = static_cast<Aircraft::EmergencyState>(packet.GetNBitWordFromMessage<3, 8>());
+            // ME[11-23] - Mode A Code
+            aircraft.squawk = IdentityCodeToSquawk(packet.GetNBitWordFromMessage<13, 11>());
+            return true;
+        }
+        case ADSBPacket::AircraftStatusSubtype::kAircraftStatusSubtypeACASRABroadcast:  // ST = 2
+        {
+            AircraftDetails &details = GetAircraftDetails(aircraft);
+            // ME[8-21] - Active Resolution Advisories (ARA)
+            details.acas_active_resolution_advisories = packet.GetNBitWordFromMessage<14, 8>();
+            // ME[22-25] - RA Complements (RAC)
+            details.acas_resolution_advisory_complements = packet.GetNBitWordFromMessage<4, 22>();
+            // ME[26] - RA Terminated (RAT)
+            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagTCASRA, !packet.GetNBitWordFromMessage<1, 26>());
+            // ME[27] - Multiple Threat Encounter (MTE) - Ignored
+            // ME[28-55] - Threat Type Indicator (TTI) and Threat Identity Data (TID) - Ignored
+            return true;
+        }
+        default:
+            return false;  // No information, or reserved subtype.
+    }
+}
 
-bool AircraftDictionary::ApplyTargetStateAndStatusInfoMessage(Aircraft &aircraft, ADSBPacket packet) { return false; }
+bool AircraftDictionary::ApplyTargetStateAndStatusInfoMessage(Aircraft &aircraft, const ADSBPacket &packet) {
+    // ME[5-6] - Subtype Code
+    if (packet.GetNBitWordFromMessage<2, 5>() != ADSBPacket::kTargetStateAndStatusSubtypeVersion2) {
+        return false;
+    }
+    AircraftDetails &details = GetAircraftDetails(aircraft);
+
+    // ME[8] - Selected Altitude Type (MCP / FCU or FMS) - Ignored
+    // ME[9-19] - Selected Altitude
+    uint16_t selected_altitude = packet.GetNBitWordFromMessage<11, 9>();
+    if (selected_altitude != 0) {  // 0 = No data.
+        details.selected_altitude_ft = (selected_altitude - 1) * 32;
+        aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagSelectedAltitudeValid, true);
+    }
+    // ME[20-28] - Barometric Pressure Setting (minus 800mb, 0.8mb increments)
+    uint16_t baro_pressure_setting = packet.GetNBitWordFromMessage<9, 20>();
+    if (baro_pressure_setting != 0) {  // 0 = No data.
+        details.baro_pressure_setting_mb_e1 = 8000 + (baro_pressure_setting - 1) * 8;
+    }
+    // ME[29] - Selected Heading Status
+    // ME[30-38] - Selected Heading
+    if (packet.GetNBitWordFromMessage<1, 29>()) {
+        details.selected_heading_deg = packet.GetNBitWordFromMessage<9, 30>() * (180.0f / 256.0f);
+        aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagSelectedHeadingValid, true);
+    }
+
+    // ME[39-42] - Navigational Accuracy Category, Position
+    details.navigation_accuracy_category_position =
+        static_cast<Aircraft::NACEstimatedPositionUncertainty>(packet.GetNBitWordFromMessage<4, 39>());
+    // ME[43] - NIC Baro
+    details.navigation_integrity_category_baro =
+        static_cast<Aircraft::NICBarometricAltitudeIntegrity>(packet.GetNBitWordFromMessage<1, 43>());
+    // ME[7] - SIL Supplement
+    // ME[44-45] - Source Integrity Level (SIL)
+    details.source_integrity_level = static_cast<Aircraft::SILProbabilityOfExceedingNICRadiusOfContainmnent>(
+        (packet.GetNBitWordFromMessage<1, 7>() << 2) | packet.GetNBitWordFromMessage<2, 44>());
+
+    // ME[46] - Status of MCP / FCU Mode Bits
+    if (packet.GetNBitWordFromMessage<1, 46>()) {
+        // ME[47] - Autopilot Engaged, ME[48] - VNAV Mode Engaged, ME[49] - Altitude Hold Mode
+        // ME[51] - Approach Mode, ME[53] - LNAV Mode Engaged
+        details.autopilot_modes = (0b1 << Aircraft::AutopilotModeBit::kAutopilotModeBitValid) |
+                                  (packet.GetNBitWordFromMessage<1, 47>() << Aircraft::kAutopilotModeBitEngaged) |
+                                  (packet.GetNBitWordFromMessage<1, 48>() << Aircraft::kAutopilotModeBitVNAV) |
+                                  (packet.GetNBitWordFromMessage<1, 49>() << Aircraft::kAutopilotModeBitAltitudeHold) |
+                                  (packet.GetNBitWordFromMessage<1, 51>() << Aircraft::kAutopilotModeBitApproach) |
+                                  (packet.GetNBitWordFromMessage<1, 53>() << Aircraft::kAutopilotModeBitLNAV);
+    }
+    // ME[50] - Reserved for ADS-R Flag - Ignored
+    // ME[52] - TCAS Operational
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagTCASOperational, packet.GetNBitWordFromMessage<1, 52>());
+    return true;
+}
 
-bool AircraftDictionary::ApplyAircraftOperationStatusMessage(Aircraft &aircraft, ADSBPacket packet) {
+bool AircraftDictionary::ApplyAircraftOperationStatusMessage(Aircraft &aircraft, const ADSBPacket &packet) {
+    AircraftDetails &details = GetAircraftDetails(aircraft);
     // TODO: get nac/navigation_integrity_category, and supplement airborne status from here.
     // https://mode-s.org/decode/content/ads-b/6-operation-status.html
     // More about navigation_integrity_category/nac here: https://mode-s.org/decode/content/ads-b/7-uncertainty.html
 
     // ME[5-7] - Subtype Code
     ADSBPacket::OperationStatusSubtype subtype =
-        static_cast<ADSBPacket::OperationStatusSubtype>(packet.GetNBitWordFromMessage(3, 5));
+        static_cast<ADSBPacket::OperationStatusSubtype>(packet.GetNBitWordFromMessage<3, 5>());
 
     // ME[8-23] - Airborne or Surface Capacity Class Code
     // ME[11] - 1090ES In
-    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHas1090ESIn, packet.GetNBitWordFromMessage(1, 11));
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHas1090ESIn, packet.GetNBitWordFromMessage<1, 11>());
     // Other fields handled in switch statement.
 
     // ME[24-39] - Operational Mode Code
     // ME[26] - TCAS RA Active
-    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagTCASRA, packet.GetNBitWordFromMessage(1, 26));
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagTCASRA, packet.GetNBitWordFromMessage<1, 26>());
     // ME[27] - IDENT Switch Active
-    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagIdent, packet.GetNBitWordFromMessage(1, 27));
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagIdent, packet.GetNBitWordFromMessage<1, 27>());
     // ME[29] - Single Antenna Flag
-    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagSingleAntenna, packet.GetNBitWordFromMessage(1, 29));
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagSingleAntenna, packet.GetNBitWordFromMessage<1, 29>());
     // ME[30-31] - System Design Assurance
-    aircraft.system_design_assurance =
-        static_cast<Aircraft::SystemDesignAssurance>(packet.GetNBitWordFromMessage(2, 30));
+    details.system_design_assurance =
+        static_cast<Aircraft::SystemDesignAssurance>(packet.GetNBitWordFromMessage<2, 30>());
 
     // ME[40-42] - ADS-B Version Number
-    aircraft.adsb_version = packet.GetNBitWordFromMessage(3, 40);
+    details.adsb_version = packet.GetNBitWordFromMessage<3, 40>();
 
     // ME[43] - NIC Supplement A
-    aircraft.WriteNICBit(Aircraft::NICBit::kNICBitC, packet.GetNBitWordFromMessage(1, 43));
+    details.WriteNICBit(Aircraft::NICBit::kNICBitC, packet.GetNBitWordFromMessage<1, 43>());
 
     // ME[44-47] - Navigational Accuracy Category, Position
-    aircraft.navigation_accuracy_category_position =
-        static_cast<Aircraft::NACEstimatedPositionUncertainty>(packet.GetNBitWordFromMessage(4, 44));
+    details.navigation_accuracy_category_position =
+        static_cast<Aircraft::NACEstimatedPositionUncertainty>(packet.GetNBitWordFromMessage<4, 44>());
 
     // ME[50-51] - Source Integrity Level (SIL)
-    uint8_t source_integrity_level = packet.GetNBitWordFromMessage(2, 50);
+    uint8_t source_integrity_level = packet.GetNBitWordFromMessage<2, 50>();
     // ME[53] - Horizontal Reference Direction (HRD)
-    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHeadingUsesMagneticNorth, packet.GetNBitWordFromMessage(1, 53));
+    aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHeadingUsesMagneticNorth, packet.GetNBitWordFromMessage<1, 53>());
     // ME[54] - SIL Supplement
-    uint8_t sil_supplement = packet.GetNBitWordFromMessage(1, 54);
-    aircraft.source_integrity_level = static_cast<Aircraft::SILProbabilityOfExceedingNICRadiusOfContainmnent>(
+    uint8_t sil_supplement = packet.GetNBitWordFromMessage<1, 54>();
+    details.source_integrity_level = static_cast<Aircraft::SILProbabilityOfExceedingNICRadiusOfContainmnent>(
         (sil_supplement << 2) | source_integrity_level);
 
     // Conditional fields (meaning depends on subtype).
@@ -825,20 +1494,20 @@ bool AircraftDictionary::ApplyAircraftOperationStatusMessage(Aircraft &aircraft,
         case ADSBPacket::OperationStatusSubtype::kOperationStatusSubtypeAirborne:  // ST = 0
         {
             // ME[10] - TCAS Operational
-            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagTCASOperational, packet.GetNBitWordFromMessage(1, 10));
+            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagTCASOperational, packet.GetNBitWordFromMessage<1, 10>());
 
             // ME[14] - Air Referenced Velocity (ARV) Report Capability - Ignored
             // ME[15] - Target State (TS) Report Capability - Ignored
             // ME[16-17] - Trajectory Change (TC) Report Capability - Ignored
             // ME[18] - UAT In
-            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHasUATIn, packet.GetNBitWordFromMessage(1, 18));
+            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHasUATIn, packet.GetNBitWordFromMessage<1, 18>());
 
             // ME[48-49] - GVA
-            aircraft.geometric_vertical_accuracy = static_cast<Aircraft::GVA>(packet.GetNBitWordFromMessage(2, 48));
+            details.geometric_vertical_accuracy = static_cast<Aircraft::GVA>(packet.GetNBitWordFromMessage<2, 48>());
 
             // ME[52] - NIC Baro
-            aircraft.navigation_integrity_category_baro =
-                static_cast<Aircraft::NICBarometricAltitudeIntegrity>(packet.GetNBitWordFromMessage(1, 52));
+            details.navigation_integrity_category_baro =
+                static_cast<Aircraft::NICBarometricAltitudeIntegrity>(packet.GetNBitWordFromMessage<1, 52>());
 
             break;
         }
@@ -846,114 +1515,114 @@ bool AircraftDictionary::ApplyAircraftOperationStatusMessage(Aircraft &aircraft,
         {
             // ME[14] - B2 Low
             aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagIsClassB2GroundVehicle,
-                                  packet.GetNBitWordFromMessage(1, 14));
+                                  packet.GetNBitWordFromMessage<1, 14>());
             // ME[15] - UAT In
-            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHasUATIn, packet.GetNBitWordFromMessage(1, 15));
+            aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagHasUATIn, packet.GetNBitWordFromMessage<1, 15>());
             // ME[16-18] - NACv
-            aircraft.navigation_accuracy_category_velocity =
-                static_cast<Aircraft::NACHorizontalVelocityError>(packet.GetNBitWordFromMessage(3, 16));
+            details.navigation_accuracy_category_velocity =
+                static_cast<Aircraft::NACHorizontalVelocityError>(packet.GetNBitWordFromMessage<3, 16>());
             // ME[19] - NIC Supplement C
-            aircraft.WriteNICBit(Aircraft::NICBit::kNICBitC, packet.GetNBitWordFromMessage(1, 19));
+            details.WriteNICBit(Aircraft::NICBit::kNICBitC, packet.GetNBitWordFromMessage<1, 19>());
 
             // ME[20-23] Aircraft/Vehicle Length and Width Code
-            switch (packet.GetNBitWordFromMessage(4, 20)) {
+            switch (packet.GetNBitWordFromMessage<4, 20>()) {
                 case 0:
-                    aircraft.length_m = 0;
-                    aircraft.width_m = 0;
+                    details.length_m = 0;
+                    details.width_m = 0;
                     break;
                 case 1:
-                    aircraft.length_m = 15;
-                    aircraft.width_m = 23;
+                    details.length_m = 15;
+                    details.width_m = 23;
                     break;
                 case 2:
-                    aircraft.length_m = 25;
-                    aircraft.width_m = 29;  // Rounded up from 28.5.
+                    details.length_m = 25;
+                    details.width_m = 29;  // Rounded up from 28.5.
                     break;
                 case 3:
-                    aircraft.length_m = 25;
-                    aircraft.width_m = 34;
+                    details.length_m = 25;
+                    details.width_m = 34;
                     break;
                 case 4:
-                    aircraft.length_m = 35;
-                    aircraft.width_m = 33;
+                    details.length_m = 35;
+                    details.width_m = 33;
                     break;
                 case 5:
-                    aircraft.length_m = 35;
-                    aircraft.width_m = 38;
+                    details.length_m = 35;
+                    details.width_m = 38;
                     break;
                 case 6:
-                    aircraft.length_m = 45;
-                    aircraft.width_m = 40;  // Rounded up from 39.5.
+                    details.length_m = 45;
+                    details.width_m = 40;  // Rounded up from 39.5.
                     break;
                 case 7:
-                    aircraft.length_m = 45;
-                    aircraft.width_m = 45;
+                    details.length_m = 45;
+                    details.width_m = 45;
                     break;
                 case 8:
-                    aircraft.length_m = 55;
-                    aircraft.width_m = 45;
+                    details.length_m = 55;
+                    details.width_m = 45;
                     break;
                 case 9:
-                    aircraft.length_m = 55;
-                    aircraft.width_m = 52;
+                    details.length_m = 55;
+                    details.width_m = 52;
                     break;
                 case 10:
-                    aircraft.length_m = 65;
-                    aircraft.width_m = 60;  // Rounded up from 59.5.
+                    details.length_m = 65;
+                    details.width_m = 60;  // Rounded up from 59.5.
                     break;
                 case 11:
-                    aircraft.length_m = 65;
-                    aircraft.width_m = 67;
+                    details.length_m = 65;
+                    details.width_m = 67;
                     break;
                 case 12:
-                    aircraft.length_m = 75;
-                    aircraft.width_m = 73;  // Rounded up from 72.5.
+                    details.length_m = 75;
+                    details.width_m = 73;  // Rounded up from 72.5.
                     break;
                 case 13:
-                    aircraft.length_m = 75;
-                    aircraft.width_m = 80;
+                    details.length_m = 75;
+                    details.width_m = 80;
                     break;
                 case 14:
-                    aircraft.length_m = 85;
-                    aircraft.width_m = 80;
+                    details.length_m = 85;
+                    details.width_m = 80;
                     break;
                 case 15:
-                    aircraft.length_m = 85;
-                    aircraft.width_m = 90;
+                    details.length_m = 85;
+                    details.width_m = 90;
                     break;
             }
 
             // ME[32-39] - GPS Antenna Offset
             // Only present in surface position operation status packets.
-            switch (packet.GetNBitWordFromMessage(8, 32)) {
+            switch (packet.GetNBitWordFromMessage<8, 32>()) {
                 case 0b000:  // No data.
                     break;
                 case 0b001:  // 2 meters left of roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = -2;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = -2;
                     break;
                 case 0b010:  // 4 meters left of roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = -4;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = -4;
                     break;
                 case 0b011:  // 6 meters left of roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = -6;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = -6;
                     break;
                 case 0b100:  // Centered on roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = 0;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = 0;
                     break;
                 case 0b101:  // 2 meters right of roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = 2;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = 2;
                     break;
                 case 0b110:  // 4 meters right of roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = 4;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = 4;
                     break;
                 case 0b111:  // 6 meters right of roll axis.
-                    aircraft.gnss_antenna_offset_right_of_roll_axis_m = 6;
+                    details.gnss_antenna_offset_right_of_roll_axis_m = 6;
                     break;
             }
 
             // ME[52] Track Angle / Heading for Surface Position Messages
             aircraft.WriteBitFlag(Aircraft::BitFlag::kBitFlagSurfacePositionUsesHeading,
-                                  packet.GetNBitWordFromMessage(1, 52));
+                                  packet.GetNBitWordFromMessage<1, 52>());
 
             break;
         }
@@ -2,15 +2,204 @@
 #define _AIRCRAFT_DICTIONARY_HH_
 
 #include <cstring>
-#include <unordered_map>
 
+#include "data_structures.hh"
+#include "hal.hh"
 #include "transponder_packet.hh"
 
+// Max number of aircraft that can be tracked by the AircraftDictionary. Storage is statically allocated, so this trades
+// RAM for capacity. Override at build time for receivers near busy airports, e.g.
+// add_compile_definitions(AIRCRAFT_DICTIONARY_MAX_NUM_AIRCRAFT=1000).
+#ifndef AIRCRAFT_DICTIONARY_MAX_NUM_AIRCRAFT
+#define AIRCRAFT_DICTIONARY_MAX_NUM_AIRCRAFT 500
+#endif
+
+/**
+ * Most recent odd and even Compact Position Reporting (CPR) packets received from an aircraft. Only needed while
+ * ingesting position messages, so the AircraftDictionary keeps these in a side table instead of inside each Aircraft.
+ */
+class CPRPacketPair {
+   public:
+    struct CPRPacket {
+        // SetCPRLatLon values.
+        uint32_t received_timestamp_ms = 0;  // [ms] time since boot when packet was recorded
+        uint32_t n_lat : 17 = 0;             // 17-bit latitude count
+        uint32_t nl_cpr : 6 = 0;             // DecodePosition value: number of longitude cells in latitude band
+        bool surface : 1 = false;            // Counts are from a surface position message (90 degree zones).
+        uint32_t n_lon : 17 = 0;             // 17-bit longitude count
+
+        // DecodePosition values.
+        uint32_t calculated_timestamp_ms = 0;  // [ms] time since boot when packet was calculated
+        // Only keep latitude since it's reused in cooperative calculations between odd and even packets.
+        int32_t lat_bam = 0;  // [BAM] latitude as a signed fraction of a full turn (2^32 = 360 degrees)
+    };
+
+    /**
+     * Set an aircraft's position in Compact Position Reporting (CPR) format. Takes either an even or odd set of lat/lon
+     * coordinates and stores them for decoding with Aircraft::DecodePosition() or Aircraft::DecodePositionLocal().
+     * @param[in] n_lat_cpr 17-bit latitude count.
+     * @param[in] n_lon_cpr 17-bit longitude count.
+     * @param[in] odd Boolean indicating that the position update is relative to an odd grid reference (if true) or an
+     * even grid reference.
+     * @param[in] surface Boolean indicating that the coordinates are from a surface position message, which uses CPR
+     * zones that are 4x smaller (90 degrees instead of 360 degrees).
+     * @param[in] redigesting Boolean flag used if SetCPRLatLon is being used to re-digest a packet. Assures that it
+     * won't call itself again if set.
+     * @retval True if coordinates were parsed successfully, false if not. NOTE: invalid positions can still be
+     * considered a successful parse.
+     */
+    bool SetCPRLatLon(uint32_t n_lat_cpr, uint32_t n_lon_cpr, bool odd, bool surface = false, bool redigesting = false);
+
+    /**
+     * Simple helper that checks to see whether a global packet decode can be attempted (does not guarantee it will
+     * succeed, for instance an odd and even packet may have been received, but from different CPR zones). Surface
+     * positions can't be decoded globally, since they are ambiguous between four 90 degree quadrants.
+     * @retval True if decode can be attempted, false otherwise.
+     */
+    bool CanDecodePosition() const {
+        return last_odd_packet.received_timestamp_ms > 0 && last_even_packet.received_timestamp_ms > 0 &&
+               !last_odd_packet.surface && !last_even_packet.surface;
+    }
+
+    CPRPacket last_odd_packet;
+    CPRPacket last_even_packet;
+};
+
+/**
+ * Most recent message received from an aircraft for each class of ADS-B message that is repeated often without
+ * changing. A message that repeats the cached ME and capability (CA) fields of its class would decode to the same
+ * values, so the AircraftDictionary can skip decoding it. That only holds for messages whose fields aren't written by
+ * any other message, so aircraft status, target state and operation status messages aren't cached: they share the TCAS
+ * RA, IDENT, NACp and selected altitude fields with each other and with Mode S replies. The capability is also written
+ * by all-call replies, which invalidate the cache. Kept in a side table like CPRPacketPair.
+ */
+class ADSBMessageCache {
+   public:
+    // Classes of ADS-B messages that can be cached. Messages in a class are only decoded from their own ME and CA
+    // fields, and don't depend on when they were received, so a repeated message doesn't carry any new information.
+    enum MessageClass : uint8_t {
+        kMessageClassAircraftID = 0,  // TC = 1-4
+        kNumMessageClasses,
+        kMessageClassNone = kNumMessageClasses  // Not cached.
+    };
+
+    /**
+     * Returns the cache class of an ADS-B message.
+     * @param[in] typecode 5-bit typecode of the message.
+     * @retval MessageClass of the message, or kMessageClassNone if messages with this typecode aren't cached.
+     */
+    static constexpr MessageClass GetMessageClass(uint16_t typecode) {
+        return (typecode >= 1 && typecode <= 4) ? kMessageClassAircraftID : kMessageClassNone;
+    }
+
+    /**
+     * Checks whether a message matches the one cached for its class.
+     * @param[in] message_class Class of the message. Must not be kMessageClassNone.
+     * @param[in] capability Capability (CA) field of the message.
+     * @param[in] me 56-bit ME field of the message.
+     * @retval True if the message was the last one stored for its class, false otherwise.
+     */
+    inline bool Contains(MessageClass message_class, uint8_t capability, uint64_t me) const {
+        return messages_[message_class] == PackMessage(capability, me);
+    }
+
+    /**
+     * Caches a message that was decoded successfully.
+     * @param[in] message_class Class of the message. Must not be kMessageClassNone.
+     * @param[in] capability Capability (CA) field of the message.
+     * @param[in] me 56-bit ME field of the message.
+     */
+    inline void Store(MessageClass message_class, uint8_t capability, uint64_t me) {
+        messages_[message_class] = PackMessage(capability, me);
+    }
+
+    /**
+     * Clears the cached message for a class, so that the next message in the class is always decoded.
+     * @param[in] message_class Class of the message. Must not be kMessageClassNone.
+     */
+    inline void Invalidate(MessageClass message_class) { messages_[message_class] = 0; }
+
+   private:
+    static inline uint64_t PackMessage(uint8_t capability, uint64_t me) {
+        return (static_cast<uint64_t>(capability & 0b111) << ADSBPacket::kMENumBits) | me;
+    }
+
+    // 59-bit CA and ME fields of each class. Empty entries are 0, which never matches a cached message since their
+    // typecodes are nonzero.
+    uint64_t messages_[kNumMessageClasses] = {0};
+};
+
+/**
+ * ADS-B message that was received in lazy decode mode (see AircraftDictionaryConfig_t::lazy_decode) and hasn't been
+ * decoded yet. Only one message is kept per aircraft: a message with the same typecode and subtype replaces it, since
+ * it would overwrite the same fields, and any other message from the aircraft gets it decoded first, so that messages
+ * are always applied in the order they were received in. Kept in a side table like CPRPacketPair.
+ */
+class PendingADSBMessage {
+   public:
+    /**
+     * Checks whether decoding of an ADS-B message can be deferred. These are the messages that are received often but
+     * are only needed when the aircraft is reported. Position and velocity messages are decoded right away, since they
+     * are timestamped with the time they're decoded at.
+     * @param[in] typecode 5-bit typecode of the message.
+     * @retval True if the message can be stored as pending, false if it must be decoded right away.
+     */
+    static constexpr bool IsDeferrable(uint16_t typecode) {
+        return (typecode >= 1 && typecode <= 4) || typecode == 28 || typecode == 29 || typecode == 31;
+    }
+
+    /**
+     * Checks whether there is a message that hasn't been decoded yet.
+     */
+    inline bool IsPending() const { return word_ & kPendingBit; }
+
+    /**
+     * Checks whether a message would replace the pending message, because it has the same typecode and subtype.
+     * @param[in] me 56-bit ME field of the new message.
+     * @retval True if there is a pending message that can be dropped in favor of the new one, false otherwise.
+     */
+    inline bool IsReplacedBy(uint64_t me) const {
+        return IsPending() && ((word_ ^ me) & kTypeCodeAndSubtypeMask) == 0;
+    }
+
+    /**
+     * Stores a message without decoding it, replacing the pending message if there is one.
+     * @param[in] capability Capability (CA) field of the message, needed to rebuild it for decoding.
+     * @param[in] me 56-bit ME field of the message.
+     */
+    inline void Store(uint8_t capability, uint64_t me) {
+        word_ = kPendingBit | (static_cast<uint64_t>(capability & 0b111) << ADSBPacket::kMENumBits) | me;
+    }
+
+    /**
+     * Marks the pending message as decoded.
+     */
+    inline void Clear() { word_ = 0; }
+
+    inline uint8_t GetCapability() const { return (word_ >> ADSBPacket::kMENumBits) & 0b111; }
+    inline uint64_t GetME() const { return word_ & kMEMask; }
+
+   private:
+    static constexpr uint64_t kPendingBit = 1ULL << 63;
+    static constexpr uint64_t kMEMask = (1ULL << ADSBPacket::kMENumBits) - 1;
+    // Typecode is the first 5 bits of the ME field, followed by the 3-bit subtype (emitter category for TC1-4).
+    static constexpr uint64_t kTypeCodeAndSubtypeMask = 0xFFULL << (ADSBPacket::kMENumBits - 8);
+
+    uint64_t word_ = 0;  // [63] pending, [58-56] capability, [55-0] ME field.
+};
+
 class Aircraft {
    public:
     static const uint16_t kCallSignMaxNumChars = 7;
+    // Max age of the last known position for it to be used as a local CPR decode reference. Aircraft can't travel half
+    // a CPR zone (~180nm) in this amount of time.
+    static const uint32_t kCPRLocalDecodeMaxAgeMs = 10e3;
+    // Max age of the last known position for it to be used as a local CPR decode reference for a surface position.
+    // Surface CPR zones are 4x smaller (half a zone is ~45nm), but taxiing aircraft are slow enough that they can't get
+    // that far in this amount of time.
+    static const uint32_t kCPRSurfaceLocalDecodeMaxAgeMs = 300e3;
 
-    enum AirframeType : uint16_t {
+    enum AirframeType : uint8_t {
         kAirframeTypeInvalid = 0,
         kAirframeTypeReserved,
         kAirframeTypeNoCategoryInfo,
@@ -32,21 +221,21 @@ class Aircraft {
         kAirframeTypeRotorcraft
     };
 
-    enum AltitudeSource : int16_t {
+    enum AltitudeSource : int8_t {
         kAltitudeNotAvailable = -2,
         kAltitudeSourceNotSet = -1,
         kAltitudeSourceBaro = 0,
         kAltitudeSourceGNSS = 1
     };
 
-    enum VerticalRateSource : int16_t {
+    enum VerticalRateSource : int8_t {
         kVerticalRateNotAvailable = -2,
         kVerticalRateSourceNotSet = -1,
         kVerticalRateSourceGNSS = 0,
         kVerticalRateSourceBaro = 1
     };
 
-    enum VelocitySource : int16_t {
+    enum VelocitySource : int8_t {
         kVelocitySourceNotAvailable = -2,
         kVelocitySourceNotSet = -1,
         kVelocitySourceGroundSpeed = 0,
@@ -70,10 +259,10 @@ class Aircraft {
         kBitFlagIdent,                       // IDENT switch is currently active.
         kBitFlagAlert,                       // Aircraft is indicating an alert.
         kBitFlagTCASRA,                      // Indicates a TCAS resolution advisory is active.
-        kBitFlagReserved0,
-        kBitFlagReserved1,
-        kBitFlagReserved2,
-        kBitFlagReserved3,
+        kBitFlagSelectedAltitudeValid,  // Received a selected altitude in a Comm-B reply.
+        kBitFlagRollAngleValid,         // Received a roll angle in a Comm-B reply.
+        kBitFlagHeadingValid,           // Received a magnetic heading in a Comm-B reply.
+        kBitFlagSelectedHeadingValid,   // Received a selected heading in a Target State and Status message.
         // Flags after kBitFlagUpdatedBaroAltitude are cleared at the end of every reporting interval.
         kBitFlagUpdatedBaroAltitude,
         kBitFlagUpdatedGNSSAltitude,
@@ -84,6 +273,28 @@ class Aircraft {
         kBitFlagNumFlagBits
     };
 
+    // Emergency / priority status from Aircraft Status (TC = 28) messages.
+    enum EmergencyState : uint8_t {
+        kEmergencyStateNone = 0,
+        kEmergencyStateGeneral = 1,
+        kEmergencyStateLifeguardMedical = 2,
+        kEmergencyStateMinimumFuel = 3,
+        kEmergencyStateNoCommunications = 4,
+        kEmergencyStateUnlawfulInterference = 5,
+        kEmergencyStateDownedAircraft = 6,
+        kEmergencyStateReserved = 7
+    };
+
+    // Bits of AircraftDetails::autopilot_modes, from Target State and Status (TC = 29) messages.
+    enum AutopilotModeBit : uint8_t {
+        kAutopilotModeBitValid = 0,  // Set if the other bits have been received.
+        kAutopilotModeBitEngaged,
+        kAutopilotModeBitVNAV,
+        kAutopilotModeBitAltitudeHold,
+        kAutopilotModeBitApproach,
+        kAutopilotModeBitLNAV
+    };
+
     enum NICBit : uint16_t { kNICBitA = 0, kNICBitB = 1, kNICBitC = 2 };
 
     enum SystemDesignAssurance : uint8_t {
@@ -159,33 +370,40 @@ class Aircraft {
     Aircraft();
 
     /**
-     * Set an aircraft's position in Compact Position Reporting (CPR) format. Takes either an even or odd set of lat/lon
-     * coordinates and uses them to set the aircraft's position.
-     * @param[in] n_lat_cpr 17-bit latitude count.
-     * @param[in] n_lon_cpr 17-bit longitude count.
-     * @param[in] odd Boolean indicating that the position update is relative to an odd grid reference (if true) or an
-     * even grid reference.
-     * @param[in] redigesting Boolean flag used if SetCPRLatLon is being used to re-digest a packet. Assures that it
-     * won't call itself again if set.
-     * @retval True if coordinates were parsed successfully, false if not. NOTE: invalid positions can still be
-     * considered a successful parse.
+     * Decodes the aircraft position using the last odd and even CPR packets (global CPR decode). Airborne positions
+     * only.
+     * @param[in] cpr_packets CPR packets received from this aircraft. Decoded latitudes are cached in the packets.
+     * @retval True if position was decoded successfully, false otherwise.
      */
-    bool SetCPRLatLon(uint32_t n_lat_cpr, uint32_t n_lon_cpr, bool odd, bool redigesting = false);
+    bool DecodePosition(CPRPacketPair &cpr_packets);
 
     /**
-     * Simple helper that checks to see whether a packet decode can be attempted (does not guarantee it will succeed,
-     * for instance an odd and even packet may have been received, but from different CPR zones).
-     * @retval True if decode can be attempted, false otherwise.
+     * Decodes the aircraft position from the most recently received CPR packet alone, using a reference position to
+     * pick the correct latitude and longitude zones (local CPR decode). Only valid if the aircraft is within half a
+     * zone of the reference position (~180nm for airborne positions, ~45nm for surface positions).
+     * @param[in] cpr_packets CPR packets received from this aircraft.
+     * @param[in] ref_lat_deg_e7 Reference latitude, in degrees * 1e7.
+     * @param[in] ref_lon_deg_e7 Reference longitude, in degrees * 1e7.
+     * @retval True if position was decoded successfully, false otherwise.
      */
-    bool CanDecodePosition() {
-        return last_odd_packet_.received_timestamp_ms > 0 && last_even_packet_.received_timestamp_ms > 0;
+    bool DecodePositionLocal(const CPRPacketPair &cpr_packets, int32_t ref_lat_deg_e7, int32_t ref_lon_deg_e7);
+
+    /**
+     * Checks whether the aircraft has a position that is recent enough to be used as the reference for a local CPR
+     * decode.
+     * @param[in] max_age_ms Max age of the last known position. Defaults to the airborne limit.
+     * @retval True if the last known position can be used as a local decode reference, false otherwise.
+     */
+    inline bool HasRecentPosition(uint32_t max_age_ms = kCPRLocalDecodeMaxAgeMs) {
+        return HasBitFlag(kBitFlagPositionValid) && get_time_since_boot_ms() - last_position_timestamp_ms <= max_age_ms;
     }
 
     /**
-     * Decodes the aircraft position using last_odd_packet_ and last_even_packet_.
-     * @retval True if position was decoded successfully, false otherwise.
+     * Checks whether a position has ever been decoded for the aircraft. Unlike kBitFlagPositionValid, this stays set
+     * when a later decode fails.
+     * @retval True if the aircraft has had a position decoded, false otherwise.
      */
-    bool DecodePosition();
+    inline bool HasDecodedPosition() const { return last_position_timestamp_ms != 0; }
 
     /**
      * Indicate that a frame has been received by incrementing the corresponding frame counter.
@@ -215,28 +433,6 @@ class Aircraft {
      */
     inline void WriteBitFlag(BitFlag bit, bool value) { value ? flags |= (0b1 << bit) : flags &= ~(0b1 << bit); }
 
-    /**
-     * Write a value for a NIC supplement bit. Used to piece together a NIC from separate messages, so that the NIC can
-     * be determined based on a received TypeCode.
-     * @param[in] bit NIC supplement bit to write.
-     * @param[in] value Value to write to the bit.
-     */
-    inline void WriteNICBit(NICBit bit, bool value) {
-        value ? nic_bits |= (0b1 << bit) : nic_bits &= ~(0b1 << bit);
-        // FIXME: Permanently setting NIC bits valid like this can cause invalid navigation integrity values to be read
-        // if a stale NIC supplement bit is being used. Hopefully this isn't a big problem if NIC values don't change
-        // frequently.
-        nic_bits_valid |= (0b1 << bit);
-    }
-
-    /**
-     * Returns whether a NIC supplement bit has been written to. Used to decide when to use NIC supplement bit values to
-     * determine NIC value based on received TypeCodes.
-     * @param[in] bit NIC supplement bit to check.
-     * @retval True if bit has been written to, false otherwise.
-     */
-    inline bool NICBitIsValid(NICBit bit) { return nic_bits & (0b1 << bit); }
-
     /**
      * Checks whether a flag bit is set.
      * @param[in] bit Position of bit to check.
@@ -249,9 +445,28 @@ class Aircraft {
      */
     inline void ResetUpdatedBitFlags() { flags &= ~(~0b0 << kBitFlagUpdatedBaroAltitude); }
 
-    uint32_t flags = 0b0;
+    // Members are ordered by size so that there's no padding between them. Aircraft only holds the state that is
+    // read or updated for every aircraft on every reporting interval. Information that rarely changes is kept out of
+    // line in AircraftDetails, so that scans over the dictionary don't have to page through it.
 
+    uint32_t flags = 0b0;
+    uint32_t icao_address = 0;
+    // Set by AircraftDictionary when a message is ingested. Don't write this directly for an aircraft that's already in
+    // the dictionary, since the dictionary keeps its aircraft ordered by this timestamp for pruning.
     uint32_t last_message_timestamp_ms = 0;
+
+    int32_t baro_altitude_ft = 0;
+    int32_t gnss_altitude_ft = 0;
+
+    // Airborne Position Message
+    int32_t latitude_deg_e7 = 0;              // [deg * 1e7] Same units as MAVLINK.
+    int32_t longitude_deg_e7 = 0;             // [deg * 1e7] Same units as MAVLINK.
+    uint32_t last_position_timestamp_ms = 0;  // [ms] time since boot when position was decoded
+
+    // Airborne Velocities Message
+    float track_deg = 0.0f;
+    float velocity_kts = 0;
+
     int16_t last_message_signal_strength_dbm = 0;  // Voltage of RSSI signal during message receipt.
     int16_t last_message_signal_quality_db = 0;    // Ratio of RSSI to noise floor during message receipt.
 
@@ -259,84 +474,263 @@ class Aircraft {
     uint16_t stats_mode_ac_frames_received_in_last_interval = 0;
     uint16_t stats_mode_s_frames_received_in_last_interval = 0;
 
-    uint16_t transponder_capability = 0;
-    uint32_t icao_address = 0;
-    char callsign[kCallSignMaxNumChars + 1] = "?";  // put extra EOS character at end
     uint16_t squawk = 0;
-    AirframeType airframe_type = kAirframeTypeInvalid;
+    int16_t vertical_rate_fpm = 0;  // Max magnitude is 32,640fpm.
 
-    int32_t baro_altitude_ft = 0;
-    int32_t gnss_altitude_ft = 0;
-    AltitudeSource altitude_source = kAltitudeSourceNotSet;
-
-    // Airborne Position Message
-    float latitude_deg = 0.0f;
-    float longitude_deg = 0.0f;
+    char callsign[kCallSignMaxNumChars + 1] = "?";  // put extra EOS character at end
 
-    // Airborne Velocities Message
-    float track_deg = 0.0f;
-    float velocity_kts = 0;
+    AirframeType airframe_type = kAirframeTypeInvalid;
+    AltitudeSource altitude_source = kAltitudeSourceNotSet;
     VelocitySource velocity_source = kVelocitySourceNotSet;
-    int vertical_rate_fpm = 0.0f;
     VerticalRateSource vertical_rate_source = kVerticalRateSourceNotSet;
+    EmergencyState emergency_state = kEmergencyStateNone;
+
+   private:
+    uint16_t stats_mode_ac_frames_received_counter_ = 0;
+    uint16_t stats_mode_s_frames_received_counter_ = 0;
+};
+
+/**
+ * Information about an aircraft that rarely changes once it has been received, like its capabilities, integrity /
+ * accuracy categories, and dimensions, or that is only received every few seconds, like the Comm-B registers read by
+ * Enhanced Surveillance radars. The AircraftDictionary keeps these in a side table next to the Aircraft they belong to.
+ */
+class AircraftDetails {
+   public:
+    // Max age of the last ADS-B velocity for Comm-B ground speed, track and vertical rate to be ignored. ADS-B
+    // velocities are broadcast twice a second and are more precise, but Comm-B replies keep aircraft without ADS-B
+    // moving.
+    static const uint32_t kADSBVelocityMaxAgeMs = 10e3;
+
+    /**
+     * Write a value for a NIC supplement bit. Used to piece together a NIC from separate messages, so that the NIC can
+     * be determined based on a received TypeCode.
+     * @param[in] bit NIC supplement bit to write.
+     * @param[in] value Value to write to the bit.
+     */
+    inline void WriteNICBit(Aircraft::NICBit bit, bool value) {
+        value ? nic_bits |= (0b1 << bit) : nic_bits &= ~(0b1 << bit);
+        // FIXME: Permanently setting NIC bits valid like this can cause invalid navigation integrity values to be read
+        // if a stale NIC supplement bit is being used. Hopefully this isn't a big problem if NIC values don't change
+        // frequently.
+        nic_bits_valid |= (0b1 << bit);
+    }
+
+    /**
+     * Returns whether a NIC supplement bit has been written to. Used to decide when to use NIC supplement bit values to
+     * determine NIC value based on received TypeCodes.
+     * @param[in] bit NIC supplement bit to check.
+     * @retval True if bit has been written to, false otherwise.
+     */
+    inline bool NICBitIsValid(Aircraft::NICBit bit) { return nic_bits & (0b1 << bit); }
+
+    /**
+     * Checks whether the aircraft has broadcast its velocity over ADS-B recently. Used to give ADS-B velocities
+     * precedence over the ones from Comm-B replies.
+     * @retval True if an ADS-B velocity was received within kADSBVelocityMaxAgeMs, false otherwise.
+     */
+    inline bool HasRecentADSBVelocity() const {
+        return last_adsb_velocity_timestamp_ms != 0 &&
+               get_time_since_boot_ms() - last_adsb_velocity_timestamp_ms <= kADSBVelocityMaxAgeMs;
+    }
+
+    // [ms] Time since boot when a velocity was last received in an Airborne Velocities or Surface Position message.
+    // 0 if no ADS-B velocity has been received.
+    uint32_t last_adsb_velocity_timestamp_ms = 0;
+
+    // Comm-B Track and Turn Report (BDS 5,0) and Heading and Speed Report (BDS 6,0). Only valid if the matching flag
+    // is set on the Aircraft.
+    float roll_deg = 0.0f;     // Positive is right wing down.
+    float heading_deg = 0.0f;  // Magnetic heading.
+    // Target State and Status Information (TC = 29). Only valid if kBitFlagSelectedHeadingValid is set on the Aircraft.
+    float selected_heading_deg = 0.0f;
+    // Selected altitude from Comm-B (BDS 4,0) or Target State and Status Information (TC = 29). Only valid if
+    // kBitFlagSelectedAltitudeValid is set on the Aircraft.
+    uint16_t selected_altitude_ft = 0;  // MCP / FCU selected altitude, or FMS selected altitude if there isn't one.
+    // Baro pressure setting (BDS 4,0 or TC = 29), airspeeds (BDS 5,0 and 6,0), and Mach (BDS 6,0). 0 if not available.
+    uint16_t baro_pressure_setting_mb_e1 = 0;  // [mb * 10]
+    uint16_t true_airspeed_kts = 0;
+    uint16_t indicated_airspeed_kts = 0;
+    uint16_t mach_e3 = 0;  // [Mach * 1000]
+
+    // Aircraft Status Message (TC = 28), ACAS Resolution Advisory broadcast. Bits are in the order that they're sent.
+    uint16_t acas_active_resolution_advisories = 0;   // 14-bit ARA field.
+    uint8_t acas_resolution_advisory_complements = 0;  // 4-bit RAC field.
+    // Target State and Status Information (TC = 29). Bitmask of Aircraft::AutopilotModeBit.
+    uint8_t autopilot_modes = 0b0;
+
+    uint8_t transponder_capability = 0;
 
     // Aircraft Operation Status Message
-    // Navigation Integrity Category (NIC)
-    uint8_t nic_bits_valid = 0b000;  // MSb to LSb: nic_c_valid nic_b_valid nic_a_valid.
-    uint8_t nic_bits = 0b000;        // MSb to LSb: nic_c nic_b nic_a.
-    NICRadiusOfContainment navigation_integrity_category = kROCUnknown;  // 4 bits.
-    NICBarometricAltitudeIntegrity navigation_integrity_category_baro =
-        kBAIGillhamInputNotCrossChecked;  // 1 bit. Default to worst case.
-    // Navigation Accuracy Category (NAC)
-    NACHorizontalVelocityError navigation_accuracy_category_velocity =
-        kHVEUnknownOrGreaterThanOrEqualTo10MetersPerSecond;  // 3 bits.
-    NACEstimatedPositionUncertainty navigation_accuracy_category_position =
-        kEPUUnknownOrGreaterThanOrEqualTo10NauticalMiles;  // 4 bits.
-    // Geometric Vertical Accuracy (GVA)
-    GVA geometric_vertical_accuracy = kGVAUnknownOrGreaterThan150Meters;  // 2 bits.
-    SILProbabilityOfExceedingNICRadiusOfContainmnent source_integrity_level =
-        kPOERCUnknownOrGreaterThan1em3PerFlightHour;  // 3 bits.
-    // System Design Assurance
-    SystemDesignAssurance system_design_assurance = kSDASupportedFailureUnknownOrNoSafetyEffect;  // 2 bits.
     // GPS Antenna Offset
     int8_t gnss_antenna_offset_right_of_roll_axis_m =
         INT8_MAX;  // Defaults to INT8_MAX to indicate it hasn't been read yet.
     // Aircraft dimensions (on the ground).
-    uint16_t length_m = 0;
-    uint16_t width_m = 0;
-
+    uint8_t length_m = 0;
+    uint8_t width_m = 0;
     int8_t adsb_version = -1;
 
+    // Navigation Integrity Category (NIC)
+    uint8_t nic_bits_valid : 3 = 0b000;  // MSb to LSb: nic_c_valid nic_b_valid nic_a_valid.
+    uint8_t nic_bits : 3 = 0b000;        // MSb to LSb: nic_c nic_b nic_a.
+    Aircraft::NICRadiusOfContainment navigation_integrity_category : 4 = Aircraft::kROCUnknown;
+    Aircraft::NICBarometricAltitudeIntegrity navigation_integrity_category_baro : 1 =
+        Aircraft::kBAIGillhamInputNotCrossChecked;  // Default to worst case.
+    // Navigation Accuracy Category (NAC)
+    Aircraft::NACHorizontalVelocityError navigation_accuracy_category_velocity : 3 =
+        Aircraft::kHVEUnknownOrGreaterThanOrEqualTo10MetersPerSecond;
+    Aircraft::NACEstimatedPositionUncertainty navigation_accuracy_category_position : 4 =
+        Aircraft::kEPUUnknownOrGreaterThanOrEqualTo10NauticalMiles;
+    // Geometric Vertical Accuracy (GVA)
+    Aircraft::GVA geometric_vertical_accuracy : 2 = Aircraft::kGVAUnknownOrGreaterThan150Meters;
+    Aircraft::SILProbabilityOfExceedingNICRadiusOfContainmnent source_integrity_level : 3 =
+        Aircraft::kPOERCUnknownOrGreaterThan1em3PerFlightHour;
+    // System Design Assurance
+    Aircraft::SystemDesignAssurance system_design_assurance : 2 = Aircraft::kSDASupportedFailureUnknownOrNoSafetyEffect;
+};
+
+/**
+ * Fixed-size table that counts sightings of ICAO addresses that aren't in the AircraftDictionary yet. Entries expire a
+ * set time after the first sighting, so an address has to be seen several times in quick succession to be confirmed.
+ * The table is set associative: each address can only be stored in a few entries, and when those are full, the entry
+ * with the oldest first sighting is replaced.
+ */
+class AircraftCandidateTable {
+   public:
+    static const uint16_t kNumSetsBits = 5;
+    static const uint16_t kNumSets = 1 << kNumSetsBits;
+    static const uint16_t kNumWays = 4;
+
+    /**
+     * Removes all candidates from the table.
+     */
+    void Clear();
+
+    /**
+     * Records a sighting of an ICAO address.
+     * @param[in] icao_address 24-bit ICAO address that was seen.
+     * @param[in] timestamp_ms Time of the sighting.
+     * @param[in] ttl_ms Time after the first sighting that sightings of the address are forgotten.
+     * @retval Number of sightings of the address within ttl_ms of the first sighting, including this one.
+     */
+    uint16_t RecordSighting(uint32_t icao_address, uint32_t timestamp_ms, uint32_t ttl_ms);
+
+    /**
+     * Removes an ICAO address from the table.
+     * @param[in] icao_address 24-bit ICAO address to remove.
+     */
+    void Remove(uint32_t icao_address);
+
    private:
-    struct CPRPacket {
-        // SetCPRLatLon values.
-        uint32_t received_timestamp_ms = 0;  // [ms] time since boot when packet was recorded
-        uint32_t n_lat = 0;                  // 17-bit latitude count
-        uint32_t n_lon = 0;                  // 17-bit longitude count
+    struct Candidate {
+        uint32_t icao_address : 24 = 0;
+        uint32_t num_sightings : 8 = 0;  // 0 if the entry is unused.
+        uint32_t first_sighting_timestamp_ms = 0;
+    };
 
-        // DecodePosition values.
-        uint32_t calculated_timestamp_ms = 0;  // [ms] time since boot when packet was calculated
-        float lat_cpr = 0.0f;
-        float lon_cpr = 0.0f;
-        uint16_t nl_cpr = 0;  // number of longitude cells in latitude band
-        float lat =
-            0.0f;  // only keep latitude since it's reused in cooperative calculations between odd and even packets
-        // float lon = 0.0f; // longitude
+    /**
+     * Returns the first entry of the set that an ICAO address belongs to.
+     */
+    inline Candidate *GetSet(uint32_t icao_address) {
+        return &candidates_[((icao_address * 2654435769u) >> (32 - kNumSetsBits)) * kNumWays];
+    }
+
+    Candidate candidates_[kNumSets * kNumWays];
+};
+
+/**
+ * Fixed-size set of ICAO addresses that have been seen recently in packets that can validate themselves (e.g. all-call
+ * replies), used to validate Address / Parity packets from aircraft that aren't in the AircraftDictionary. Lookups and
+ * insertions only touch one set of a few entries. When a set is full, the least recently seen address is replaced.
+ */
+class RecentICAOAddressSet {
+   public:
+    static const uint16_t kNumSetsBits = 6;
+    static const uint16_t kNumSets = 1 << kNumSetsBits;
+    static const uint16_t kNumWays = 4;
+
+    /**
+     * Removes all addresses from the set.
+     */
+    void Clear();
+
+    /**
+     * Adds an ICAO address to the set, or refreshes its timestamp if it's already in the set.
+     * @param[in] icao_address 24-bit ICAO address that was seen.
+     * @param[in] timestamp_ms Time that the address was seen.
+     */
+    void Insert(uint32_t icao_address, uint32_t timestamp_ms);
+
+    /**
+     * Checks whether an ICAO address has been seen recently.
+     * @param[in] icao_address 24-bit ICAO address to look for.
+     * @param[in] timestamp_ms Current time.
+     * @param[in] ttl_ms Maximum time since the address was last seen.
+     * @retval True if the address was seen within ttl_ms of timestamp_ms, false otherwise.
+     */
+    bool Contains(uint32_t icao_address, uint32_t timestamp_ms, uint32_t ttl_ms) const;
+
+   private:
+    struct Entry {
+        uint32_t icao_address : 24 = 0;
+        uint32_t in_use : 1 = 0;
+        uint32_t last_seen_timestamp_ms = 0;
     };
 
-    CPRPacket last_odd_packet_;
-    CPRPacket last_even_packet_;
+    /**
+     * Returns the index of the first entry of the set that an ICAO address belongs to.
+     */
+    static inline uint16_t GetSetIndex(uint32_t icao_address) {
+        return ((icao_address * 2654435769u) >> (32 - kNumSetsBits)) * kNumWays;
+    }
 
-    uint16_t stats_mode_ac_frames_received_counter_ = 0;
-    uint16_t stats_mode_s_frames_received_counter_ = 0;
+    Entry entries_[kNumSets * kNumWays];
 };
 
 class AircraftDictionary {
    public:
+    // What to do with a new aircraft when the dictionary is full. Both eviction policies prefer to evict aircraft
+    // that have never had a valid position, since bursts of noise-induced ICAO addresses never get one.
+    enum EvictionPolicy : uint8_t {
+        kEvictionPolicyRejectNew = 0,         // Refuse new aircraft until stale aircraft are pruned.
+        kEvictionPolicyEvictStalest,          // Evict the aircraft that was heard from least recently.
+        kEvictionPolicyEvictLowestFrameRate,  // Evict the aircraft with the fewest frames in the last stats interval.
+    };
+
     struct AircraftDictionaryConfig_t {
         uint32_t aircraft_prune_interval_ms = 60e3;
+        EvictionPolicy eviction_policy = kEvictionPolicyEvictStalest;
+        // Number of least recently heard from aircraft to search for one that has never had a position, when evicting
+        // with kEvictionPolicyEvictStalest. kEvictionPolicyEvictLowestFrameRate always searches the whole dictionary.
+        uint16_t eviction_search_depth = 16;
+        // New aircraft from packets whose ICAO address can't be trusted on its own (anything but a DF17 extended
+        // squitter that passed its CRC without bit error correction) are held as candidates until they've been seen
+        // this many times within candidate_ttl_ms. Candidates with addresses outside of the blocks allocated by ICAO
+        // are dropped.
+        uint16_t candidate_min_num_sightings = 2;
+        uint32_t candidate_ttl_ms = 10e3;
+        // Address / Parity packets from aircraft that aren't in the dictionary are validated if their ICAO address was
+        // seen in an all-call reply within this interval, and are then held as candidates like any other untrusted
+        // packet. All-call replies with unallocated ICAO addresses are ignored.
+        uint32_t recent_icao_address_ttl_ms = 60e3;
+        // Max number of bit errors to repair in 112-bit ADS-B packets that fail their CRC (0 = off, 1 or 2). 2-bit
+        // correction recovers more packets, but has a higher chance of "repairing" a packet into the wrong message.
+        uint16_t max_num_bits_to_correct = 1;
+        // Receiver position, used as the reference for local CPR decoding of aircraft that don't have a recent position
+        // yet. Only aircraft within ~180nm of the receiver can be decoded this way.
+        bool receiver_position_valid = false;
+        int32_t receiver_latitude_deg_e7 = 0;
+        int32_t receiver_longitude_deg_e7 = 0;
+        // Defer decoding of identification and status ADS-B messages (see PendingADSBMessage) until the
+        // aircraft is read with GetAircraft, GetAircraftDetails or DecodePendingMessages, or until another message is
+        // received from it, so that ingesting a stream of them is just a copy of the ME field. Deferred messages that
+        // can't be decoded are still accepted during ingestion.
+        bool lazy_decode = false;
     };
-    static const uint16_t kMaxNumAircraft = 100;
+    static const uint16_t kMaxNumAircraft = AIRCRAFT_DICTIONARY_MAX_NUM_AIRCRAFT;
+    // RAM budget for each aircraft the dictionary can track, including its side table entries and its share of the
+    // hash index and expiry list. Checked at compile time, raise it deliberately when adding per-aircraft state.
+    static const uint16_t kMaxNumBytesPerAircraft = 200;
 
     /**
      * Default constructor. Uses default config values.
@@ -354,47 +748,84 @@ class AircraftDictionary {
     void Init();
 
     /**
-     * Prunes stale aircraft from the dictionary.
-     * @param[in] timestamp_us Current timestamp, in microseconds, to use for pruning. Aircraft older than timestamp_us
-     * minus the pruning interval will be removed.
+     * Prunes stale aircraft from the dictionary. Aircraft are kept in order of their last message timestamp, so this
+     * only touches the aircraft that get removed, plus one.
+     * @param[in] timestamp_ms Current timestamp, in milliseconds, to use for pruning. Aircraft that haven't been heard
+     * from for longer than the pruning interval will be removed. Aircraft with messages newer than timestamp_ms are
+     * kept.
+     * @retval Number of aircraft that were removed.
      */
-    void Update(uint32_t timestamp_us);
+    uint16_t Update(uint32_t timestamp_ms);
 
     /**
-     * Ingests a DecodedTransponderPacket and uses it to insert and update the relevant aircraft.
+     * Ingests a DecodedTransponderPacket and uses it to insert and update the relevant aircraft. Packets that are valid
+     * when they are passed in (CRC-clean Extended Squitters, or Squitters that the caller has already validated) can
+     * add new aircraft right away. Packets that only became valid through bit error correction can only add a new
+     * aircraft once its ICAO address has been confirmed by the candidate table.
      * @param[in] packet DecodedTransponderPacket to ingest. Can be 56-bit (Squitter) or 112-bit (Extended Squitter).
-     * Passed as a reference, since packets can be marked as valid by this function.
-     * @retval True if successful, false if something broke.
+     * Passed as a reference, since packets can be marked as valid (or have bit errors corrected) by this function.
+     * @retval True if successful, false if something broke or the packet is from an unconfirmed aircraft.
      */
     bool IngestDecodedTransponderPacket(DecodedTransponderPacket &packet);
 
     /**
-     * Ingests a Mode A (Identity Surveillance Reply) packet and uses it to update the relevant aircraft. Exposed for
-     * testing, but usually called by IngestDecodedTransponderPacket.
+     * Ingests a Mode A (Identity Surveillance Reply, DF=5) or Comm-B Identity Reply (DF=21) packet and uses it to
+     * update the relevant aircraft. Exposed for testing, but usually called by IngestDecodedTransponderPacket.
      * Note: this function requires that the packet be marked as valid using the ForceValid() function. If the packet is
      * valid and does not match an ICAO in the aircraft dictionary, a new aircraft will be inserted.
      * @param[in] packet ModeAPacket to ingest.
      * @retval True if successful, false if something broke.
      */
-    bool IngestModeAPacket(ModeAPacket packet);
+    bool IngestModeAPacket(const ModeAPacket &packet);
 
     /**
-     * Ingests a Mode C (Altitude Surveillance Reply) packet and uses it to update the relevant aircraft. Exposed for
-     * testing, but usually called by IngestDecodedTransponderPacket.
+     * Ingests a Mode C (Altitude Surveillance Reply, DF=4) or Comm-B Altitude Reply (DF=20) packet and uses it to
+     * update the relevant aircraft. Exposed for testing, but usually called by IngestDecodedTransponderPacket.
      * Note: this function requires that the packet be marked as valid using the ForceValid() function. If the packet is
      * valid and does not match an ICAO in the aircraft dictionary, a new aircraft will be inserted.
      * @param[in] packet ModeCPacket to ingest.
      * @retval True if successful, false if something broke.
      */
-    bool IngestModeCPacket(ModeCPacket packet);
+    bool IngestModeCPacket(const ModeCPacket &packet);
+
+    /**
+     * Ingests an air-air surveillance reply (DF=0 or DF=16) packet and uses it to update the relevant aircraft. Exposed
+     * for testing, but usually called by IngestDecodedTransponderPacket.
+     * Note: this function requires that the packet be marked as valid using the ForceValid() function. If the packet is
+     * valid and does not match an ICAO in the aircraft dictionary, a new aircraft will be inserted.
+     * @param[in] packet AirAirSurveillancePacket to ingest.
+     * @retval True if successful, false if something broke.
+     */
+    bool IngestAirAirSurveillancePacket(const AirAirSurveillancePacket &packet);
+
+    /**
+     * Ingests the Comm-B message of a Comm-B reply (DF=20 or DF=21) packet and uses it to update the relevant aircraft.
+     * The register that the message was read from is inferred from its contents, and messages that don't match exactly
+     * one of the supported registers (BDS 4,0, 5,0, and 6,0) are ignored. Ground speed, track, and vertical rate from
+     * BDS 5,0 and 6,0 are written to the Aircraft if it hasn't sent an ADS-B velocity recently. Doesn't count the frame
+     * or update the aircraft's last message timestamp, since the altitude or identity in the reply is ingested
+     * separately. Exposed for testing, but usually called by IngestDecodedTransponderPacket.
+     * @param[in] packet CommBPacket to ingest. Must be valid.
+     * @retval True if the Comm-B message was decoded, false otherwise.
+     */
+    bool IngestCommBPacket(const CommBPacket &packet);
+
+    /**
+     * Ingests an all-call reply (DF=11) packet. All-call replies can validate themselves, so their ICAO addresses are
+     * remembered and used to validate Address / Parity packets. They don't add aircraft to the dictionary, but update
+     * aircraft that are already in it. Exposed for testing, but usually called by IngestDecodedTransponderPacket.
+     * @param[in] packet AllCallReplyPacket to ingest.
+     * @retval True if packet was valid and ingested successfully, false otherwise.
+     */
+    bool IngestAllCallReplyPacket(const AllCallReplyPacket &packet);
 
     /**
      * Ingests an ADSBPacket directly. Exposed for testing, but usually this gets called by
      * IngestDecodedTransponderPacket and should not get touched directly.
-     * @param[in] packet ADSBPacket to ingest. Derived from a DecodedTransponderPacket with DF=17-19.
+     * @param[in] packet ADSBPacket to ingest. View into a DecodedTransponderPacket with DF=17-19.
      * @retval True if successful, false if something broke.
      */
-    bool IngestADSBPacket(ADSBPacket packet);
+    bool IngestADSBPacket(const ADSBPacket &packet);
 
     /**
      * Returns the number of aircraft currently in the dictionary.
@@ -403,7 +834,9 @@ class AircraftDictionary {
     uint16_t GetNumAircraft();
 
     /**
-     * Adds an Aircraft object to the aircraft dictionary, hashed by ICAO address.
+     * Adds an Aircraft object to the aircraft dictionary, hashed by ICAO address. If the dictionary is full, an
+     * existing aircraft may be evicted to make room, depending on the eviction policy. The aircraft keeps its
+     * last_message_timestamp_ms, and will be pruned based on it. The timestamp must not be newer than the current time.
      * @param[in] aircraft Aircraft to insert.
      * @retval True if insertaion succeeded, false if failed.
      */
@@ -416,13 +849,38 @@ class AircraftDictionary {
      */
     bool RemoveAircraft(uint32_t icao_address);
 
+    /**
+     * Sets the receiver position, used as the reference for local CPR decoding of aircraft that don't have a recent
+     * position yet. Aircraft that are only seen on the surface can't be decoded without it.
+     * @param[in] valid True if the receiver position is known, false to stop using it.
+     * @param[in] latitude_deg_e7 Receiver latitude, in degrees * 1e7.
+     * @param[in] longitude_deg_e7 Receiver longitude, in degrees * 1e7.
+     */
+    void SetReceiverPosition(bool valid, int32_t latitude_deg_e7, int32_t longitude_deg_e7) {
+        config_.receiver_position_valid = valid;
+        config_.receiver_latitude_deg_e7 = latitude_deg_e7;
+        config_.receiver_longitude_deg_e7 = longitude_deg_e7;
+    }
+
+    /**
+     * Returns the receiver position set with SetReceiverPosition or the config.
+     * @param[out] latitude_deg_e7 Receiver latitude, in degrees * 1e7.
+     * @param[out] longitude_deg_e7 Receiver longitude, in degrees * 1e7.
+     * @retval True if the receiver position is valid, false otherwise.
+     */
+    bool GetReceiverPosition(int32_t &latitude_deg_e7, int32_t &longitude_deg_e7) const {
+        latitude_deg_e7 = config_.receiver_latitude_deg_e7;
+        longitude_deg_e7 = config_.receiver_longitude_deg_e7;
+        return config_.receiver_position_valid;
+    }
+
     /**
      * Retrieve an aircraft from the dictionary.
      * @param[in] icao_address Address to use for looking up the aircraft.
      * @param[out] aircraft_out Aircraft reference to put the retrieved aircraft into if successful.
      * @retval True if aircraft was found and retrieved, false if aircraft was not in the dictionary.
      */
-    bool GetAircraft(uint32_t icao_address, Aircraft &aircraft_out) const;
+    bool GetAircraft(uint32_t icao_address, Aircraft &aircraft_out);
 
     /**
      * Check if an aircraft is contained in the dictionary.
@@ -432,13 +890,70 @@ class AircraftDictionary {
     bool ContainsAircraft(uint32_t icao_address) const;
 
     /**
-     * Return a pointer to an aircraft if it's in the aircraft dictionary.
+     * Retrieve the details of an aircraft from the dictionary.
+     * @param[in] icao_address Address to use for looking up the aircraft.
+     * @param[out] details_out AircraftDetails reference to put the retrieved details into if successful.
+     * @retval True if aircraft was found and its details were retrieved, false if aircraft was not in the dictionary.
+     */
+    bool GetAircraftDetails(uint32_t icao_address, AircraftDetails &details_out);
+
+    /**
+     * Decodes the ADS-B messages that were stored without being decoded in lazy decode mode. Call this before
+     * iterating over dict to report aircraft, since iteration doesn't decode anything. Does nothing if lazy decoding is
+     * disabled.
+     */
+    void DecodePendingMessages();
+
+    /**
+     * Decodes an aircraft's pending ADS-B message, if it has one. Called by DecodePendingMessages, GetAircraft,
+     * GetAircraftDetails, and before ingesting any other message from the aircraft.
+     * @param[in] aircraft Reference to an Aircraft stored in dict.
+     */
+    void DecodePendingMessages(Aircraft &aircraft);
+
+    /**
+     * Returns the details of an aircraft in the dictionary, without looking it up again. Use this while iterating over
+     * dict, or with an aircraft returned by GetAircraftPtr.
+     * @param[in] aircraft Reference to an Aircraft stored in dict.
+     * @retval Reference to the aircraft's entry in the details side table.
+     */
+    inline AircraftDetails &GetAircraftDetails(const Aircraft &aircraft) {
+        return aircraft_details_[dict.GetSlotIndex(&aircraft)];
+    }
+
+    /**
+     * Return a pointer to an aircraft if it's in the aircraft dictionary, or insert it if it isn't. If the dictionary
+     * is full, an existing aircraft may be evicted to make room, depending on the eviction policy. Aircraft that are
+     * inserted by this function get the current time as their last message timestamp.
      * @param[in] icao_address ICAO address of the aircraft to find.
-     * @retval Pointer to the aircraft if it exists, or NULL if it wasn't in the dictionary.
+     * @retval Pointer to the aircraft, or NULL if it wasn't in the dictionary and couldn't be inserted.
      */
     Aircraft *GetAircraftPtr(uint32_t icao_address);
 
-    std::unordered_map<uint32_t, Aircraft> dict;  // index Aircraft objects by their ICAO identifier
+    // Aircraft objects indexed by their ICAO address. Iterating over the dictionary yields Aircraft references.
+    FixedHashMap<Aircraft, kMaxNumAircraft> dict;
+
+    // Number of 112-bit packets that were recovered with bit error correction. Cleared by Init().
+    uint32_t stats_num_packets_corrected_1_bit = 0;
+    uint32_t stats_num_packets_corrected_2_bit = 0;
+    // Number of aircraft that were evicted to make room for new aircraft, and number of new aircraft that were turned
+    // away because the dictionary was full. Cleared by Init().
+    uint32_t stats_num_aircraft_evicted = 0;
+    uint32_t stats_num_aircraft_rejected = 0;
+    // Number of candidate aircraft that were confirmed and added to the dictionary, and number of candidates or
+    // all-call replies that were dropped for having an unallocated ICAO address. Cleared by Init().
+    uint32_t stats_num_candidates_promoted = 0;
+    uint32_t stats_num_candidates_unallocated = 0;
+    // Number of Comm-B messages that matched none, or more than one, of the supported registers. Cleared by Init().
+    uint32_t stats_num_comm_b_unknown = 0;
+    uint32_t stats_num_comm_b_ambiguous = 0;
+    // Number of cacheable ADS-B messages (see ADSBMessageCache) that repeated the aircraft's cached message and were
+    // skipped, and number that had to be decoded. Cleared by Init().
+    uint32_t stats_num_adsb_message_cache_hits = 0;
+    uint32_t stats_num_adsb_message_cache_misses = 0;
+    // Number of surface position messages that couldn't be decoded, because the aircraft had no recent position and
+    // the receiver position isn't set. Cleared by Init().
+    uint32_t stats_num_surface_positions_undecodable = 0;
 
    private:
     // Helper functions for ingesting specific ADS-B packet types, called by IngestADSBPacket.
@@ -452,15 +967,101 @@ class AircraftDictionary {
      * @retval True if message was ingested successfully, false otherwise.
      */
 
-    bool ApplyAircraftIDMessage(Aircraft &aircraft, ADSBPacket packet);
-    bool ApplySurfacePositionMessage(Aircraft &aircraft, ADSBPacket packet);
-    bool ApplyAirbornePositionMessage(Aircraft &aircraft, ADSBPacket packet);
-    bool ApplyAirborneVelocitiesMessage(Aircraft &aircraft, ADSBPacket packet);
-    bool ApplyAircraftStatusMessage(Aircraft &aircraft, ADSBPacket packet);
-    bool ApplyTargetStateAndStatusInfoMessage(Aircraft &aircraft, ADSBPacket packet);
-    bool ApplyAircraftOperationStatusMessage(Aircraft &aircraft, ADSBPacket packet);
+    bool ApplyAircraftIDMessage(Aircraft &aircraft, const ADSBPacket &packet);
+    bool ApplySurfacePositionMessage(Aircraft &aircraft, const ADSBPacket &packet);
+    bool ApplyAirbornePositionMessage(Aircraft &aircraft, const ADSBPacket &packet);
+    bool ApplyAirborneVelocitiesMessage(Aircraft &aircraft, const ADSBPacket &packet);
+    bool ApplyAircraftStatusMessage(Aircraft &aircraft, const ADSBPacket &packet);
+    bool ApplyTargetStateAndStatusInfoMessage(Aircraft &aircraft, const ADSBPacket &packet);
+    bool ApplyAircraftOperationStatusMessage(Aircraft &aircraft, const ADSBPacket &packet);
+
+    // Handler for an ADS-B message with a specific typecode, called by IngestADSBPacket.
+    typedef bool (AircraftDictionary::*ADSBMessageHandler)(Aircraft &aircraft, const ADSBPacket &packet);
+    // ADS-B message handlers indexed by typecode, or nullptr for typecodes that aren't supported.
+    static const ADSBMessageHandler kADSBMessageHandlers[ADSBPacket::kNumTypeCodes];
+
+    /**
+     * Decodes an aircraft's position from its most recent CPR packet, picking a decode method based on the reference
+     * positions that are available. Called by ApplySurfacePositionMessage and ApplyAirbornePositionMessage after the
+     * CPR coordinates have been set.
+     * @param[in] aircraft Aircraft to update the position of.
+     * @param[in] cpr_packets CPR packets received from the aircraft.
+     * @param[in] surface True if the most recent CPR packet is from a surface position message.
+     * @retval True if position was decoded or there isn't enough information to attempt a decode yet, false if the
+     * decode failed.
+     */
+    bool DecodeCPRPosition(Aircraft &aircraft, CPRPacketPair &cpr_packets, bool surface);
+
+    /**
+     * Returns the CPR packets received from an aircraft in the dictionary.
+     * @param[in] aircraft Reference to an Aircraft stored in dict.
+     * @retval Reference to the aircraft's entry in the CPR packet side table.
+     */
+    inline CPRPacketPair &GetCPRPacketPair(const Aircraft &aircraft) {
+        return cpr_packet_pairs_[dict.GetSlotIndex(&aircraft)];
+    }
+
+    /**
+     * Returns the ADS-B message cache of an aircraft in the dictionary.
+     * @param[in] aircraft Reference to an Aircraft stored in dict.
+     * @retval Reference to the aircraft's entry in the ADS-B message cache side table.
+     */
+    inline ADSBMessageCache &GetADSBMessageCache(const Aircraft &aircraft) {
+        return adsb_message_caches_[dict.GetSlotIndex(&aircraft)];
+    }
+
+    /**
+     * Returns the pending ADS-B message of an aircraft in the dictionary.
+     * @param[in] aircraft Reference to an Aircraft stored in dict.
+     * @retval Reference to the aircraft's entry in the pending ADS-B message side table.
+     */
+    inline PendingADSBMessage &GetPendingADSBMessage(const Aircraft &aircraft) {
+        return pending_adsb_messages_[dict.GetSlotIndex(&aircraft)];
+    }
+
+    /**
+     * Sets an aircraft's barometric altitude from a Mode C or Mode S reply, unless the altitude code in the reply
+     * couldn't be decoded.
+     * @param[in] aircraft Aircraft to update.
+     * @param[in] altitude_ft Altitude decoded from the reply's 13-bit altitude code.
+     */
+    void ApplyReplyAltitude(Aircraft &aircraft, int32_t altitude_ft);
+
+    /**
+     * Records a sighting of an aircraft that isn't in the dictionary yet, from a packet that can't be trusted to add it
+     * to the dictionary on its own.
+     * @param[in] icao_address ICAO address of the candidate aircraft.
+     * @retval True if the aircraft has been confirmed and can be added to the dictionary, false otherwise.
+     */
+    bool ConfirmCandidateAircraft(uint32_t icao_address);
+
+    /**
+     * Removes an aircraft from the dictionary according to the eviction policy, to make room for a new aircraft.
+     * Called when the dictionary is full.
+     * @retval True if an aircraft was evicted, false if the policy doesn't allow eviction.
+     */
+    bool EvictAircraft();
+
+    /**
+     * Sets an aircraft's last message timestamp to the current time, and moves it to the back of the expiry list.
+     * @param[in] aircraft Reference to an Aircraft stored in dict.
+     */
+    inline void UpdateLastMessageTimestamp(Aircraft &aircraft) {
+        aircraft.last_message_timestamp_ms = get_time_since_boot_ms();
+        expiry_list_.MoveToBack(dict.GetSlotIndex(&aircraft));
+    }
 
     AircraftDictionaryConfig_t config_;
+    // Side tables of information that is only needed while ingesting specific messages, indexed by the aircraft's slot
+    // in dict.
+    AircraftDetails aircraft_details_[kMaxNumAircraft];
+    CPRPacketPair cpr_packet_pairs_[kMaxNumAircraft];
+    ADSBMessageCache adsb_message_caches_[kMaxNumAircraft];
+    PendingADSBMessage pending_adsb_messages_[kMaxNumAircraft];
+    // Slots of the aircraft in dict, ordered from oldest to newest last_message_timestamp_ms.
+    IndexedLinkedList<kMaxNumAircraft> expiry_list_;
+    AircraftCandidateTable candidate_table_;
+    RecentICAOAddressSet recent_icao_addresses_;
 };
 
 #endif /* _AIRCRAFT_DICTIONARY_HH_ */
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "decode_utils.hh"
 
+#include <array>
 #include <cmath>
 
 #include "unit_conversions.hh"
@@ -14,64 +15,10 @@ char LookupCallsignChar(uint8_t value) {
     return callsign_char_array[value];
 }
 
-int32_t GillhamToAltitudeFt(uint16_t gillham_value)
-// Data must be in following order (MSB to LSB)
-// D1 D2 D4 A1 A2 A4 B1 B2 B4 C1 C2 C4
-{
-    int32_t result;
-    int16_t five_hundreds;
-    int16_t one_hundreds;
-
-    // Convert Gillham value using gray code to binary conversion algorithm.
-    // Get rid of Hundreds (lower 3 bits).
-    five_hundreds = gillham_value >> 3;
-
-    // Strip off Five Hundreds leaving lower 3 bits.
-    one_hundreds = gillham_value & 0x07;
-
-    five_hundreds = GrayToBinary(five_hundreds);
-    one_hundreds = GrayToBinary(one_hundreds);
-
-    // Check for invalid codes.
-    if (one_hundreds == 5 || one_hundreds == 6 || one_hundreds == 0) {
-        result = kAltitudeDecodeErrorGillhamDecodeError;
-        return result;
-    }
-
-    // Remove 7s from one_hundreds.
-    if (one_hundreds == 7) one_hundreds = 5;
-
-    // Correct order of one_hundreds.
-    if (five_hundreds % 2) one_hundreds = 6 - one_hundreds;
-
-    // Convert to feet and apply altitude datum offset.
-    result = (int32_t)((five_hundreds * 500) + (one_hundreds * 100)) - 1300;
-
-    return result;
-}
-
-uint16_t AltitudeCodeToGillham(uint16_t altitude_code) {
-    uint8_t d1 = (altitude_code & (0b1 << 4)) >> 4;
-    uint8_t d2 = (altitude_code & (0b1 << 2)) >> 2;
-    uint8_t d4 = altitude_code & 0b1;
-
-    uint8_t a1 = (altitude_code & (0b1 << 11)) >> 11;
-    uint8_t a2 = (altitude_code & (0b1 << 9)) >> 9;
-    uint8_t a4 = (altitude_code & (0b1 << 7)) >> 7;
-
-    uint8_t b1 = (altitude_code & (0b1 << 5)) >> 5;
-    uint8_t b2 = (altitude_code & (0b1 << 3)) >> 3;
-    uint8_t b4 = (altitude_code & (0b1 << 1)) >> 1;
-
-    uint8_t c1 = (altitude_code & (0b1 << 12)) >> 12;
-    uint8_t c2 = (altitude_code & (0b1 << 10)) >> 10;
-    uint8_t c4 = (altitude_code & (0b1 << 8)) >> 8;
-
-    return (d1 << 11) | (d2 << 10) | (d4 << 9) | (a1 << 8) | (a2 << 7) | (a4 << 6) | (b1 << 5) | (b2 << 4) | (b4 << 3) |
-           (c1 << 2) | (c2 << 1) | c4;
-}
-
-int32_t AltitudeCodeToAltitudeFt(uint16_t altitude_code) {
+/**
+ * Decodes a 13-bit Mode C altitude code with bit manipulation. Only used to build kAltitudeCodeTable.
+ */
+static constexpr int32_t CalculateAltitudeCodeAltitudeFt(uint16_t altitude_code) {
     // Altitude Code Format
     //                                     M        Q
     // +----+----+----+----+----+----+---+----+---+----+----+----+----+
@@ -103,7 +50,10 @@ int32_t AltitudeCodeToAltitudeFt(uint16_t altitude_code) {
     }
 }
 
-uint16_t IdentityCodeToSquawk(uint16_t identity_code) {
+/**
+ * Decodes a 13-bit Mode A identity code with bit manipulation. Only used to build kIdentityCodeTable.
+ */
+static constexpr uint16_t CalculateIdentityCodeSquawk(uint16_t identity_code) {
     uint8_t d1 = (identity_code & (0b1 << 4)) >> 4;
     uint8_t d2 = (identity_code & (0b1 << 2)) >> 2;
     uint8_t d4 = identity_code & 0b1;
@@ -124,23 +74,145 @@ uint16_t IdentityCodeToSquawk(uint16_t identity_code) {
            (d4 << 2) | (d2 << 1) | d1;
 }
 
-uint16_t CalcNLCPRFromLat(float lat) {
-    lat = floorf(lat);
-
-    // Special cases.
-    if (lat == 0) {
-        return 59;  // On the equator.
-    } else if (lat == 87) {
-        return 2;  // Near the north pole.
-    } else if (lat == -87) {
-        return 2;  // Near the south pole.
-    } else if (lat > 87) {
-        return 1;  // In the north pole bin.
-    } else if (lat < -87) {
-        return 1;  // In the south pole bin.
+static constexpr std::array<int32_t, kNumAltitudeCodes> GenerateAltitudeCodeTable() {
+    std::array<int32_t, kNumAltitudeCodes> table = {};
+    for (uint16_t i = 0; i < kNumAltitudeCodes; i++) {
+        table[i] = CalculateAltitudeCodeAltitudeFt(i);
+    }
+    return table;
+}
+
+static constexpr std::array<uint16_t, kNumAltitudeCodes> GenerateIdentityCodeTable() {
+    std::array<uint16_t, kNumAltitudeCodes> table = {};
+    for (uint16_t i = 0; i < kNumAltitudeCodes; i++) {
+        table[i] = CalculateIdentityCodeSquawk(i);
     }
+    return table;
+}
+
+// Altitudes and squawks for every 13-bit AC / ID code. Mode A/C replies are the highest rate traffic, so decoding them
+// is a single lookup in flash (48kB total) instead of a few dozen masks and shifts.
+static constexpr std::array<int32_t, kNumAltitudeCodes> kAltitudeCodeTable = GenerateAltitudeCodeTable();
+static constexpr std::array<uint16_t, kNumAltitudeCodes> kIdentityCodeTable = GenerateIdentityCodeTable();
 
-    // Equation 5.3
-    return floorf(2.0f * (float)M_PI /
-                  acosf(1 - (1 - cosf((float)M_PI / (2.0f * kCPRNz))) / powf(cosf((float)M_PI / 180.0f * lat), 2)));
-}
\ No newline at end of file
+int32_t AltitudeCodeToAltitudeFt(uint16_t altitude_code) {
+    return kAltitudeCodeTable[altitude_code & (kNumAltitudeCodes - 1)];
+}
+
+uint16_t IdentityCodeToSquawk(uint16_t identity_code) {
+    return kIdentityCodeTable[identity_code & (kNumAltitudeCodes - 1)];
+}
+
+// Rotation angles atan(2^-i) of each CORDIC iteration, in BAM. 12 iterations leave a residual angle below 0.03 degrees,
+// which is well within the 0.1 degree resolution that tracks are reported with.
+static const uint16_t kCORDICNumIterations = 12;
+static const uint32_t kCORDICAnglesBAM[kCORDICNumIterations] = {536870912, 316933406, 167458907, 85004756,
+                                                                42667331,  21354465,  10679838,  5340245,
+                                                                2670163,   1335087,   667544,    333772};
+// Velocity components are scaled up by 2^16 so that truncation in the CORDIC shifts doesn't affect the result. The
+// largest vector (4096kts * sqrt(2) * K) still fits in an int32_t.
+static const uint16_t kCORDICFractionBits = 16;
+// 1000 * 2^32 / (2^16 * K), where K = prod(sqrt(1 + 2^-2i)) ~= 1.64676 is the gain of kCORDICNumIterations CORDIC
+// iterations. Converts the scaled CORDIC magnitude to thousandths of a knot with a single multiply.
+static const uint32_t kCORDICMagnitudeToE3 = 39796930;
+
+void CalcGroundSpeedAndTrack(int32_t v_ew_kts, int32_t v_ns_kts, uint32_t &ground_speed_kts_e3, uint32_t &track_bam) {
+    // Vectoring mode CORDIC: rotate (x, y) = (north, east) onto the x axis while accumulating the rotation angle. Track
+    // is measured clockwise from north, which is the angle from the x axis towards the y axis.
+    int32_t x = v_ns_kts * (1 << kCORDICFractionBits);
+    int32_t y = v_ew_kts * (1 << kCORDICFractionBits);
+    uint32_t angle_bam = 0;
+    if (x < 0) {
+        // CORDIC only converges for angles within +/-99.7 degrees, so flip vectors that point south.
+        x = -x;
+        y = -y;
+        angle_bam = 1u << 31;  // 180 degrees.
+    }
+    if (y == 0) {
+        // Due north or south (or not moving). Skip the iterations, which would dither around the x axis.
+        ground_speed_kts_e3 = static_cast<uint32_t>(x >> kCORDICFractionBits) * 1000;
+        track_bam = angle_bam;
+        return;
+    }
+    for (uint16_t i = 0; i < kCORDICNumIterations; i++) {
+        // Rotate towards the x axis without branching, since the direction of each step is unpredictable.
+        // (a ^ sign) - sign is a when sign is 0, and -a when sign is -1.
+        int32_t sign = y >> 31;
+        int32_t x_shifted = x >> i;
+        int32_t y_shifted = y >> i;
+        x += (y_shifted ^ sign) - sign;
+        y -= (x_shifted ^ sign) - sign;
+        angle_bam += (kCORDICAnglesBAM[i] ^ static_cast<uint32_t>(sign)) - static_cast<uint32_t>(sign);
+    }
+    // x is now the magnitude of the vector, scaled by 2^16 and the CORDIC gain.
+    ground_speed_kts_e3 =
+        static_cast<uint32_t>((static_cast<uint64_t>(x) * kCORDICMagnitudeToE3 + (1ull << 31)) >> kBAMNumBits);
+    track_bam = angle_bam;
+}
+
+// Latitudes (in degrees, ascending) at which the number of CPR longitude zones drops by one, starting with the 59 -> 58
+// transition and ending with the 2 -> 1 transition at 87 degrees. Computed with Equation 5.3.
+static const uint16_t kCPRNumNLTransitionLatitudes = 58;
+static constexpr double kCPRNLTransitionLatitudesDeg[kCPRNumNLTransitionLatitudes] = {
+    10.47047130, 14.82817437, 18.18626357, 21.02939493, 23.54504487, 25.82924707,
+    27.93898710, 29.91135686, 31.77209708, 33.53993436, 35.22899598, 36.85025108,
+    38.41241892, 39.92256684, 41.38651832, 42.80914012, 44.19454951, 45.54626723,
+    46.86733252, 48.16039128, 49.42776439, 50.67150166, 51.89342469, 53.09516153,
+    54.27817472, 55.44378444, 56.59318756, 57.72747354, 58.84763776, 59.95459277,
+    61.04917774, 62.13216659, 63.20427479, 64.26616523, 65.31845310, 66.36171008,
+    67.39646774, 68.42322022, 69.44242631, 70.45451075, 71.45986473, 72.45884545,
+    73.45177442, 74.43893416, 75.42056257, 76.39684391, 77.36789461, 78.33374083,
+    79.29428225, 80.24923213, 81.19801349, 82.13956981, 83.07199445, 83.99173563,
+    84.89166191, 85.75541621, 86.53536998, 87.00000000};
+
+// Search tables are padded to a power of 2 with values larger than any latitude, so that the binary search in
+// CalcNLFromTransitionTable doesn't need a bounds check.
+static const uint16_t kCPRNLSearchTableLen = 64;
+
+static constexpr std::array<float, kCPRNLSearchTableLen> GenerateNLTransitionTableDeg() {
+    std::array<float, kCPRNLSearchTableLen> table = {};
+    for (uint16_t i = 0; i < kCPRNLSearchTableLen; i++) {
+        table[i] = i < kCPRNumNLTransitionLatitudes ? static_cast<float>(kCPRNLTransitionLatitudesDeg[i]) : INFINITY;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, kCPRNLSearchTableLen> GenerateNLTransitionTableBAM() {
+    std::array<uint32_t, kCPRNLSearchTableLen> table = {};
+    for (uint16_t i = 0; i < kCPRNLSearchTableLen; i++) {
+        table[i] = i < kCPRNumNLTransitionLatitudes
+                       ? static_cast<uint32_t>(kCPRNLTransitionLatitudesDeg[i] / 360.0 * 4294967296.0)
+                       : UINT32_MAX;
+    }
+    return table;
+}
+
+static constexpr std::array<float, kCPRNLSearchTableLen> kCPRNLTransitionLatitudesSearchTableDeg =
+    GenerateNLTransitionTableDeg();
+static constexpr std::array<uint32_t, kCPRNLSearchTableLen> kCPRNLTransitionLatitudesSearchTableBAM =
+    GenerateNLTransitionTableBAM();
+
+/**
+ * Counts the number of transition latitudes below abs_lat with a fixed-length binary search, and uses it to find NL.
+ * @param[in] table Transition latitude search table.
+ * @param[in] abs_lat Absolute value of latitude, in the same units as table. NL is symmetric about the equator.
+ * @retval NL at abs_lat.
+ */
+template <typename T>
+static inline uint16_t CalcNLFromTransitionTable(const std::array<T, kCPRNLSearchTableLen> &table, T abs_lat) {
+    uint16_t num_transitions_below = 0;
+    for (uint16_t step = kCPRNLSearchTableLen / 2; step > 0; step >>= 1) {
+        num_transitions_below += table[num_transitions_below + step - 1] < abs_lat ? step : 0;
+    }
+    return kCPRNumNLTransitionLatitudes + 1 - num_transitions_below;
+}
+
+uint16_t CalcNLCPRFromLat(float lat) {
+    return CalcNLFromTransitionTable(kCPRNLTransitionLatitudesSearchTableDeg, fabsf(lat));
+}
+
+uint16_t CalcNLCPRFromLatBAM(int32_t lat_bam) {
+    // Negate as unsigned so that INT32_MIN doesn't overflow.
+    uint32_t abs_lat_bam = lat_bam < 0 ? 0u - static_cast<uint32_t>(lat_bam) : static_cast<uint32_t>(lat_bam);
+    return CalcNLFromTransitionTable(kCPRNLTransitionLatitudesSearchTableBAM, abs_lat_bam);
+}
@@ -1,12 +1,27 @@
 #ifndef DECODE_UTILS_HH_
 #define DECODE_UTILS_HH_
 
+#include <cmath>
 #include <cstdint>
 
-const uint16_t kCPRNz = 15;                           // number of latitude zones between equator and a pole
-const float kCPRdLatEven = 360.0f / (4 * kCPRNz);     // size of latitude zone for even message
-const float kCPRdLatOdd = 360.0f / (4 * kCPRNz - 1);  // size of latitude zone for odd message
-const uint32_t kCPRLatLonMaxCount = (2 << 16) - 1;    // 2^17
+const uint16_t kCPRNz = 15;                              // number of latitude zones between equator and a pole
+const uint16_t kCPRNumLatZonesEven = 4 * kCPRNz;         // number of latitude zones for even message
+const uint16_t kCPRNumLatZonesOdd = 4 * kCPRNz - 1;      // number of latitude zones for odd message
+const uint16_t kCPRCountNumBits = 17;                    // CPR lat / lon counts are a 17-bit fraction of a zone
+const uint32_t kCPRNumCounts = 1 << kCPRCountNumBits;    // 2^17
+const uint32_t kCPRLatLonMaxCount = kCPRNumCounts - 1;  // 2^17 - 1
+
+// CPR positions are decoded in binary angle units (BAM), where 2^32 BAM is one full turn. A latitude or longitude in
+// BAM is a signed 32-bit value in [-180, 180) degrees, so wrapping angles is free and precision is the same everywhere.
+const uint16_t kBAMNumBits = 32;
+const int32_t kBAM90Deg = 1 << 30;
+
+const float kSurfaceMovementNotAvailable = -1.0f;
+
+// Mode C altitude codes (AC) and Mode A identity codes (ID) are 13 bits long, and are decoded with lookup tables that
+// cover every possible code.
+const uint16_t kAltitudeCodeNumBits = 13;
+const uint16_t kNumAltitudeCodes = 1 << kAltitudeCodeNumBits;
 
 enum kAltitudeDecodeError : int32_t {
     kAltitudeDecodeErrorGillhamDecodeError = -9,
@@ -26,7 +41,7 @@ char LookupCallsignChar(uint8_t value);
  * @param[in] num 16-bit Gray-coded value.
  * @retval 16-bit binary-coded value.
  */
-inline uint16_t GrayToBinary(uint16_t num) {
+constexpr uint16_t GrayToBinary(uint16_t num) {
     uint16_t temp = num ^ (num >> 8);
     temp ^= (temp >> 4);
     temp ^= (temp >> 2);
@@ -41,7 +56,26 @@ inline uint16_t GrayToBinary(uint16_t num) {
  *                              D1 D2 D4 A1 A2 A4 B1 B2 B4 C1 C2 C4.
  * @retval Signed altitude in feet.
  */
-int32_t GillhamToAltitudeFt(uint16_t gillham_value);
+constexpr int32_t GillhamToAltitudeFt(uint16_t gillham_value) {
+    // Convert Gillham value using gray code to binary conversion algorithm.
+    // Get rid of Hundreds (lower 3 bits), and strip off Five Hundreds leaving lower 3 bits.
+    int16_t five_hundreds = GrayToBinary(gillham_value >> 3);
+    int16_t one_hundreds = GrayToBinary(gillham_value & 0x07);
+
+    // Check for invalid codes.
+    if (one_hundreds == 5 || one_hundreds == 6 || one_hundreds == 0) {
+        return kAltitudeDecodeErrorGillhamDecodeError;
+    }
+
+    // Remove 7s from one_hundreds.
+    if (one_hundreds == 7) one_hundreds = 5;
+
+    // Correct order of one_hundreds.
+    if (five_hundreds % 2) one_hundreds = 6 - one_hundreds;
+
+    // Convert to feet and apply altitude datum offset.
+    return (int32_t)((five_hundreds * 500) + (one_hundreds * 100)) - 1300;
+}
 
 /**
  * Rearranges the Altitude Code (AC) field of a Mode C (Surveillance Altitude Reply) packet into the gillham encoded
@@ -51,45 +85,203 @@ int32_t GillhamToAltitudeFt(uint16_t gillham_value);
  * @retval Gillham encoded altitude value, in the format (MSB to LSB):
  *                              D1 D2 D4 A1 A2 A4 B1 B2 B4 C1 C2 C4.
  */
-uint16_t AltitudeCodeToGillham(uint16_t altitude_code);
+constexpr uint16_t AltitudeCodeToGillham(uint16_t altitude_code) {
+    uint8_t d1 = (altitude_code & (0b1 << 4)) >> 4;
+    uint8_t d2 = (altitude_code & (0b1 << 2)) >> 2;
+    uint8_t d4 = altitude_code & 0b1;
+
+    uint8_t a1 = (altitude_code & (0b1 << 11)) >> 11;
+    uint8_t a2 = (altitude_code & (0b1 << 9)) >> 9;
+    uint8_t a4 = (altitude_code & (0b1 << 7)) >> 7;
+
+    uint8_t b1 = (altitude_code & (0b1 << 5)) >> 5;
+    uint8_t b2 = (altitude_code & (0b1 << 3)) >> 3;
+    uint8_t b4 = (altitude_code & (0b1 << 1)) >> 1;
+
+    uint8_t c1 = (altitude_code & (0b1 << 12)) >> 12;
+    uint8_t c2 = (altitude_code & (0b1 << 10)) >> 10;
+    uint8_t c4 = (altitude_code & (0b1 << 8)) >> 8;
+
+    return (d1 << 11) | (d2 << 10) | (d4 << 9) | (a1 << 8) | (a2 << 7) | (a4 << 6) | (b1 << 5) | (b2 << 4) | (b4 << 3) |
+           (c1 << 2) | (c2 << 1) | c4;
+}
 
 /**
- * Converts a Mode C (Surveillance Altitude Reply) AC field into an altitude in ft. Uses GillhamToAltitudeFt and
- * AltitudeCodeToGillham for regular Mode C replies, but also handles cases where the altitude reply is in metric or
- * 25ft increment units.
+ * Converts a Mode C (Surveillance Altitude Reply) AC field into an altitude in ft. Regular Mode C replies are Gillham
+ * coded, but the altitude reply can also be in metric or 25ft increment units. Altitudes are looked up in a table that
+ * is generated at compile time with GillhamToAltitudeFt and AltitudeCodeToGillham.
  * @param[in] altitude_code Mode C packet AC field, in the format (MSB to LSB):
  *                              C1 A1 C2 A2 C4 A4 M(X) B1 Q(D1) B2 D2 B4 D4
- * @retval Pressure altitude in feet.
+ * Bits above the 13-bit AC field are ignored.
+ * @retval Pressure altitude in feet, kAltitudeDecodeErrorNotAvailableOrInvalid if the AC field is empty, or
+ * kAltitudeDecodeErrorGillhamDecodeError if the AC field is not a valid Gillham code.
  */
 int32_t AltitudeCodeToAltitudeFt(uint16_t altitude_code);
 
 /**
- * Converts a Mode A (Surveillance Identity Reply) ID field into a squawk code in octal.
+ * Converts a Mode A (Surveillance Identity Reply) ID field into a squawk code in octal, with a lookup table that is
+ * generated at compile time.
  * @param[in] identity_code Mode C packet ID field, in the format (MSB to LSB):
  *                              C1 A1 C2 A2 C4 A4 M(X) B1 Q(D1) B2 D2 B4 D4
+ * Bits above the 13-bit ID field are ignored.
  * @retval Squawk code in octal (12 bits).
  */
 uint16_t IdentityCodeToSquawk(uint16_t identity_code);
 
 /**
- * Calculate the number of longituide zones (between 1 and 59) at a given latitude.
+ * Converts the Movement field of a surface position message into a ground speed. Movement is quantized more finely at
+ * low speeds.
+ * @param[in] movement 7-bit movement field.
+ * @retval Ground speed in knots, or kSurfaceMovementNotAvailable if movement is not available or reserved.
+ */
+inline float SurfaceMovementToGroundSpeedKts(uint8_t movement) {
+    if (movement == 0 || movement > 124) {
+        return kSurfaceMovementNotAvailable;  // No information available, or reserved.
+    } else if (movement <= 8) {
+        return 0.125f * (movement - 1);  // Stopped (1), or 0.125kt - 1kt in 0.125kt steps.
+    } else if (movement <= 12) {
+        return 1.0f + 0.25f * (movement - 9);  // 1kt - 2kt in 0.25kt steps.
+    } else if (movement <= 38) {
+        return 2.0f + 0.5f * (movement - 13);  // 2kt - 15kt in 0.5kt steps.
+    } else if (movement <= 93) {
+        return 15.0f + (movement - 39);  // 15kt - 70kt in 1kt steps.
+    } else if (movement <= 108) {
+        return 70.0f + 2.0f * (movement - 94);  // 70kt - 100kt in 2kt steps.
+    } else if (movement <= 123) {
+        return 100.0f + 5.0f * (movement - 109);  // 100kt - 175kt in 5kt steps.
+    }
+    return 175.0f;  // >= 175kt.
+}
+
+/**
+ * Calculates ground speed and track angle from the east / west and north / south components of an airborne velocity,
+ * using an integer CORDIC.
+ * @param[in] v_ew_kts East / west velocity in knots, positive towards the east. Magnitude must be <= 4096kts.
+ * @param[in] v_ns_kts North / south velocity in knots, positive towards the north. Magnitude must be <= 4096kts.
+ * @param[out] ground_speed_kts_e3 Ground speed in thousandths of a knot, accurate to within 0.01kts.
+ * @param[out] track_bam Track angle clockwise from true north in BAM (2^32 BAM is a full turn), accurate to within
+ * 0.05 degrees. 0 if the aircraft is not moving.
+ */
+void CalcGroundSpeedAndTrack(int32_t v_ew_kts, int32_t v_ns_kts, uint32_t &ground_speed_kts_e3, uint32_t &track_bam);
+
+/**
+ * Calculate the number of longituide zones (between 1 and 59) at a given latitude. Uses a lookup table of the latitudes
+ * where NL changes instead of evaluating Equation 5.3, so it's cheap enough to call for every airborne and surface
+ * position decode.
  * @param[in] lat Latitude to calculate NL (number of longitude zones) at.
  * @retval NL (number of longitude zones) in the Compact Position Reporting (CPR) representation at the given latitude.
  */
 uint16_t CalcNLCPRFromLat(float lat);
 
 /**
- * Wrap southern hemisphere latitudes resulting from CPR decode. Transforms latitude from [270, 360] to [-90, 90].
- * @param[in] latitude Latitude in degrees.
- * @retval Wrapped latitude.
+ * Integer version of CalcNLCPRFromLat, for latitudes in binary angle units.
+ * @param[in] lat_bam Latitude to calculate NL at, in BAM.
+ * @retval NL (number of longitude zones) in the Compact Position Reporting (CPR) representation at the given latitude.
  */
-inline float WrapCPRDecodeLatitude(float latitude) { return latitude >= 270.0f ? latitude - 360.0f : latitude; }
+uint16_t CalcNLCPRFromLatBAM(int32_t lat_bam);
 
 /**
- * Wrap longitude floating point value to conventional values. Transforms longitude from [0, 360] to [-180, 180].
- * @param[in] longitude Longitude in degrees.
- * @retval Wrapped longitude.
+ * Converts a CPR zone index and a 17-bit CPR count within that zone into an angle. Used to build latitudes and
+ * longitudes from decoded CPR zones (e.g. Equation 5.7 and 5.13).
+ * @param[in] zone_index Index of the zone, can be negative or greater than num_zones for locally decoded positions.
+ * @param[in] n_cpr 17-bit CPR count within the zone.
+ * @param[in] num_zones Number of zones in a full turn.
+ * @retval Angle in BAM, wrapped to [-180, 180) degrees.
  */
-inline float WrapCPRDecodeLongitude(float longitude) { return longitude >= 180.0f ? longitude - 360.0f : longitude; }
+inline int32_t CPRZoneToBAM(int32_t zone_index, uint32_t n_cpr, uint16_t num_zones) {
+    int64_t zone_counts = (static_cast<int64_t>(zone_index) << kCPRCountNumBits) + n_cpr;
+    // Conversion to uint32_t wraps the angle to a single turn.
+    return static_cast<int32_t>(
+        static_cast<uint32_t>((zone_counts << (kBAMNumBits - kCPRCountNumBits)) / static_cast<int64_t>(num_zones)));
+}
+
+/**
+ * Calculate the index of the CPR zone that a locally decoded coordinate falls in, picking the zone that puts the
+ * decoded coordinate closest to a reference coordinate. Used for locally unambiguous CPR decoding.
+ * @param[in] ref_bam Reference latitude or longitude, in BAM.
+ * @param[in] n_cpr 17-bit CPR count within the zone.
+ * @param[in] num_zones Number of zones in a full turn.
+ * @retval Index of the zone containing the decoded coordinate (may be negative).
+ */
+inline int32_t CalcCPRLocalZoneIndex(int32_t ref_bam, uint32_t n_cpr, uint16_t num_zones) {
+    // Reference coordinate in 2^-17ths of a zone.
+    int64_t ref_zone_counts = (static_cast<int64_t>(ref_bam) * num_zones) >> (kBAMNumBits - kCPRCountNumBits);
+    // floor(ref / zone_size + 0.5 - n_cpr / 2^17)
+    return static_cast<int32_t>((ref_zone_counts + (kCPRNumCounts >> 1) - n_cpr) >> kCPRCountNumBits);
+}
+
+/**
+ * Modulo operation that always returns a positive value, as used by the CPR equations.
+ * @param[in] a Dividend.
+ * @param[in] b Divisor.
+ * @retval a mod b, in [0, b).
+ */
+inline int32_t CPRMod(int32_t a, int32_t b) {
+    int32_t result = a % b;
+    return result < 0 ? result + b : result;
+}
+
+/**
+ * Converts an angle in binary angle units to degrees * 1e7.
+ * @param[in] bam Angle in BAM.
+ * @retval Angle in degrees * 1e7, rounded to the nearest unit.
+ */
+inline int32_t BAMToDegE7(int32_t bam) {
+    return static_cast<int32_t>((static_cast<int64_t>(bam) * 3'600'000'000 + (1ll << 31)) >> kBAMNumBits);
+}
+
+/**
+ * Converts an angle in degrees * 1e7 to binary angle units.
+ * @param[in] deg_e7 Angle in degrees * 1e7.
+ * @retval Angle in BAM, wrapped to [-180, 180) degrees.
+ */
+inline int32_t DegE7ToBAM(int32_t deg_e7) {
+    // 2^32 / 3.6e9 = 1 + 829128280 / 2^32. Split the multiplication so that the product fits in 64 bits.
+    int32_t fractional_part =
+        static_cast<int32_t>((static_cast<int64_t>(deg_e7) * 829'128'280 + (1ll << 31)) >> kBAMNumBits);
+    return static_cast<int32_t>(static_cast<uint32_t>(deg_e7) + static_cast<uint32_t>(fractional_part));
+}
+
+// Blocks of 24-bit ICAO addresses that have been allocated to states or to ICAO, from ICAO Annex 10 Vol III Ch. 9.
+// Neighboring state allocations are merged into regional blocks. Sorted by address.
+struct ICAOAddressBlock {
+    uint32_t first_address;
+    uint32_t last_address;
+};
+inline constexpr ICAOAddressBlock kAllocatedICAOAddressBlocks[] = {
+    {0x004000, 0x0DFFFF},  // Africa, Caribbean, Central America, and northern South America (Zimbabwe to Venezuela).
+    {0x100000, 0x1FFFFF},  // Russian Federation.
+    {0x201000, 0x2023FF},  // Namibia, Eritrea.
+    {0x300000, 0x4D43FF},  // Europe (Italy to Monaco).
+    {0x500000, 0x5163FF},  // Europe (San Marino to Montenegro).
+    {0x600000, 0x601BFF},  // Armenia, Azerbaijan, Kyrgyzstan, Turkmenistan.
+    {0x680000, 0x6843FF},  // Bhutan, Micronesia, Mongolia, Kazakhstan, Palau.
+    {0x700000, 0x8AFFFF},  // Asia (Afghanistan to Indonesia).
+    {0x900000, 0x9023FF},  // Marshall Islands, Cook Islands, Samoa.
+    {0xA00000, 0xAFFFFF},  // United States.
+    {0xC00000, 0xC3FFFF},  // Canada.
+    {0xC80000, 0xC903FF},  // Oceania (New Zealand to Vanuatu).
+    {0xE00000, 0xE94FFF},  // South America (Argentina to Bolivia).
+    {0xF00000, 0xF07FFF},  // ICAO temporary addresses.
+    {0xF09000, 0xF093FF},  // ICAO special use.
+};
+
+/**
+ * Checks whether an ICAO address is in a block that has been allocated to a state. Addresses outside of these blocks
+ * aren't assigned to any aircraft, and usually come from packets with bit errors in their address / parity field.
+ * @param[in] icao_address 24-bit ICAO address.
+ * @retval True if the address has been allocated, false otherwise.
+ */
+constexpr bool IsAllocatedICAOAddress(uint32_t icao_address) {
+    for (const ICAOAddressBlock &block : kAllocatedICAOAddressBlocks) {
+        if (icao_address < block.first_address) {
+            return false;  // Blocks are sorted, so the address falls in a gap.
+        }
+        if (icao_address <= block.last_address) {
+            return true;
+        }
+    }
+    return false;
+}
 
 #endif /* DECODE_UTILS_HH_ */
\ No newline at end of file
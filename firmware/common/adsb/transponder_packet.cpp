@@ -1,78 +1,197 @@
 #include "transponder_packet.hh"
 
+#include <array>
 #include <cstdint>
 #include <cstdio>   // for snprintf
 #include <cstring>  // for strlen
 
 #include "comms.hh"  // For debug prints.
 #include "decode_utils.hh"
+#include "macros.hh"
 
 #define BYTES_PER_WORD_32 4
 #define BITS_PER_WORD_32  32
 #define BYTES_PER_WORD_24 3
 #define BITS_PER_WORD_24  24
-#define BITS_PER_WORD_25  25
 #define BITS_PER_BYTE     8
 #define NIBBLES_PER_BYTE  2
 #define BITS_PER_NIBBLE   4
 
 #define MASK_MSBIT_WORD24 (0b1 << (BITS_PER_WORD_24 - 1))
-#define MASK_MSBIT_WORD25 (0b1 << BITS_PER_WORD_24)
 #define MASK_WORD24       0xFFFFFF
 
 #define CHAR_TO_HEX(c)    ((c >= 'A') ? (c >= 'a') ? (c - 'a' + 10) : (c - 'A' + 10) : (c - '0'))
 
-const uint32_t kExtendedSquitterLastWordIngestionMask = 0xFFFF0000;
 const uint32_t kExtendedSquitterLastWordPopCount = 16;
-const uint32_t kSquitterLastWordIngestionMask = 0xFFFFFF00;
 const uint32_t kSquitterLastWordPopCount = 24;
 
-const uint32_t kCRC24Generator = 0x1FFF409;
-const uint16_t kCRC24GeneratorNumBits = 25;
+// Syndrome table for correcting bit errors in 112-bit packets. Each entry packs a 24-bit CRC syndrome with the index of
+// the (first) flipped bit that produces it. Entries for 2-bit errors are flagged, and the second bit index is found by
+// looking up the residual single-bit syndrome. All 1-bit and 2-bit syndromes are unique for 112-bit packets.
+const uint16_t kSyndromeTableNumEntries = 8192;  // Power of 2, fits 112 + 112 * 111 / 2 = 6328 syndromes.
+const uint16_t kSyndromeTableIndexNumBits = 13;
+const uint32_t kSyndromeTableEntrySyndromeMask = 0xFFFFFF;
+const uint16_t kSyndromeTableEntryBitIndexShift = 24;
+const uint32_t kSyndromeTableEntryBitIndexMask = 0x7F;
+const uint32_t kSyndromeTableEntryTwoBitFlag = 0b1 << 31;
 
-/** DecodedTransponderPacket **/
+/**
+ * Calculates the CRC syndrome (calculated CRC XOR parity field) for a 112-bit packet with a single bit flipped.
+ * @param[in] bit_index Index of the flipped bit. MSb of the packet is bit 0.
+ * @retval 24-bit syndrome.
+ */
+constexpr uint32_t CalculateSingleBitErrorSyndrome(uint16_t bit_index) {
+    const uint16_t kParityFirstBitIndex = DecodedTransponderPacket::kExtendedSquitterPacketLenBits - BITS_PER_WORD_24;
+    if (bit_index >= kParityFirstBitIndex) {
+        // Errors in the parity field show up directly in the syndrome.
+        return 0b1 << (DecodedTransponderPacket::kExtendedSquitterPacketLenBits - 1 - bit_index);
+    }
+    uint32_t buffer[DecodedTransponderPacket::kExtendedSquitterPacketNumWords32] = {0};
+    buffer[bit_index / BITS_PER_WORD_32] = 0x80000000 >> (bit_index % BITS_PER_WORD_32);
+    return CalculateCRC24(buffer, DecodedTransponderPacket::kExtendedSquitterPacketLenBits);
+}
 
-RawTransponderPacket::RawTransponderPacket(uint32_t rx_buffer[kMaxPacketLenWords32], uint16_t rx_buffer_len_words32,
-                                           int rssi_dbm_in, uint64_t mlat_48mhz_64bit_counts_in) {
-    // Set the last word indgestion behavior based on packet length.
-    uint32_t last_word_ingestion_mask, last_word_popcount;
-    if (rx_buffer_len_words32 > 2) {
-        // 112 bit packet (Extended Squitter)
-        last_word_ingestion_mask = kExtendedSquitterLastWordIngestionMask;
-        last_word_popcount = kExtendedSquitterLastWordPopCount;
+constexpr std::array<uint32_t, DecodedTransponderPacket::kExtendedSquitterPacketLenBits>
+GenerateSingleBitErrorSyndromes() {
+    std::array<uint32_t, DecodedTransponderPacket::kExtendedSquitterPacketLenBits> syndromes = {};
+    for (uint16_t i = 0; i < DecodedTransponderPacket::kExtendedSquitterPacketLenBits; i++) {
+        syndromes[i] = CalculateSingleBitErrorSyndrome(i);
+    }
+    return syndromes;
+}
+
+constexpr std::array<uint32_t, DecodedTransponderPacket::kExtendedSquitterPacketLenBits> kSingleBitErrorSyndromes =
+    GenerateSingleBitErrorSyndromes();
+
+constexpr uint16_t SyndromeTableHash(uint32_t syndrome) {
+    return (syndrome * 2654435761u) >> (BITS_PER_WORD_32 - kSyndromeTableIndexNumBits);  // Fibonacci hashing.
+}
+
+constexpr void InsertSyndrome(std::array<uint32_t, kSyndromeTableNumEntries> &table, uint32_t entry) {
+    uint16_t index = SyndromeTableHash(entry & kSyndromeTableEntrySyndromeMask);
+    while (table[index] != 0) {
+        index = (index + 1) % kSyndromeTableNumEntries;  // Linear probing.
+    }
+    table[index] = entry;
+}
+
+constexpr std::array<uint32_t, kSyndromeTableNumEntries> GenerateSyndromeTable() {
+    std::array<uint32_t, kSyndromeTableNumEntries> table = {};  // Syndrome 0 is never an error, so 0 marks empty.
+    for (uint32_t i = 0; i < DecodedTransponderPacket::kExtendedSquitterPacketLenBits; i++) {
+        InsertSyndrome(table, kSingleBitErrorSyndromes[i] | (i << kSyndromeTableEntryBitIndexShift));
+        for (uint32_t j = i + 1; j < DecodedTransponderPacket::kExtendedSquitterPacketLenBits; j++) {
+            InsertSyndrome(table, (kSingleBitErrorSyndromes[i] ^ kSingleBitErrorSyndromes[j]) |
+                                      (i << kSyndromeTableEntryBitIndexShift) | kSyndromeTableEntryTwoBitFlag);
+        }
+    }
+    return table;
+}
+
+// Generated at compile time, lives in flash (32kB).
+constexpr std::array<uint32_t, kSyndromeTableNumEntries> kSyndromeTable = GenerateSyndromeTable();
+
+/**
+ * Looks up a syndrome in the syndrome table.
+ * @param[in] syndrome 24-bit syndrome to look up.
+ * @retval Matching syndrome table entry, or 0 if the syndrome doesn't correspond to a 1-bit or 2-bit error.
+ */
+uint32_t LookupSyndrome(uint32_t syndrome) {
+    uint16_t index = SyndromeTableHash(syndrome);
+    while (kSyndromeTable[index] != 0) {
+        if ((kSyndromeTable[index] & kSyndromeTableEntrySyndromeMask) == syndrome) {
+            return kSyndromeTable[index];
+        }
+        index = (index + 1) % kSyndromeTableNumEntries;
+    }
+    return 0;
+}
+
+/** ModeSFrame **/
+
+ModeSFrame::ModeSFrame(const uint32_t words[kMaxLenWords32], uint16_t len_bits) {
+    // Shifting the parity field into place drops any bits that were ingested past the end of the frame.
+    uint32_t parity;
+    if (len_bits > kShortFrameLenBits) {
+        message = (static_cast<uint64_t>(words[1]) << BITS_PER_WORD_24) | (words[2] >> BITS_PER_BYTE);
+        parity = ((words[2] & 0xFF) << 2 * BITS_PER_BYTE) | (words[3] >> 2 * BITS_PER_BYTE);
+    } else {
+        parity = words[1] >> BITS_PER_BYTE;
+    }
+    header_and_parity = (static_cast<uint64_t>(words[0]) << kParityNumBits) | parity;
+}
+
+void ModeSFrame::ToWords32(uint32_t words[kMaxLenWords32], uint16_t len_bits) const {
+    uint32_t parity = GetParity();
+    words[0] = GetHeader();
+    if (len_bits > kShortFrameLenBits) {
+        words[1] = static_cast<uint32_t>(message >> BITS_PER_WORD_24);
+        words[2] = (static_cast<uint32_t>(message) << BITS_PER_BYTE) | (parity >> 2 * BITS_PER_BYTE);
+        words[3] = parity << 2 * BITS_PER_BYTE;
+    } else {
+        words[1] = parity << BITS_PER_BYTE;
+        words[2] = 0;
+        words[3] = 0;
+    }
+}
+
+/**
+ * Shifts the lowest num_bytes bytes of a word into a running CRC24, MSB first.
+ */
+static inline uint32_t UpdateCRC24Word(uint32_t crc, uint32_t word, uint16_t num_bytes) {
+    for (int16_t shift = (num_bytes - 1) * BITS_PER_BYTE; shift >= 0; shift -= BITS_PER_BYTE) {
+        crc = UpdateCRC24(crc, word >> shift);
+    }
+    return crc;
+}
+
+uint32_t ModeSFrame::CalculateCRC24(uint16_t len_bits) const {
+    // Table-driven equivalent of the bit-serial algorithm from
+    // https://mode-s.org/decode/book-the_1090mhz_riddle-junzi_sun.pdf pg. 91, processed one byte at a time. The message
+    // is split into 32-bit halves so that the RP2040 doesn't need to do 64-bit shifts.
+    uint32_t crc = UpdateCRC24Word(0, GetHeader(), kHeaderNumBits / BITS_PER_BYTE);
+    if (len_bits > kShortFrameLenBits) {
+        crc = UpdateCRC24Word(crc, static_cast<uint32_t>(message >> BITS_PER_WORD_32), BYTES_PER_WORD_24);
+        crc = UpdateCRC24Word(crc, static_cast<uint32_t>(message), BYTES_PER_WORD_32);
+    }
+    return crc;
+}
+
+void ModeSFrame::FlipBit(uint16_t bit_index, uint16_t len_bits) {
+    if (bit_index < kHeaderNumBits) {
+        header_and_parity ^= 1ull << (kShortFrameLenBits - 1 - bit_index);
+    } else if (len_bits > kShortFrameLenBits && bit_index < kHeaderNumBits + kMessageNumBits) {
+        message ^= 1ull << (kHeaderNumBits + kMessageNumBits - 1 - bit_index);
     } else {
-        // 56 bit packet (Squitter)
-        last_word_ingestion_mask = kSquitterLastWordIngestionMask;
-        last_word_popcount = kSquitterLastWordPopCount;
+        header_and_parity ^= 1ull << (len_bits - 1 - bit_index);  // Parity field.
     }
+}
+
+/** DecodedTransponderPacket **/
 
-    // Pack the packet buffer.
+RawTransponderPacket::RawTransponderPacket(uint32_t rx_buffer[kMaxPacketLenWords32], uint16_t rx_buffer_len_words32,
+                                           int rssi_dbm_in, uint64_t mlat_48mhz_64bit_counts_in) {
+    // Set the number of bits used from the last word based on packet length.
+    uint32_t last_word_popcount =
+        rx_buffer_len_words32 > 2 ? kExtendedSquitterLastWordPopCount : kSquitterLastWordPopCount;
     for (uint16_t i = 0; i < rx_buffer_len_words32 && i < kMaxPacketLenWords32; i++) {
-        if (i == rx_buffer_len_words32 - 1) {
-            buffer[i] = rx_buffer[i] & last_word_ingestion_mask;  // Trim any crap off of last word.
-            buffer_len_bits += last_word_popcount;
-        } else {
-            buffer[i] = rx_buffer[i];
-            buffer_len_bits += BITS_PER_WORD_32;
-        }
+        buffer_len_bits += (i == rx_buffer_len_words32 - 1) ? last_word_popcount : BITS_PER_WORD_32;
     }
+    frame = ModeSFrame(rx_buffer, buffer_len_bits);
     rssi_dbm = rssi_dbm_in;
     mlat_48mhz_64bit_counts = mlat_48mhz_64bit_counts_in;
 }
 
 RawTransponderPacket::RawTransponderPacket(char *rx_string, int rssi_dbm_in, uint64_t mlat_48mhz_64bit_counts_in) {
+    uint32_t buffer[kMaxPacketLenWords32] = {0};
     uint16_t rx_num_bytes = strlen(rx_string) / NIBBLES_PER_BYTE;
     for (uint16_t i = 0; i < rx_num_bytes && i < kMaxPacketLenWords32 * BYTES_PER_WORD_32; i++) {
         uint8_t byte = (CHAR_TO_HEX(rx_string[i * NIBBLES_PER_BYTE]) << BITS_PER_NIBBLE) |
                        CHAR_TO_HEX(rx_string[i * NIBBLES_PER_BYTE + 1]);
         uint16_t byte_offset = i % BYTES_PER_WORD_32;  // number of Bytes to shift right from MSB of current word
-        if (byte_offset == 0) {
-            buffer[i / BYTES_PER_WORD_32] = byte << (3 * BITS_PER_BYTE);  // need to clear out the word
-        } else {
-            buffer[i / BYTES_PER_WORD_32] |= byte << ((3 - byte_offset) * BITS_PER_BYTE);
-        }
+        buffer[i / BYTES_PER_WORD_32] |= byte << ((3 - byte_offset) * BITS_PER_BYTE);
         buffer_len_bits += BITS_PER_BYTE;
     }
+    frame = ModeSFrame(buffer, buffer_len_bits);
     rssi_dbm = rssi_dbm_in;
     mlat_48mhz_64bit_counts = mlat_48mhz_64bit_counts_in;
 }
@@ -135,83 +254,148 @@ DecodedTransponderPacket::DownlinkFormat DecodedTransponderPacket::GetDownlinkFo
 }
 
 uint16_t DecodedTransponderPacket::DumpPacketBuffer(uint32_t to_buffer[kMaxPacketLenWords32]) const {
-    uint16_t bytes_written = packet.buffer_len_bits / BITS_PER_BYTE;
-    for (uint16_t i = 0; i < kMaxPacketLenWords32; i++) {
-        to_buffer[i] = packet.buffer[i];
-    }
-    return bytes_written;
+    packet.frame.ToWords32(to_buffer, packet.buffer_len_bits);
+    return packet.buffer_len_bits / BITS_PER_BYTE;
 }
 
 uint16_t DecodedTransponderPacket::DumpPacketBuffer(uint8_t to_buffer[kMaxPacketLenWords32 * kBytesPerWord]) const {
-    uint16_t bytes_written = packet.buffer_len_bits / BITS_PER_BYTE;
+    uint32_t buffer[kMaxPacketLenWords32];
+    packet.frame.ToWords32(buffer, packet.buffer_len_bits);
     for (uint16_t i = 0; i < kMaxPacketLenWords32; i++) {
         // First received bit is MSb.
-        to_buffer[i * kBytesPerWord] = packet.buffer[i] >> 24;
-        to_buffer[i * kBytesPerWord + 1] = (packet.buffer[i] >> 16) & 0xFF;
-        to_buffer[i * kBytesPerWord + 2] = (packet.buffer[i] >> 8) & 0xFF;
-        to_buffer[i * kBytesPerWord + 3] = packet.buffer[i] & 0xFF;
+        to_buffer[i * kBytesPerWord] = buffer[i] >> 24;
+        to_buffer[i * kBytesPerWord + 1] = (buffer[i] >> 16) & 0xFF;
+        to_buffer[i * kBytesPerWord + 2] = (buffer[i] >> 8) & 0xFF;
+        to_buffer[i * kBytesPerWord + 3] = buffer[i] & 0xFF;
     }
-    return bytes_written;
+    return packet.buffer_len_bits / BITS_PER_BYTE;
+}
+
+uint32_t DecodedTransponderPacket::Get24BitWordFromPacketBuffer(uint16_t first_bit_index) const {
+    uint32_t buffer[kMaxPacketLenWords32];
+    packet.frame.ToWords32(buffer, packet.buffer_len_bits);
+    return GetNBitWordFromBuffer(24, first_bit_index, buffer);
 }
 
 uint32_t DecodedTransponderPacket::CalculateCRC24(uint16_t packet_len_bits) const {
-    // CRC calculation algorithm from https://mode-s.org/decode/book-the_1090mhz_riddle-junzi_sun.pdf pg. 91.
-    // Must be called on buffer that does not have extra bit ingested at end and has all words left-aligned.
-    uint32_t crc_buffer[kMaxPacketLenWords32];
-    for (uint16_t i = 0; i < kMaxPacketLenWords32; i++) {
-        crc_buffer[i] = packet.buffer[i];
+    return packet.frame.CalculateCRC24(packet_len_bits);
+}
+
+uint16_t DecodedTransponderPacket::GetDebugString(char str_buf[kDebugStrLen]) const {
+    int num_chars = 0;
+    switch (decode_error_) {
+        case kDecodeErrorNone:
+            str_buf[0] = '\0';
+            break;
+        case kDecodeErrorBitLengthMismatch:
+            num_chars = snprintf(str_buf, kDebugStrLen,
+                                 "Bit number mismatch while decoding packet. Expected %d or %d but got %d!\r\n",
+                                 kExtendedSquitterPacketLenBits, kSquitterPacketLenBits, packet.buffer_len_bits);
+            break;
+        case kDecodeErrorInvalidChecksum:
+            num_chars =
+                snprintf(str_buf, kDebugStrLen, "Invalid checksum, expected %06lx but calculated %06lx.\r\n",
+                         packet.frame.GetParity(), CalculateCRC24(packet.buffer_len_bits));
+            break;
     }
+    return num_chars > 0 ? MIN(num_chars, kDebugStrLen - 1) : 0;
+}
 
-    // Overwrite 24-bit parity word with zeros.
-    SetNBitWordInBuffer(BITS_PER_WORD_24, 0x0, packet_len_bits - BITS_PER_WORD_24, crc_buffer);
+uint16_t DecodedTransponderPacket::CorrectBitErrors(uint16_t max_num_bits) {
+    if (is_valid_ || max_num_bits == 0 || packet.buffer_len_bits != kExtendedSquitterPacketLenBits ||
+        (downlink_format_ != kDownlinkFormatExtendedSquitter &&
+         downlink_format_ != kDownlinkFormatExtendedSquitterNonTransponder)) {
+        return 0;  // Only attempt to correct invalid ADS-B packets.
+    }
+
+    uint32_t syndrome = CalculateCRC24(packet.buffer_len_bits) ^ packet.frame.GetParity();
+    uint32_t entry = LookupSyndrome(syndrome);
+    if (entry == 0) {
+        return 0;  // Too many bit errors to correct.
+    }
 
-    // CRC is a conditional convolve operation using the 25-bit generator word.
-    for (uint16_t i = 0; i < packet_len_bits - BITS_PER_WORD_24; i++) {
-        uint32_t word = GetNBitWordFromBuffer(BITS_PER_WORD_25, i, crc_buffer);
-        if (word & MASK_MSBIT_WORD25) {
-            // Most significant bit is a 1. XOR with generator!
-            SetNBitWordInBuffer(BITS_PER_WORD_25, word ^ kCRC24Generator, i, crc_buffer);
+    uint16_t bit_indices[kMaxNumCorrectableBits];
+    uint16_t num_bits = 1;
+    bit_indices[0] = (entry >> kSyndromeTableEntryBitIndexShift) & kSyndromeTableEntryBitIndexMask;
+    if (entry & kSyndromeTableEntryTwoBitFlag) {
+        if (max_num_bits < 2) {
+            return 0;
         }
+        uint32_t residual_entry = LookupSyndrome(syndrome ^ kSingleBitErrorSyndromes[bit_indices[0]]);
+        bit_indices[num_bits++] =
+            (residual_entry >> kSyndromeTableEntryBitIndexShift) & kSyndromeTableEntryBitIndexMask;
     }
 
-    return GetNBitWordFromBuffer(BITS_PER_WORD_24, packet_len_bits - BITS_PER_WORD_24, crc_buffer);
+    for (uint16_t i = 0; i < num_bits; i++) {
+        if (bit_indices[i] < kDFNUmBits) {
+            // Packet was received with a DF that may not be its real one, don't risk turning it into ADS-B.
+            return 0;
+        }
+    }
+    for (uint16_t i = 0; i < num_bits; i++) {
+        packet.frame.FlipBit(bit_indices[i], packet.buffer_len_bits);
+    }
+
+    icao_address_ = packet.frame.GetHeader() & 0xFFFFFF;
+    is_valid_ = true;
+    decode_error_ = kDecodeErrorNone;
+    return num_bits;
+}
+
+bool DecodedTransponderPacket::HasAddressParity() const {
+    switch (static_cast<DownlinkFormat>(downlink_format_)) {
+        case kDownlinkFormatShortRangeAirToAirSurveillance:  // DF = 0
+        case kDownlinkFormatAltitudeReply:                   // DF = 4
+        case kDownlinkFormatIdentityReply:                   // DF = 5
+        case kDownlinkFormatLongRangeAirToAirSurveillance:   // DF = 16
+        case kDownlinkFormatCommBAltitudeReply:              // DF = 20
+        case kDownlinkFormatCommBIdentityReply:              // DF = 21
+            return true;
+        default:
+            return false;
+    }
 }
 
 void DecodedTransponderPacket::ConstructTransponderPacket() {
     if (packet.buffer_len_bits != kExtendedSquitterPacketLenBits && packet.buffer_len_bits != kSquitterPacketLenBits) {
-        snprintf(debug_string, kDebugStrLen,
-                 "Bit number mismatch while decoding packet. Expected %d or %d but got %d!\r\n",
-                 kExtendedSquitterPacketLenBits, kSquitterPacketLenBits, packet.buffer_len_bits);
-
+        decode_error_ = kDecodeErrorBitLengthMismatch;
         return;  // leave is_valid_ as false
     }
 
-    downlink_format_ = packet.buffer[0] >> 27;
+    downlink_format_ = packet.frame.GetHeader() >> (ModeSFrame::kHeaderNumBits - kDFNUmBits);
     uint32_t calculated_checksum = CalculateCRC24(packet.buffer_len_bits);
-    uint32_t parity_value = Get24BitWordFromBuffer(packet.buffer_len_bits - BITS_PER_WORD_24, packet.buffer);
+    uint32_t parity_value = packet.frame.GetParity();
+
+    if (HasAddressParity()) {
+        // Process a DF=0, 4, 5, 16, 20, or 21 message.
+        is_valid_ = false;  // Calculated checksum is XORed with the ICAO address. See ADS-B Decoding Guide pg. 22.
+        // ICAO address is a best guess, needs to be confirmed from the aircraft dictionary.
+        icao_address_ = parity_value ^ calculated_checksum;
+        return;
+    }
 
     switch (static_cast<DownlinkFormat>(downlink_format_)) {
-        case kDownlinkFormatShortRangeAirToAirSurveillance:  // DF = 0
-        case kDownlinkFormatAltitudeReply:                   // DF = 4
-        case kDownlinkFormatIdentityReply:                   // DF = 5
-        case kDownlinkFormatAllCallReply:                    // DF = 11
+        case kDownlinkFormatAllCallReply:  // DF = 11
         {
-            // Process a 56-bit message.
-            is_valid_ = false;  // Calculated checksum is XORed with the ICAO address. See ADS-B Decoding Guide pg. 22.
-            // ICAO address is a best guess, needs to be confirmed from the aircraft dictionary.
-            icao_address_ = parity_value ^ calculated_checksum;
+            // ICAO address is sent in the clear, and the parity field is overlaid with the interrogator code.
+            icao_address_ = packet.frame.GetHeader() & 0xFFFFFF;
+            parity_interrogator_id = parity_value ^ calculated_checksum;
+            if ((parity_interrogator_id & ~kInterrogatorCodeMask) == 0) {
+                is_valid_ = true;
+            } else {
+                decode_error_ = kDecodeErrorInvalidChecksum;
+            }
             break;
         }
         default:  // All other DFs. Note: DF=17-19 for ADS-B.
         {
             // Process a 112-bit message.
-            icao_address_ = packet.buffer[0] & 0xFFFFFF;
+            icao_address_ = packet.frame.GetHeader() & 0xFFFFFF;
             if (calculated_checksum == parity_value) {
                 is_valid_ = true;  // mark packet as valid if CRC matches the parity bits
             } else {
                 // is_valid_ is set to false by default
-                snprintf(debug_string, kDebugStrLen, "Invalid checksum, expected %06lx but calculated %06lx.\r\n",
-                         parity_value, calculated_checksum);
+                decode_error_ = kDecodeErrorInvalidChecksum;
             }
         }
     }
@@ -219,18 +403,9 @@ void DecodedTransponderPacket::ConstructTransponderPacket() {
 
 /** ADSBPacket **/
 
-/**
- * Helper function used by constructors.
- */
-void ADSBPacket::ConstructADSBPacket() {
-    capability_ = static_cast<ADSBPacket::Capability>((packet.buffer[0] >> 24) & 0b111);
-    typecode_ = static_cast<ADSBPacket::TypeCode>(packet.buffer[1] >> 27);
-    parity_interrogator_id = packet.buffer[1] & 0xFFFFFF;
-}
-
 ADSBPacket::TypeCode ADSBPacket::GetTypeCodeEnum() const {
     // Table 3.3 from The 1090Mhz Riddle (Junzi Sun), pg. 37.
-    switch (static_cast<uint16_t>(typecode_)) {
+    switch (static_cast<uint16_t>(GetTypeCode())) {
         case 1:
         case 2:
         case 3:
@@ -284,94 +459,268 @@ ADSBPacket::TypeCode ADSBPacket::GetTypeCodeEnum() const {
     }
 }
 
-ModeCPacket::ModeCPacket(const DecodedTransponderPacket &decoded_packet) : DecodedTransponderPacket(decoded_packet) {
-    uint8_t flight_status = GetNBitWordFromBuffer(3, 5, packet.buffer);  // FS = Bits 5-7.
-    switch (flight_status) {
-        case 0b000:  // No alert, no SPI, aircraft is airborne.
-            has_alert_ = false;
-            has_ident_ = false;
-            is_airborne_ = true;
-            break;
-        case 0b001:  // No alert, no SPI, aircraft is on ground.
-            has_alert_ = false;
-            has_ident_ = false;
-            is_airborne_ = false;
-            break;
-        case 0b010:  // Alert, no SPI, aircraft is airborne.
-            has_alert_ = true;
-            has_ident_ = false;
-            is_airborne_ = true;
-            break;
-        case 0b011:  // Alert, no SPI, aircraft is on ground.
-            has_alert_ = true;
-            has_ident_ = false;
-            is_airborne_ = false;
-            break;
-        case 0b100:  // Alert, SPI, aircraft is airborne or on ground.
-            has_alert_ = true;
-            has_ident_ = true;
-            // Default is_airborne_ to false when not known.
-            break;
-        case 0b101:
-            // No alert, SPI, aircaft is airborne or on ground.
-            has_ident_ = true;
-            has_alert_ = false;
-            // Default is_airborne_ to false when not known.
-            break;
-        case 0b110:  // Reserved.
-            break;
-        case 0b111:  // Not assigned.
-            break;
+/** SurveillanceReplyPacket **/
+
+// Flight Status (FS) values. Note that FS = 0b110 is reserved and FS = 0b111 is not assigned.
+const uint8_t kFlightStatusAirborne = 0b000;                     // No alert, no SPI, aircraft is airborne.
+const uint8_t kFlightStatusOnGround = 0b001;                     // No alert, no SPI, aircraft is on ground.
+const uint8_t kFlightStatusAlertAirborne = 0b010;                // Alert, no SPI, aircraft is airborne.
+const uint8_t kFlightStatusAlertOnGround = 0b011;                // Alert, no SPI, aircraft is on ground.
+const uint8_t kFlightStatusAlertIdentAirborneOrOnGround = 0b100;  // Alert, SPI, aircraft is airborne or on ground.
+const uint8_t kFlightStatusIdentAirborneOrOnGround = 0b101;       // No alert, SPI, aircraft is airborne or on ground.
+
+bool SurveillanceReplyPacket::IsAirborne() const {
+    // Default to not airborne when not known.
+    uint8_t flight_status = GetFlightStatus();
+    return flight_status == kFlightStatusAirborne || flight_status == kFlightStatusAlertAirborne;
+}
+
+bool SurveillanceReplyPacket::HasAlert() const {
+    uint8_t flight_status = GetFlightStatus();
+    return flight_status == kFlightStatusAlertAirborne || flight_status == kFlightStatusAlertOnGround ||
+           flight_status == kFlightStatusAlertIdentAirborneOrOnGround;
+}
+
+bool SurveillanceReplyPacket::HasIdent() const {
+    uint8_t flight_status = GetFlightStatus();
+    return flight_status == kFlightStatusAlertIdentAirborneOrOnGround ||
+           flight_status == kFlightStatusIdentAirborneOrOnGround;
+}
+
+/** ModeCPacket **/
+
+int32_t ModeCPacket::GetAltitudeFt() const {
+    return AltitudeCodeToAltitudeFt(GetFrame().GetHeaderField<13, 19>());  // AC = Bits 19-31.
+}
+
+/** AirAirSurveillancePacket **/
+
+int32_t AirAirSurveillancePacket::GetAltitudeFt() const {
+    return AltitudeCodeToAltitudeFt(GetFrame().GetHeaderField<13, 19>());  // AC = Bits 19-31.
+}
+
+/** ModeAPacket **/
+
+uint16_t ModeAPacket::GetSquawk() const {
+    return IdentityCodeToSquawk(GetFrame().GetHeaderField<13, 19>());  // ID = Bits 19-31.
+}
+
+/** CommBPacket **/
+
+namespace {
+
+// A field in a Comm-B register: a status bit, followed by the value. Bits are numbered from 1 to 56 starting at the MSb
+// of the MB field, to match the register tables in ICAO Doc 9871. Plausible ranges are in LSBs of the raw value, so
+// that register inference doesn't need any floating point math.
+struct CommBField {
+    uint16_t status_bit;
+    uint16_t num_value_bits;  // Includes the sign bit, for signed (two's complement) values.
+    bool is_signed;
+    int16_t min_value;
+    int16_t max_value;
+};
+
+constexpr uint64_t MBBitMask(uint16_t first_bit, uint16_t num_bits) {
+    return ((uint64_t(0b1) << num_bits) - 1) << (CommBPacket::kMBNumBits - first_bit - num_bits + 1);
+}
+
+constexpr uint64_t StatusBitMask(const CommBField &field) { return MBBitMask(field.status_bit, 1); }
+constexpr uint64_t ValueBitsMask(const CommBField &field) {
+    return MBBitMask(field.status_bit + 1, field.num_value_bits);
+}
+
+/**
+ * Reads a field from an MB field.
+ * @param[in] mb Right-aligned 56-bit MB field.
+ * @param[in] field Field to read.
+ * @param[out] value Sign extended value of the field, in LSBs.
+ * @retval True if the field's status bit is set, false otherwise.
+ */
+inline bool ReadCommBField(uint64_t mb, const CommBField &field, int32_t &value) {
+    uint16_t shift = CommBPacket::kMBNumBits - field.status_bit - field.num_value_bits;
+    value = static_cast<int32_t>((mb >> shift) & ((0b1 << field.num_value_bits) - 1));
+    if (field.is_signed && value >= (0b1 << (field.num_value_bits - 1))) {
+        value -= 0b1 << field.num_value_bits;
+    }
+    return mb & StatusBitMask(field);
+}
+
+// BDS 4,0: Selected Vertical Intention
+constexpr CommBField kBDS40MCPSelectedAltitude = {1, 12, false, 0, 3125};     // [16ft] Up to 50,000ft.
+constexpr CommBField kBDS40FMSSelectedAltitude = {14, 12, false, 0, 3125};    // [16ft] Up to 50,000ft.
+constexpr CommBField kBDS40BaroPressureSetting = {27, 12, false, 700, 3000};  // [0.1mb] Offset by 800mb, 870-1100mb.
+constexpr CommBField kBDS40MCPModeBits = {48, 3, false, 0, 0b111};
+constexpr CommBField kBDS40TargetAltitudeSource = {54, 2, false, 0, 0b11};
+constexpr CommBField kBDS40Fields[] = {kBDS40MCPSelectedAltitude, kBDS40FMSSelectedAltitude,
+                                       kBDS40BaroPressureSetting, kBDS40MCPModeBits, kBDS40TargetAltitudeSource};
+constexpr uint64_t kBDS40ReservedBitsMask = MBBitMask(40, 8) | MBBitMask(52, 2);
+
+// BDS 5,0: Track and Turn Report
+constexpr CommBField kBDS50RollAngle = {1, 10, true, -284, 284};          // [45/256deg] Up to +-50deg.
+constexpr CommBField kBDS50TrueTrackAngle = {12, 11, true, -1024, 1023};  // [90/512deg]
+constexpr CommBField kBDS50GroundSpeed = {24, 10, false, 0, 300};         // [2kts] Up to 600kts.
+constexpr CommBField kBDS50TrackAngleRate = {35, 10, true, -512, 511};    // [8/256deg/s]
+constexpr CommBField kBDS50TrueAirspeed = {46, 10, false, 0, 250};        // [2kts] Up to 500kts.
+constexpr CommBField kBDS50Fields[] = {kBDS50RollAngle, kBDS50TrueTrackAngle, kBDS50GroundSpeed, kBDS50TrackAngleRate,
+                                       kBDS50TrueAirspeed};
+// Ground speed and true airspeed can't differ by more than the wind speed.
+constexpr int32_t kBDS50MaxGroundSpeedAirspeedDifference = 100;  // [2kts] 200kts.
+
+// BDS 6,0: Heading and Speed Report
+constexpr CommBField kBDS60MagneticHeading = {1, 11, true, -1024, 1023};      // [90/512deg]
+constexpr CommBField kBDS60IndicatedAirspeed = {13, 10, false, 0, 500};       // [1kt] Up to 500kts.
+constexpr CommBField kBDS60Mach = {24, 10, false, 0, 250};                    // [0.004] Up to Mach 1.
+constexpr CommBField kBDS60BaroVerticalRate = {35, 10, true, -188, 188};      // [32fpm] Up to +-6000fpm.
+constexpr CommBField kBDS60InertialVerticalRate = {46, 10, true, -188, 188};  // [32fpm] Up to +-6000fpm.
+constexpr CommBField kBDS60Fields[] = {kBDS60MagneticHeading, kBDS60IndicatedAirspeed, kBDS60Mach,
+                                       kBDS60BaroVerticalRate, kBDS60InertialVerticalRate};
+
+bool CheckBDS50Fields(uint64_t mb) {
+    int32_t ground_speed, true_airspeed;
+    if (ReadCommBField(mb, kBDS50GroundSpeed, ground_speed) && ReadCommBField(mb, kBDS50TrueAirspeed, true_airspeed)) {
+        int32_t difference = ground_speed - true_airspeed;
+        return difference <= kBDS50MaxGroundSpeedAirspeedDifference &&
+               difference >= -kBDS50MaxGroundSpeedAirspeedDifference;
     }
+    return true;
+}
 
-    downlink_request_ = static_cast<DownlinkRequest>(GetNBitWordFromBuffer(5, 8, packet.buffer));
-    utility_message_ = GetNBitWordFromBuffer(4, 13, packet.buffer);
-    utility_message_type_ = static_cast<UtilityMessageType>(GetNBitWordFromBuffer(2, 17, packet.buffer));
-    altitude_ft_ = AltitudeCodeToAltitudeFt(GetNBitWordFromBuffer(13, 19, packet.buffer));
+struct CommBRegister {
+    CommBPacket::BDS bds;
+    const CommBField *fields;
+    uint16_t num_fields;
+    uint64_t reserved_bits_mask;        // Bits that must be 0.
+    bool (*check_fields)(uint64_t mb);  // Checks that span multiple fields, or nullptr if there aren't any.
 };
 
-ModeAPacket::ModeAPacket(const DecodedTransponderPacket &decoded_packet) : DecodedTransponderPacket(decoded_packet) {
-    uint8_t flight_status = GetNBitWordFromBuffer(3, 5, packet.buffer);  // FS = Bits 5-7.
-    switch (flight_status) {
-        case 0b000:  // No alert, no SPI, aircraft is airborne.
-            has_alert_ = false;
-            has_ident_ = false;
-            is_airborne_ = true;
-            break;
-        case 0b001:  // No alert, no SPI, aircraft is on ground.
-            has_alert_ = false;
-            has_ident_ = false;
-            is_airborne_ = false;
-            break;
-        case 0b010:  // Alert, no SPI, aircraft is airborne.
-            has_alert_ = true;
-            has_ident_ = false;
-            is_airborne_ = true;
-            break;
-        case 0b011:  // Alert, no SPI, aircraft is on ground.
-            has_alert_ = true;
-            has_ident_ = false;
-            is_airborne_ = false;
-            break;
-        case 0b100:  // Alert, SPI, aircraft is airborne or on ground.
-            has_alert_ = true;
-            has_ident_ = true;
-            // Default is_airborne_ to false when not known.
-            break;
-        case 0b101:
-            // No alert, SPI, aircaft is airborne or on ground.
-            has_ident_ = true;
-            has_alert_ = false;
-            // Default is_airborne_ to false when not known.
-            break;
-        case 0b110:  // Reserved.
-            break;
-        case 0b111:  // Not assigned.
-            break;
+const CommBRegister kCommBRegisters[] = {
+    {CommBPacket::kBDS40SelectedVerticalIntention, kBDS40Fields, sizeof(kBDS40Fields) / sizeof(CommBField),
+     kBDS40ReservedBitsMask, nullptr},
+    {CommBPacket::kBDS50TrackAndTurnReport, kBDS50Fields, sizeof(kBDS50Fields) / sizeof(CommBField), 0,
+     CheckBDS50Fields},
+    {CommBPacket::kBDS60HeadingAndSpeedReport, kBDS60Fields, sizeof(kBDS60Fields) / sizeof(CommBField), 0, nullptr}};
+
+bool MatchesCommBRegister(uint64_t mb, const CommBRegister &reg) {
+    if (mb & reg.reserved_bits_mask) {
+        return false;
+    }
+    bool has_status_bit = false;
+    for (uint16_t i = 0; i < reg.num_fields; i++) {
+        const CommBField &field = reg.fields[i];
+        int32_t value;
+        if (!ReadCommBField(mb, field, value)) {
+            if (mb & ValueBitsMask(field)) {
+                return false;  // Fields that aren't available must be zeroed.
+            }
+            continue;
+        }
+        if (value < field.min_value || value > field.max_value) {
+            return false;
+        }
+        has_status_bit = true;
     }
+    // An MB field with no status bits set would match every register.
+    return has_status_bit && (reg.check_fields == nullptr || reg.check_fields(mb));
+}
+
+// Converts a signed angle in units of 90/512 degrees to [0, 360) degrees.
+inline float CommBAngleToDeg(int32_t value) { return (value < 0 ? value + 2048 : value) * (90.0f / 512.0f); }
+
+}  // namespace
+
+CommBPacket::BDS CommBPacket::InferBDS(uint64_t mb) {
+    BDS bds = kBDSUnknown;
+    for (const CommBRegister &reg : kCommBRegisters) {
+        if (MatchesCommBRegister(mb, reg)) {
+            if (bds != kBDSUnknown) {
+                return kBDSAmbiguous;
+            }
+            bds = reg.bds;
+        }
+    }
+    return bds;
+}
+
+bool CommBPacket::GetMCPSelectedAltitudeFt(int32_t &altitude_ft) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS40MCPSelectedAltitude, value)) return false;
+    altitude_ft = value * 16;
+    return true;
+}
 
-    downlink_request_ = static_cast<DownlinkRequest>(GetNBitWordFromBuffer(5, 8, packet.buffer));
-    utility_message_ = GetNBitWordFromBuffer(4, 13, packet.buffer);
-    utility_message_type_ = static_cast<UtilityMessageType>(GetNBitWordFromBuffer(2, 17, packet.buffer));
-    squawk_ = IdentityCodeToSquawk(GetNBitWordFromBuffer(13, 19, packet.buffer));
-};
\ No newline at end of file
+bool CommBPacket::GetFMSSelectedAltitudeFt(int32_t &altitude_ft) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS40FMSSelectedAltitude, value)) return false;
+    altitude_ft = value * 16;
+    return true;
+}
+
+bool CommBPacket::GetBaroPressureSettingMbE1(uint16_t &baro_pressure_setting_mb_e1) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS40BaroPressureSetting, value)) return false;
+    baro_pressure_setting_mb_e1 = 8000 + value;
+    return true;
+}
+
+bool CommBPacket::GetRollAngleDeg(float &roll_deg) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS50RollAngle, value)) return false;
+    roll_deg = value * (45.0f / 256.0f);
+    return true;
+}
+
+bool CommBPacket::GetTrueTrackDeg(float &track_deg) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS50TrueTrackAngle, value)) return false;
+    track_deg = CommBAngleToDeg(value);
+    return true;
+}
+
+bool CommBPacket::GetGroundSpeedKts(uint16_t &ground_speed_kts) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS50GroundSpeed, value)) return false;
+    ground_speed_kts = value * 2;
+    return true;
+}
+
+bool CommBPacket::GetTrueAirspeedKts(uint16_t &true_airspeed_kts) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS50TrueAirspeed, value)) return false;
+    true_airspeed_kts = value * 2;
+    return true;
+}
+
+bool CommBPacket::GetMagneticHeadingDeg(float &heading_deg) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS60MagneticHeading, value)) return false;
+    heading_deg = CommBAngleToDeg(value);
+    return true;
+}
+
+bool CommBPacket::GetIndicatedAirspeedKts(uint16_t &indicated_airspeed_kts) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS60IndicatedAirspeed, value)) return false;
+    indicated_airspeed_kts = value;
+    return true;
+}
+
+bool CommBPacket::GetMachE3(uint16_t &mach_e3) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS60Mach, value)) return false;
+    mach_e3 = value * 4;
+    return true;
+}
+
+bool CommBPacket::GetBaroVerticalRateFpm(int16_t &vertical_rate_fpm) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS60BaroVerticalRate, value)) return false;
+    vertical_rate_fpm = value * 32;
+    return true;
+}
+
+bool CommBPacket::GetInertialVerticalRateFpm(int16_t &vertical_rate_fpm) const {
+    int32_t value;
+    if (!ReadCommBField(GetMB(), kBDS60InertialVerticalRate, value)) return false;
+    vertical_rate_fpm = value * 32;
+    return true;
+}
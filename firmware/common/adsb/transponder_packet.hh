@@ -8,9 +8,89 @@
 
 // Useful resource: https://mode-s.org/decode/content/ads-b/1-basics.html
 
+/**
+ * Mode S frame packed into two 64-bit words, so that every field can be read with a single shift and mask. All Mode S
+ * frames start with a 32-bit header (DF, then CA / ICAO or FS / DR / UM / AC etc.) and end with a 24-bit parity field,
+ * and 112-bit frames carry a 56-bit message field (ME / MB / MV) in between. The frame is split around the message
+ * field instead of every 56 bits, so that the message field is a single word, and a 56-bit frame is exactly one word.
+ */
+class ModeSFrame {
+   public:
+    static const uint16_t kMaxLenWords32 = 4;
+    static const uint16_t kHeaderNumBits = 32;   // Bits 1-32.
+    static const uint16_t kMessageNumBits = 56;  // Bits 33-88, only in 112-bit frames.
+    static const uint16_t kParityNumBits = 24;   // Last 24 bits.
+    static const uint16_t kShortFrameLenBits = kHeaderNumBits + kParityNumBits;
+
+    /**
+     * Default constructor.
+     */
+    ModeSFrame() {}
+
+    /**
+     * Packs a frame from a buffer of 32-bit words, e.g. the words read from the demodulator PIO FIFO.
+     * @param[in] words Buffer to read from. Words must be big-endian and left (MSb) aligned, with the MSb of the first
+     * word being the oldest bit. Bits past the end of the frame are ignored.
+     * @param[in] len_bits Length of the frame in bits. Frames longer than 56 bits are packed as 112-bit frames.
+     */
+    ModeSFrame(const uint32_t words[kMaxLenWords32], uint16_t len_bits);
+
+    /**
+     * Unpacks the frame into a buffer of big-endian, left aligned 32-bit words. Inverse of the words constructor.
+     * @param[out] words Buffer to write to. Words past the end of the frame are zeroed.
+     * @param[in] len_bits Length of the frame in bits.
+     */
+    void ToWords32(uint32_t words[kMaxLenWords32], uint16_t len_bits) const;
+
+    uint32_t GetHeader() const { return static_cast<uint32_t>(header_and_parity >> kParityNumBits); }
+    uint32_t GetParity() const { return static_cast<uint32_t>(header_and_parity) & 0xFFFFFF; }
+
+    /**
+     * Reads a field from the header.
+     * @tparam kNumBits Bitlength of the field.
+     * @tparam kFirstBitIndex Index of the MSb of the field, counting from the first bit of the frame as 0.
+     * @retval Right-aligned field value.
+     */
+    template <uint16_t kNumBits, uint16_t kFirstBitIndex>
+    inline uint32_t GetHeaderField() const {
+        static_assert(kNumBits >= 1 && kFirstBitIndex + kNumBits <= kHeaderNumBits, "Field must be in the header.");
+        return (GetHeader() >> (kHeaderNumBits - kFirstBitIndex - kNumBits)) & (0xFFFFFFFF >> (32 - kNumBits));
+    }
+
+    /**
+     * Reads a field from the message field of a 112-bit frame.
+     * @tparam kNumBits Bitlength of the field.
+     * @tparam kFirstBitIndex Index of the MSb of the field, counting from the first bit of the message field as 0.
+     * @retval Right-aligned field value.
+     */
+    template <uint16_t kNumBits, uint16_t kFirstBitIndex>
+    inline uint64_t GetMessageField() const {
+        static_assert(kNumBits >= 1 && kFirstBitIndex + kNumBits <= kMessageNumBits, "Field must be in the message.");
+        return (message >> (kMessageNumBits - kFirstBitIndex - kNumBits)) & (0xFFFFFFFFFFFFFFFF >> (64 - kNumBits));
+    }
+
+    /**
+     * Calculates the 24-bit CRC over the header and message fields, which should match the parity field of a valid
+     * packet with Address / Parity equal to 0.
+     * @param[in] len_bits Length of the frame in bits.
+     * @retval 24-bit CRC.
+     */
+    uint32_t CalculateCRC24(uint16_t len_bits) const;
+
+    /**
+     * Flips a single bit of the frame.
+     * @param[in] bit_index Index of the bit to flip, counting from the first bit of the frame as 0.
+     * @param[in] len_bits Length of the frame in bits.
+     */
+    void FlipBit(uint16_t bit_index, uint16_t len_bits);
+
+    uint64_t header_and_parity = 0;  // Header in bits 55-24, parity in bits 23-0.
+    uint64_t message = 0;            // Right-aligned, 0 for 56-bit frames.
+};
+
 class RawTransponderPacket {
    public:
-    static const uint16_t kMaxPacketLenWords32 = 4;
+    static const uint16_t kMaxPacketLenWords32 = ModeSFrame::kMaxLenWords32;
 
     RawTransponderPacket(char *rx_string, int rssi_dbm = INT32_MIN, uint64_t mlat_48mhz_64bit_counts = 0);
     RawTransponderPacket(uint32_t rx_buffer[kMaxPacketLenWords32], uint16_t rx_buffer_len_words32,
@@ -18,13 +98,9 @@ class RawTransponderPacket {
     /**
      * Default constructor.
      */
-    RawTransponderPacket() {
-        for (uint16_t i = 0; i < kMaxPacketLenWords32; i++) {
-            buffer[i] = 0;
-        }
-    }
+    RawTransponderPacket() {}
 
-    uint32_t buffer[kMaxPacketLenWords32];
+    ModeSFrame frame;
     uint16_t buffer_len_bits = 0;
     int rssi_dbm = INT32_MIN;
     uint64_t mlat_48mhz_64bit_counts = 0;  // High resolution MLAT counter.
@@ -35,11 +111,14 @@ class DecodedTransponderPacket {
     static const uint16_t kMaxPacketLenWords32 = RawTransponderPacket::kMaxPacketLenWords32;
     static const uint16_t kDFNUmBits = 5;     // [1-5] Downlink Format bitlength.
     static const uint16_t kMaxDFStrLen = 50;  // Max length of TypeCode string.
-    static const uint16_t kDebugStrLen = 200;
+    static const uint16_t kDebugStrLen = 200;  // Max length of string written by GetDebugString.
     static const uint16_t kSquitterPacketLenBits = 56;
     static const uint16_t kSquitterPacketNumWords32 = 2;  // 56 bits = 1.75 words, round up to 2.
     static const uint16_t kExtendedSquitterPacketLenBits = 112;
     static const uint16_t kExtendedSquitterPacketNumWords32 = 4;  // 112 bits = 3.5 words, round up to 4.
+    static const uint16_t kMaxNumCorrectableBits = 2;  // Max number of bit errors that CorrectBitErrors can repair.
+    // All-call replies (DF=11) have their parity field overlaid with a 7-bit interrogator code (II or SI).
+    static const uint32_t kInterrogatorCodeMask = 0x7F;
 
     // Bits 1-5: Downlink Format (DF)
     enum DownlinkFormat {
@@ -54,13 +133,21 @@ class DecodedTransponderPacket {
         kDownlinkFormatExtendedSquitter = 17,                // Aircraft (taxiing or airborne).
         kDownlinkFormatExtendedSquitterNonTransponder = 18,  // Surface vehicle or aircraft in special ground operation.
         kDownlinkFormatMilitaryExtendedSquitter = 19,        // Used by military aircraft, protocol is not public.
-        // We don't currently do anything with CommB, CommC, CommD.
+        // Comm-B replies carry a Comm-B message (see CommBPacket). We don't currently do anything with Comm-D.
         kDownlinkFormatCommBAltitudeReply = 20,  // Data being sent as reply to request from Comm-B ground station.
         kDownlinkFormatCommBIdentityReply = 21,  // Reply to ground station via Comm-C (higher capacity than Comm-B).
         kDownlinkFormatCommDExtendedLengthMessage = 24
         // DF 1-3, 6-10, 11-15, 22-23 not used
     };
 
+    // Reasons that a packet failed to decode. Stored instead of a debug string to keep packets small enough to queue in
+    // bulk; use GetDebugString() to get a human readable description.
+    enum DecodeError : uint8_t {
+        kDecodeErrorNone = 0,
+        kDecodeErrorBitLengthMismatch,  // Packet was not 56 or 112 bits long.
+        kDecodeErrorInvalidChecksum     // 112-bit packet CRC did not match its parity field.
+    };
+
     // Constructors
     /**
      * DecodedTransponderPacket constructor.
@@ -91,7 +178,7 @@ class DecodedTransponderPacket {
     /**
      * Default constructor.
      */
-    DecodedTransponderPacket() : packet((char *)"", INT32_MIN, 0) { debug_string[0] = '\0'; };
+    DecodedTransponderPacket() : packet((char *)"", INT32_MIN, 0) {};
 
     bool IsValid() const { return is_valid_; };
 
@@ -102,6 +189,16 @@ class DecodedTransponderPacket {
      */
     void ForceValid() { is_valid_ = true; }
 
+    DecodeError GetDecodeError() const { return decode_error_; }
+
+    /**
+     * Writes a human readable description of the packet's decode error (if any) to a string buffer. The string is
+     * generated on demand, so that packets don't need to carry it around.
+     * @param[out] str_buf Buffer to write the debug string to.
+     * @retval Number of characters written, not including the null terminator.
+     */
+    uint16_t GetDebugString(char str_buf[kDebugStrLen]) const;
+
     int GetRSSIdBm() const { return packet.rssi_dbm; }
     uint64_t GetMLAT12MHzCounter() const { return (packet.mlat_48mhz_64bit_counts >> 2) & 0xFFFFFFFFFFFF; }
     uint16_t GetDownlinkFormat() const { return downlink_format_; };
@@ -109,6 +206,19 @@ class DecodedTransponderPacket {
     DownlinkFormat GetDownlinkFormatEnum();
     uint32_t GetICAOAddress() const { return icao_address_; };
     uint16_t GetPacketBufferLenBits() const { return packet.buffer_len_bits; };
+    /**
+     * Returns the interrogator code (II or SI) that an all-call reply (DF=11) was sent in response to. Acquisition
+     * squitters have an interrogator code of 0. Only valid for DF=11 packets.
+     */
+    uint32_t GetInterrogatorCode() const { return parity_interrogator_id; }
+
+    /**
+     * Checks whether the packet's ICAO address is overlaid on its parity field (Address / Parity, DF=0, 4, 5, 16, 20,
+     * 21). These packets can't validate themselves; the ICAO address recovered from the parity field needs to be
+     * checked against a list of known ICAO addresses.
+     * @retval True if the packet uses Address / Parity, false otherwise.
+     */
+    bool HasAddressParity() const;
 
     /**
      * Dumps the internal packet buffer to a destination and returns the number of bytes written.
@@ -119,9 +229,7 @@ class DecodedTransponderPacket {
     uint16_t DumpPacketBuffer(uint8_t to_buffer[kMaxPacketLenWords32 * kBytesPerWord]) const;
 
     // Exposed for testing only.
-    uint32_t Get24BitWordFromPacketBuffer(uint16_t first_bit_index) const {
-        return GetNBitWordFromBuffer(24, first_bit_index, packet.buffer);
-    };
+    uint32_t Get24BitWordFromPacketBuffer(uint16_t first_bit_index) const;
 
     /**
      * Calculates the 24-bit CRC checksum of the ADS-B packet and returns the checksum value. The returned
@@ -130,22 +238,60 @@ class DecodedTransponderPacket {
      */
     uint32_t CalculateCRC24(uint16_t packet_len_bits = kExtendedSquitterPacketLenBits) const;
 
-    char debug_string[kDebugStrLen] = "";
+    /**
+     * Attempts to repair bit errors in an invalid 112-bit Extended Squitter packet (DF=17 or DF=18) by looking up the
+     * CRC syndrome in a table of all 1-bit and 2-bit error syndromes. Errors in the Downlink Format field are not
+     * corrected. If the correction succeeds, the packet is marked as valid and its ICAO address is refreshed.
+     * @param[in] max_num_bits Maximum number of bit errors to correct. 0 disables correction, values larger than
+     * kMaxNumCorrectableBits are clamped.
+     * @retval Number of bits that were corrected, or 0 if the packet was not corrected.
+     */
+    uint16_t CorrectBitErrors(uint16_t max_num_bits = 1);
 
    protected:
-    bool is_valid_ = false;
+    // Fields are ordered largest to smallest to avoid padding, since these packets get queued for reporting.
     RawTransponderPacket packet;
 
     uint32_t icao_address_ = 0;
+    uint32_t parity_interrogator_id = 0;
     uint16_t downlink_format_ = static_cast<uint16_t>(kDownlinkFormatInvalid);
 
-    uint32_t parity_interrogator_id = 0;
+    bool is_valid_ = false;
+    DecodeError decode_error_ = kDecodeErrorNone;
 
    private:
+    friend class TransponderPacketView;  // Views read directly from the packet frame.
+
     void ConstructTransponderPacket();
 };
 
-class ADSBPacket : public DecodedTransponderPacket {
+/**
+ * Non-owning view into a DecodedTransponderPacket. Views don't copy any of the parent packet; they read fields directly
+ * out of the parent's frame, so they are cheap to construct and pass around. A view must not outlive the
+ * DecodedTransponderPacket that it was constructed from!
+ */
+class TransponderPacketView {
+   public:
+    /**
+     * Constructor.
+     * @param[in] decoded_packet Parent DecodedTransponderPacket to view. Must outlive the view.
+     */
+    TransponderPacketView(const DecodedTransponderPacket &decoded_packet) : decoded_packet_(&decoded_packet) {}
+
+    bool IsValid() const { return decoded_packet_->IsValid(); }
+    int GetRSSIdBm() const { return decoded_packet_->GetRSSIdBm(); }
+    uint16_t GetDownlinkFormat() const { return decoded_packet_->GetDownlinkFormat(); }
+    uint32_t GetICAOAddress() const { return decoded_packet_->GetICAOAddress(); }
+    uint16_t GetPacketBufferLenBits() const { return decoded_packet_->GetPacketBufferLenBits(); }
+    const DecodedTransponderPacket &GetDecodedTransponderPacket() const { return *decoded_packet_; }
+
+   protected:
+    const ModeSFrame &GetFrame() const { return decoded_packet_->packet.frame; }
+
+    const DecodedTransponderPacket *decoded_packet_;  // Pointer instead of reference so that views are assignable.
+};
+
+class ADSBPacket : public TransponderPacketView {
    public:
     static const uint16_t kMaxTCStrLen = 50;
 
@@ -155,17 +301,16 @@ class ADSBPacket : public DecodedTransponderPacket {
     static const uint16_t kMENumBits = 56;    // [33-88] Extended Squitter Message bitlength.
     static const uint16_t kTCNumBits = 5;     // [33-37] Type code bitlength. Not always included.
     static const uint16_t kPINumBits = 24;    // Parity / Interrogator ID bitlength.
+    static const uint16_t kNumTypeCodes = 1 << kTCNumBits;
 
-    static const uint16_t kMEFirstBitIndex = kDFNUmBits + kCANumBits + kICAONumBits;
+    static const uint16_t kMEFirstBitIndex = DecodedTransponderPacket::kDFNUmBits + kCANumBits + kICAONumBits;
 
     /**
      * Constructor. Can only create an ADSBPacket from an existing DecodedTransponderPacket, which is is referenced as
      * the parent of the ADSBPacket. Think of this as a way to use the ADSBPacket as a "window" into the contents of the
      * parent DecodedTransponderPacket. The ADSBPacket cannot exist without the parent DecodedTransponderPacket!
      */
-    ADSBPacket(const DecodedTransponderPacket &decoded_packet) : DecodedTransponderPacket(decoded_packet) {
-        ConstructADSBPacket();
-    };
+    ADSBPacket(const DecodedTransponderPacket &decoded_packet) : TransponderPacketView(decoded_packet) {};
 
     // Bits 6-8 [3]: Capability (CA)
     enum Capability : uint8_t {
@@ -203,27 +348,60 @@ class ADSBPacket : public DecodedTransponderPacket {
         kAirborneVelocitiesAirspeedSupersonic = 4
     };
 
+    // Aircraft Status (TC = 28)
+    enum AircraftStatusSubtype : uint8_t {
+        kAircraftStatusSubtypeNoInformation = 0,
+        kAircraftStatusSubtypeEmergencyPriorityStatus = 1,
+        kAircraftStatusSubtypeACASRABroadcast = 2
+    };
+
+    // Target State and Status Information (TC = 29). Subtype 0 was only used by ADS-B version 1, and isn't decoded.
+    enum TargetStateAndStatusSubtype : uint8_t { kTargetStateAndStatusSubtypeVersion2 = 1 };
+
     // Operation Status (TC = 31)
     enum OperationStatusSubtype : uint8_t { kOperationStatusSubtypeAirborne = 0, kOperationStatusSubtypeSurface = 1 };
 
-    inline Capability GetCapability() const { return capability_; };
-    inline TypeCode GetTypeCode() const { return typecode_; };
+    inline Capability GetCapability() const {
+        return static_cast<Capability>(GetFrame().GetHeaderField<kCANumBits, DecodedTransponderPacket::kDFNUmBits>());
+    };
+    inline TypeCode GetTypeCode() const { return static_cast<TypeCode>(GetNBitWordFromMessage<kTCNumBits, 0>()); };
     TypeCode GetTypeCodeEnum() const;
 
     // Exposed for testing only.
     inline uint32_t GetNBitWordFromMessage(uint16_t n, uint16_t first_bit_index) const {
-        return GetNBitWordFromBuffer(n, kMEFirstBitIndex + first_bit_index, packet.buffer);
+        return static_cast<uint32_t>(GetFrame().message >> (kMENumBits - first_bit_index - n)) &
+               (0xFFFFFFFF >> (32 - n));
     };
 
-   private:
-    Capability capability_ = kCALevel1Transponder;  // Default to most basic capability.
-
-    TypeCode typecode_ = kTypeCodeInvalid;
+    /**
+     * Reads a field at a fixed position in the ME field, with shifts and masks resolved at compile time.
+     * @tparam kNumBits Bitlength of the field. Must be between 1 and 32.
+     * @tparam kFirstBitIndex Index of the MSb of the field, counting from the first bit of the ME field as 0.
+     * @retval Right-aligned field value.
+     */
+    template <uint16_t kNumBits, uint16_t kFirstBitIndex>
+    inline uint32_t GetNBitWordFromMessage() const {
+        static_assert(kNumBits <= 32, "Use GetNBitWord64FromMessage for fields longer than 32 bits.");
+        return static_cast<uint32_t>(GetFrame().GetMessageField<kNumBits, kFirstBitIndex>());
+    }
 
-    void ConstructADSBPacket();
+    /**
+     * 64-bit version of the compile-time GetNBitWordFromMessage, for multi-character fields like the callsign.
+     * @tparam kNumBits Bitlength of the field. Must be between 1 and 64.
+     * @tparam kFirstBitIndex Index of the MSb of the field, counting from the first bit of the ME field as 0.
+     * @retval Right-aligned field value.
+     */
+    template <uint16_t kNumBits, uint16_t kFirstBitIndex>
+    inline uint64_t GetNBitWord64FromMessage() const {
+        return GetFrame().GetMessageField<kNumBits, kFirstBitIndex>();
+    }
 };
 
-class ModeCPacket : public DecodedTransponderPacket {
+/**
+ * View into a surveillance reply (DF=4, 5, 20, 21), which share the Flight Status, Downlink Request, and Utility
+ * Message fields at the start of the packet.
+ */
+class SurveillanceReplyPacket : public TransponderPacketView {
    public:
     enum DownlinkRequest : uint8_t {
         kDownlinkRequestNone = 0b00000,
@@ -239,62 +417,122 @@ class ModeCPacket : public DecodedTransponderPacket {
         kUtilityMessageCommDInterrogatorIdentifierCode = 0b11
     };
 
-    ModeCPacket(const DecodedTransponderPacket &decoded_packet);
+    SurveillanceReplyPacket(const DecodedTransponderPacket &decoded_packet) : TransponderPacketView(decoded_packet) {}
 
-    bool IsAirborne() const { return is_airborne_; }
-    bool HasAlert() const { return has_alert_; }
-    bool HasIdent() const { return has_ident_; }
-    DownlinkRequest GetDownlinkRequest() const { return downlink_request_; }
-    uint8_t GetUtilityMessage() const { return utility_message_; }
-    int32_t GetAltitudeFt() const { return altitude_ft_; }
+    bool IsAirborne() const;
+    bool HasAlert() const;
+    bool HasIdent() const;
+    DownlinkRequest GetDownlinkRequest() const {
+        return static_cast<DownlinkRequest>(GetFrame().GetHeaderField<5, 8>());  // DR = Bits 8-12.
+    }
+    uint8_t GetUtilityMessage() const { return GetFrame().GetHeaderField<4, 13>(); }  // UM = Bits 13-16.
+    UtilityMessageType GetUtilityMessageType() const {
+        return static_cast<UtilityMessageType>(GetFrame().GetHeaderField<2, 17>());  // IDS = Bits 17-18.
+    }
 
-   private:
-    bool is_airborne_ = false;
-    bool has_alert_ = false;
-    bool has_ident_ = false;
+   protected:
+    uint8_t GetFlightStatus() const { return GetFrame().GetHeaderField<3, 5>(); }  // FS = Bits 5-7.
+};
 
-    DownlinkRequest downlink_request_ = kDownlinkRequestNone;
-    uint8_t utility_message_ = 0b0;
-    UtilityMessageType utility_message_type_ = kUtilityMessageNoInformation;
+class ModeCPacket : public SurveillanceReplyPacket {
+   public:
+    ModeCPacket(const DecodedTransponderPacket &decoded_packet) : SurveillanceReplyPacket(decoded_packet) {}
 
-    int32_t altitude_ft_ = -1;
+    int32_t GetAltitudeFt() const;
 };
 
-class ModeAPacket : public DecodedTransponderPacket {
+class ModeAPacket : public SurveillanceReplyPacket {
    public:
-    enum DownlinkRequest : uint8_t {
-        kDownlinkRequestNone = 0b00000,
-        kDownlinkRequestSendCommBMessage = 0b00001,
-        kDownlinkRequestCommBBroadcastMessage1Available = 0b00100,
-        kDownlinkRequestCommBBroadcastMessage2Available = 0b00101
-    };
+    ModeAPacket(const DecodedTransponderPacket &decoded_packet) : SurveillanceReplyPacket(decoded_packet) {}
 
-    enum UtilityMessageType : uint8_t {
-        kUtilityMessageNoInformation = 0b00,
-        kUtilityMessageCommBInterrogatorIdentifierCode = 0b10,
-        kUtilityMessageCommCInterrogatorIdentifierCode = 0b10,
-        kUtilityMessageCommDInterrogatorIdentifierCode = 0b11
+    uint16_t GetSquawk() const;
+};
+
+/**
+ * View into an air-air surveillance reply (DF=0 short, DF=16 long), sent in reply to ACAS interrogations. Carries the
+ * same 13-bit altitude code as a Mode C reply.
+ */
+class AirAirSurveillancePacket : public TransponderPacketView {
+   public:
+    AirAirSurveillancePacket(const DecodedTransponderPacket &decoded_packet) : TransponderPacketView(decoded_packet) {}
+
+    bool IsAirborne() const { return GetFrame().GetHeaderField<1, 5>() == 0; }  // VS = Bit 6, 1 = on ground.
+    int32_t GetAltitudeFt() const;
+};
+
+/**
+ * View into the 56-bit Comm-B message (MB) of a Comm-B reply (DF=20 or DF=21). The MB field holds the contents of one
+ * of the transponder's registers (BDS), but the reply doesn't say which one, so the register has to be inferred from
+ * the MB field itself. Field getters don't check the register; call InferBDS() first.
+ */
+class CommBPacket : public TransponderPacketView {
+   public:
+    static const uint16_t kMBFirstBitIndex = 32;  // MB = Bits 32-87.
+    static const uint16_t kMBNumBits = 56;
+
+    enum BDS : uint8_t {
+        kBDSUnknown = 0,                  // MB field doesn't match any of the supported registers.
+        kBDSAmbiguous,                    // MB field matches more than one of the supported registers.
+        kBDS40SelectedVerticalIntention,  // BDS 4,0
+        kBDS50TrackAndTurnReport,         // BDS 5,0
+        kBDS60HeadingAndSpeedReport       // BDS 6,0
     };
 
-    ModeAPacket(const DecodedTransponderPacket &decoded_packet);
+    CommBPacket(const DecodedTransponderPacket &decoded_packet) : TransponderPacketView(decoded_packet) {}
 
-    bool IsAirborne() const { return is_airborne_; }
-    bool HasAlert() const { return has_alert_; }
-    bool HasIdent() const { return has_ident_; }
-    DownlinkRequest GetDownlinkRequest() const { return downlink_request_; }
-    uint8_t GetUtilityMessage() const { return utility_message_; }
-    uint16_t GetSquawk() const { return squawk_; }
+    /**
+     * Returns the MB field, right-aligned. Bit 1 of the MB field (its MSb) is bit 55 of the returned value.
+     */
+    uint64_t GetMB() const { return GetFrame().message; }
 
-   private:
-    bool is_airborne_ = false;
-    bool has_alert_ = false;
-    bool has_ident_ = false;
+    /**
+     * Infers which register the MB field was read from, by checking that its reserved bits are clear, that fields
+     * without their status bit set are zeroed, and that the values of the remaining fields are plausible.
+     * @retval Register that the MB field matches, kBDSAmbiguous if it matches more than one, or kBDSUnknown if it
+     * doesn't match any of them.
+     */
+    BDS InferBDS() const { return InferBDS(GetMB()); }
 
-    DownlinkRequest downlink_request_ = kDownlinkRequestNone;
-    uint8_t utility_message_ = 0b0;
-    UtilityMessageType utility_message_type_ = kUtilityMessageNoInformation;
+    /**
+     * Infers which register a raw MB field was read from. See InferBDS().
+     * @param[in] mb Right-aligned 56-bit MB field.
+     * @retval Inferred register.
+     */
+    static BDS InferBDS(uint64_t mb);
+
+    // Each getter returns true and writes the field if its status bit is set, or returns false if it isn't available.
+
+    // BDS 4,0: Selected Vertical Intention
+    bool GetMCPSelectedAltitudeFt(int32_t &altitude_ft) const;
+    bool GetFMSSelectedAltitudeFt(int32_t &altitude_ft) const;
+    bool GetBaroPressureSettingMbE1(uint16_t &baro_pressure_setting_mb_e1) const;  // [mb * 10]
+
+    // BDS 5,0: Track and Turn Report
+    bool GetRollAngleDeg(float &roll_deg) const;  // Positive is right wing down.
+    bool GetTrueTrackDeg(float &track_deg) const;
+    bool GetGroundSpeedKts(uint16_t &ground_speed_kts) const;
+    bool GetTrueAirspeedKts(uint16_t &true_airspeed_kts) const;
+
+    // BDS 6,0: Heading and Speed Report
+    bool GetMagneticHeadingDeg(float &heading_deg) const;
+    bool GetIndicatedAirspeedKts(uint16_t &indicated_airspeed_kts) const;
+    bool GetMachE3(uint16_t &mach_e3) const;  // [Mach * 1000]
+    bool GetBaroVerticalRateFpm(int16_t &vertical_rate_fpm) const;
+    bool GetInertialVerticalRateFpm(int16_t &vertical_rate_fpm) const;
+};
 
-    uint16_t squawk_ = 0xFFFF;
+/**
+ * View into an all-call reply (DF=11), sent in reply to all-call interrogations and as an acquisition squitter. Unlike
+ * other short packets, the ICAO address is sent in the clear, so the packet can validate itself with its CRC.
+ */
+class AllCallReplyPacket : public TransponderPacketView {
+   public:
+    AllCallReplyPacket(const DecodedTransponderPacket &decoded_packet) : TransponderPacketView(decoded_packet) {}
+
+    ADSBPacket::Capability GetCapability() const {
+        return static_cast<ADSBPacket::Capability>(GetFrame().GetHeaderField<3, 5>());  // CA = Bits 6-8.
+    }
+    uint32_t GetInterrogatorCode() const { return decoded_packet_->GetInterrogatorCode(); }
 };
 
 #endif /* _ADSB_PACKET_HH_ */
\ No newline at end of file
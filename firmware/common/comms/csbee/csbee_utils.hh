@@ -1,6 +1,8 @@
 #ifndef CSBEE_UTILS_HH_
 #define CSBEE_UTILS_HH_
 
+#include <inttypes.h>  // For PRIu32.
+
 #include "aircraft_dictionary.hh"
 #include "macros.hh"
 #include "stdio.h"
@@ -9,32 +11,58 @@ const uint16_t kCSBeeMessageStrMaxLen = 200;
 const uint16_t kCRCMaxNumChars = 4;  // 16 bits = 4 hex characters.
 const uint16_t kEOLNumChars = 2;
 
+/**
+ * Angle split into parts that can be printed with 5 decimal places without going through floating point math.
+ */
+struct CSBeeFixedPointDegrees {
+    const char *sign;
+    uint32_t whole_deg;
+    uint32_t fractional_deg_e5;
+};
+
+/**
+ * Rounds an angle in degrees * 1e7 to 5 decimal places and splits it into printable parts.
+ * @param[in] deg_e7 Angle in degrees * 1e7.
+ * @retval CSBeeFixedPointDegrees to print with "%s%" PRIu32 ".%05" PRIu32.
+ */
+inline CSBeeFixedPointDegrees DegE7ToCSBeeFixedPointDegrees(int32_t deg_e7) {
+    uint32_t abs_deg_e5 = (static_cast<uint32_t>(ABS(static_cast<int64_t>(deg_e7))) + 50) / 100;
+    return {.sign = deg_e7 < 0 && abs_deg_e5 > 0 ? "-" : "",
+            .whole_deg = abs_deg_e5 / 100000,
+            .fractional_deg_e5 = abs_deg_e5 % 100000};
+}
+
 /**
  * Dumps an Aircraft object into a string buffer in CSBee format. String buffer must be of length
  * kCSBeeMessageStrMaxLen.
  * @param[out] message_buf Character array to write into.
  * @param[in] aircraft Aircraft object to dump the contents of.
+ * @param[in] details AircraftDetails of the aircraft, used for the SYSINFO field.
  * @retval Number of characters written to the string buffer, or a negative value if something went wrong.
  */
-inline int16_t WriteCSBeeAircraftMessageStr(char message_buf[], const Aircraft &aircraft) {
+inline int16_t WriteCSBeeAircraftMessageStr(char message_buf[], const Aircraft &aircraft,
+                                            const AircraftDetails &details) {
     // #A:ICAO,FLAGS,CALL,SQ,LAT,LON,ALT_BARO,TRACK,VELH,VELV,SIGS,SIGQ,FPS,NICNAC,ALT_GEO,ECAT,CRC\r\n
 
     // Build up SYSINFO bitfield.
     // Convert aircraft length and width to maximum dimension.
-    uint32_t sysinfo = MAX(aircraft.length_m, aircraft.width_m) << 22;  // MDIM bitfield.
+    uint32_t sysinfo = MAX(details.length_m, details.width_m) << 22;  // MDIM bitfield.
     // Convert GNSS antenna offset value to CSBee formatted bitfield.
-    if (aircraft.gnss_antenna_offset_right_of_roll_axis_m != INT8_MAX) {
-        sysinfo |= (((aircraft.gnss_antenna_offset_right_of_roll_axis_m > 0) & 0b1) << 21);         // GAOR bitfield.
-        sysinfo |= (((ABS(aircraft.gnss_antenna_offset_right_of_roll_axis_m) >> 1) & 0b11) << 19);  // GAOD bitfield.
-        sysinfo |= (0b1 << 18);                                                                     // GAOK bitfield.
+    if (details.gnss_antenna_offset_right_of_roll_axis_m != INT8_MAX) {
+        sysinfo |= (((details.gnss_antenna_offset_right_of_roll_axis_m > 0) & 0b1) << 21);         // GAOR bitfield.
+        sysinfo |= (((ABS(details.gnss_antenna_offset_right_of_roll_axis_m) >> 1) & 0b11) << 19);  // GAOD bitfield.
+        sysinfo |= (0b1 << 18);                                                                    // GAOK bitfield.
     }
-    sysinfo |= ((aircraft.system_design_assurance & 0b11) << 16);                 // SDA bitfield.
-    sysinfo |= ((aircraft.source_integrity_level & 0b11) << 14);                  // SIL bitfield.
-    sysinfo |= ((aircraft.geometric_vertical_accuracy & 0b11) << 12);             // GVA bitfield
-    sysinfo |= ((aircraft.navigation_accuracy_category_position & 0b1111) << 8);  // NAC_p bitfield.
-    sysinfo |= ((aircraft.navigation_accuracy_category_velocity & 0b111) << 5);   // NAC_v bitfield.
-    sysinfo |= ((aircraft.navigation_integrity_category_baro & 0b1) << 4);        // NIC_baro bitfield.
-    sysinfo |= ((aircraft.navigation_integrity_category & 0b1111));               // NIC bitfield.
+    sysinfo |= ((details.system_design_assurance & 0b11) << 16);                 // SDA bitfield.
+    sysinfo |= ((details.source_integrity_level & 0b11) << 14);                  // SIL bitfield.
+    sysinfo |= ((details.geometric_vertical_accuracy & 0b11) << 12);             // GVA bitfield
+    sysinfo |= ((details.navigation_accuracy_category_position & 0b1111) << 8);  // NAC_p bitfield.
+    sysinfo |= ((details.navigation_accuracy_category_velocity & 0b111) << 5);   // NAC_v bitfield.
+    sysinfo |= ((details.navigation_integrity_category_baro & 0b1) << 4);        // NIC_baro bitfield.
+    sysinfo |= ((details.navigation_integrity_category & 0b1111));               // NIC bitfield.
+
+    CSBeeFixedPointDegrees lat = DegE7ToCSBeeFixedPointDegrees(aircraft.latitude_deg_e7);
+    CSBeeFixedPointDegrees lon = DegE7ToCSBeeFixedPointDegrees(aircraft.longitude_deg_e7);
 
     int16_t num_chars =  // Print everything except CRC into string buffer.
         snprintf(message_buf, kCSBeeMessageStrMaxLen - kCRCMaxNumChars - 1,
@@ -43,8 +71,8 @@ inline int16_t WriteCSBeeAircraftMessageStr(char message_buf[], const Aircraft &
                  "%s,"                                                     // CALL, e.g. N61ZP
                  "%04o,"                                                   // SQUAWK, e.g. 7232
                  "%d,"                                                     // ECAT, e.g. 14
-                 "%.5f,"                                                   // LAT, e.g. 57.57634
-                 "%.5f,"                                                   // LON, e.g. 17.59554
+                 "%s%" PRIu32 ".%05" PRIu32 ","                            // LAT, e.g. 57.57634
+                 "%s%" PRIu32 ".%05" PRIu32 ","                            // LON, e.g. 17.59554
                  "%d,"                                                     // ALT_BARO, e.g. 5000
                  "%d,"                                                     // ALT_GEO, e.g. 5000
                  "%.0f,"                                                   // TRACK, e.g. 35
@@ -60,8 +88,8 @@ inline int16_t WriteCSBeeAircraftMessageStr(char message_buf[], const Aircraft &
                  aircraft.callsign,                                        // CALL
                  aircraft.squawk,                                          // SQUAWK
                  aircraft.airframe_type,                                   // ECAT
-                 aircraft.latitude_deg,                                    // LAT
-                 aircraft.longitude_deg,                                   // LON
+                 lat.sign, lat.whole_deg, lat.fractional_deg_e5,          // LAT
+                 lon.sign, lon.whole_deg, lon.fractional_deg_e5,          // LON
                  aircraft.baro_altitude_ft,                                // ALT_BARO
                  aircraft.gnss_altitude_ft,                                // ALT_GEO
                  aircraft.track_deg,                                       // TRACK
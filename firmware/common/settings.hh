@@ -4,7 +4,7 @@
 #include <cstdint>
 #include <cstring>  // for memset
 
-static const uint32_t kSettingsVersionMagicWord = 0xBEEFEBEE;  // Change this when settings format changes!
+static const uint32_t kSettingsVersionMagicWord = 0xBEEFEBEF;  // Change this when settings format changes!
 
 class SettingsManager {
    public:
@@ -52,6 +52,10 @@ class SettingsManager {
         bool receiver_enabled = true;
         int tl_mv = kDefaultTLMV;
         bool bias_tee_enabled = false;
+        // Reference position for decoding surface CPR positions of aircraft that haven't been seen airborne.
+        bool receiver_position_valid = false;
+        int32_t receiver_latitude_deg_e7 = 0;
+        int32_t receiver_longitude_deg_e7 = 0;
 
         // CommunicationsManager settings
         LogLevel log_level = LogLevel::kInfo;  // Start with highest verbosity by default.
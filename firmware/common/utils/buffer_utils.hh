@@ -1,6 +1,7 @@
 #ifndef _BUFFER_UTILS_HH_
 #define _BUFFER_UTILS_HH_
 
+#include <array>
 #include <cstdint>
 
 void PrintBinary32(uint32_t);  // for debugging
@@ -9,6 +10,108 @@ uint32_t Get24BitWordFromBuffer(uint32_t first_bit_index, const uint32_t buffer[
 uint32_t GetNBitWordFromBuffer(uint16_t n, uint32_t first_bit_index, const uint32_t buffer[]);
 void SetNBitWordInBuffer(uint16_t n, uint32_t word, uint32_t first_bit_index, uint32_t buffer[]);
 
+/**
+ * Compile-time specialized version of GetNBitWordFromBuffer. The word index, shifts, and mask are all resolved at
+ * compile time, and the bitlength is checked with a static_assert instead of a runtime range check. Use this for
+ * fields at fixed positions in a packet.
+ * @tparam kNumBits Bitlength of word to extract. Must be between 1 and 32.
+ * @tparam kFirstBitIndex Bit index begin reading from (index of MSb of word to read). MSb of first word in buffer is
+ * bit 0.
+ * @param[in] buffer Buffer to read from.
+ * @retval Right-aligned kNumBits-bit word that was read from the buffer.
+ */
+template <uint16_t kNumBits, uint32_t kFirstBitIndex>
+inline uint32_t GetNBitWordFromBuffer(const uint32_t buffer[]) {
+    static_assert(kNumBits >= 1 && kNumBits <= 32, "Word bitlength must be between 1 and 32.");
+    constexpr uint32_t kWordIndex = kFirstBitIndex / 32;
+    constexpr uint16_t kBitOffset = kFirstBitIndex % 32;
+    constexpr uint32_t kMask = 0xFFFFFFFF >> (32 - kNumBits);
+    if constexpr (kBitOffset + kNumBits <= 32) {
+        // Word fits within a single buffer word.
+        return (buffer[kWordIndex] >> (32 - kBitOffset - kNumBits)) & kMask;
+    } else {
+        // Word spills over into the next buffer word.
+        return ((buffer[kWordIndex] << (kBitOffset + kNumBits - 32)) |
+                (buffer[kWordIndex + 1] >> (64 - kBitOffset - kNumBits))) &
+               kMask;
+    }
+}
+
+/**
+ * 64-bit version of the compile-time specialized GetNBitWordFromBuffer, used to unpack multi-character fields (e.g.
+ * callsigns) with a single read.
+ * @tparam kNumBits Bitlength of word to extract. Must be between 1 and 64, and the word must not span more than two
+ * 32-bit words in the buffer.
+ * @tparam kFirstBitIndex Bit index begin reading from (index of MSb of word to read). MSb of first word in buffer is
+ * bit 0.
+ * @param[in] buffer Buffer to read from.
+ * @retval Right-aligned kNumBits-bit word that was read from the buffer.
+ */
+template <uint16_t kNumBits, uint32_t kFirstBitIndex>
+inline uint64_t GetNBitWord64FromBuffer(const uint32_t buffer[]) {
+    constexpr uint32_t kWordIndex = kFirstBitIndex / 32;
+    constexpr uint16_t kBitOffset = kFirstBitIndex % 32;
+    static_assert(kNumBits >= 1 && kBitOffset + kNumBits <= 64, "Word must fit within two 32-bit buffer words.");
+    constexpr uint64_t kMask = 0xFFFFFFFFFFFFFFFF >> (64 - kNumBits);
+    uint64_t window = (static_cast<uint64_t>(buffer[kWordIndex]) << 32) | buffer[kWordIndex + 1];
+    return (window >> (64 - kBitOffset - kNumBits)) & kMask;
+}
+
+// CRC24 is used for Mode S / ADS-B parity checking.
+
+const uint32_t kCRC24Generator = 0x1FFF409;  // 25-bit generator polynomial, including the implicit MSb.
+const uint16_t kCRC24NumBits = 24;
+
+/**
+ * Generates the byte-wise lookup table for the Mode S CRC24. Entry i is the remainder of i * x^24 divided by the
+ * generator polynomial, which is what a bit-serial CRC would produce after shifting in the byte i.
+ * @retval 256-entry CRC24 lookup table.
+ */
+constexpr std::array<uint32_t, 256> GenerateCRC24Table() {
+    std::array<uint32_t, 256> table = {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i << 16;
+        for (uint16_t bit = 0; bit < 8; bit++) {
+            crc <<= 1;
+            if (crc & (1 << kCRC24NumBits)) {
+                crc ^= kCRC24Generator;
+            }
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+// Generated at compile time, lives in flash.
+inline constexpr std::array<uint32_t, 256> kCRC24Table = GenerateCRC24Table();
+
+/**
+ * Shifts one byte into a running Mode S CRC24 using kCRC24Table.
+ * @param[in] crc CRC of the bytes shifted in so far.
+ * @param[in] byte Next byte.
+ * @retval Updated 24-bit CRC.
+ */
+constexpr uint32_t UpdateCRC24(uint32_t crc, uint8_t byte) {
+    return ((crc << 8) ^ kCRC24Table[((crc >> 16) ^ byte) & 0xFF]) & 0xFFFFFF;
+}
+
+/**
+ * Calculates the Mode S 24-bit CRC over the data portion of a big-endian buffer of 32-bit words, one byte at a time
+ * using kCRC24Table. The last 24 bits of the packet (parity field) are excluded from the calculation, so the result
+ * should match the parity field of a valid packet with Address / Parity equal to 0.
+ * @param[in] buffer Buffer to calculate the CRC over. MSb of the first word is the oldest bit.
+ * @param[in] packet_len_bits Length of the packet in bits, including the 24-bit parity field. Must be a multiple of 8.
+ * @retval 24-bit CRC.
+ */
+constexpr uint32_t CalculateCRC24(const uint32_t buffer[], uint16_t packet_len_bits) {
+    uint32_t crc = 0;
+    uint16_t num_bytes = (packet_len_bits - kCRC24NumBits) / 8;
+    for (uint16_t i = 0; i < num_bytes; i++) {
+        crc = UpdateCRC24(crc, buffer[i / 4] >> (24 - 8 * (i % 4)));
+    }
+    return crc;
+}
+
 // CRC16 is used for inter-processor communication and reporting, not for ADS-B message decode.
 
 /**
@@ -4,6 +4,8 @@
 #include <stdint.h>
 
 #include <algorithm>  // For std::copy.
+#include <atomic>     // For SPSCQueue indices.
+#include <utility>    // For std::swap.
 
 template <class T>
 class PFBQueue {
@@ -51,7 +53,7 @@ class PFBQueue {
         if (next_tail == head_) {
             if (config_.overwrite_when_full) {
                 // Overwriting allowed; nudge the head to overwrite the first enqueued element.
-                head_++;
+                head_ = IncrementIndex(head_);
             } else {
                 // Overwriting not allowed; this push will result in an error.
                 return false;
@@ -135,4 +137,557 @@ class PFBQueue {
     uint16_t tail_ = 0;
 };
 
+/**
+ * Lock-free single-producer single-consumer variant of PFBQueue, for handing off elements from an interrupt handler to
+ * the main loop, or from one core to the other. Push must only be called by the producer, and Pop, Length and Clear
+ * must only be called by the consumer. Indices are only ever written by one side, with release stores that the other
+ * side reads with acquire loads, so no locks or read-modify-write instructions are needed (the RP2040 doesn't have
+ * any).
+ *
+ * When overwrite_when_full is set, the producer never waits for the consumer: pushing onto a full queue overwrites the
+ * oldest element, and the consumer skips over elements that were overwritten. An element that gets overwritten while
+ * the consumer is copying it is detected by re-reading the tail afterwards, and the copy is thrown away.
+ */
+template <class T>
+class SPSCQueue {
+   public:
+    struct SPSCQueueConfig {
+        uint16_t buf_len_num_elements = 0;
+        T *buffer = nullptr;
+        bool overwrite_when_full = false;
+    };
+
+    /**
+     * Constructor.
+     * NOTE: Copy and move constructors are not implemented! See PFBQueue.
+     * @param[in] config_in Defines length of the buffer, and points to the buffer of size buf_len_num_elements if
+     * SPSCQueue should work with a pre-allocated buffer. If config_in.buffer is left as nullptr, a buffer will be
+     * dynamically allocated of size buf_len_num_elements * sizeof(T).
+     * @retval SPSCQueue object.
+     */
+    SPSCQueue(SPSCQueueConfig config_in)
+        : config_(config_in),
+          buffer_length_(config_in.buf_len_num_elements),
+          index_wrap_(config_in.buf_len_num_elements * (kMaxIndexWrap / config_in.buf_len_num_elements)) {
+        if (config_.buffer == nullptr) {
+            config_.buffer = (T *)malloc(sizeof(T) * buffer_length_);
+            buffer_was_dynamically_allocated_ = true;
+        }
+    }
+
+    /**
+     * Destructor. Frees the buffer if it was dynamically allocated.
+     */
+    ~SPSCQueue() {
+        if (buffer_was_dynamically_allocated_ && config_.buffer != nullptr) {
+            free(config_.buffer);
+            config_.buffer = nullptr;
+        }
+    }
+
+    /**
+     * Pushes an element onto the back of the queue. Producer only.
+     * @param[in] element Object to push onto the back of the queue.
+     * @retval True if succeeded, false if the queue is full and overwriting isn't allowed.
+     */
+    bool Push(const T &element) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);  // Only written by the producer.
+        if (config_.overwrite_when_full) {
+            // The slot being written may be the one the consumer is copying. Keep the write after the previous tail
+            // update, so that the consumer sees the tail move past its head if it read any of the new element.
+            std::atomic_thread_fence(std::memory_order_release);
+        } else if (Distance(head_.load(std::memory_order_acquire), tail) >= MaxNumElements()) {
+            return false;  // Full.
+        }
+        config_.buffer[tail % buffer_length_] = element;
+        tail_.store(IncrementIndex(tail), std::memory_order_release);  // Publish the element to the consumer.
+        return true;
+    }
+
+    /**
+     * Pops an element from the front of the queue. Consumer only.
+     * @param[out] element Reference to an object that will be overwritten by the contents of the popped element.
+     * @retval True if successful, false if the queue is empty.
+     */
+    bool Pop(T &element) {
+        uint32_t head = head_.load(std::memory_order_relaxed);  // Only written by the consumer.
+        while (true) {
+            uint32_t tail = tail_.load(std::memory_order_acquire);
+            uint32_t length = Distance(head, tail);
+            if (length == 0) {
+                return false;
+            }
+            if (length > MaxNumElements()) {
+                // Oldest elements were overwritten by the producer, skip to the oldest one that's left.
+                head = SubtractIndex(tail, MaxNumElements());
+            }
+            element = config_.buffer[head % buffer_length_];
+            if (config_.overwrite_when_full) {
+                // Re-read the tail after the copy. If the producer has since wrapped around to this slot, the copy
+                // may be torn, so drop it and try again with the new oldest element.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (Distance(head, tail_.load(std::memory_order_relaxed)) > MaxNumElements()) {
+                    continue;
+                }
+            }
+            head_.store(IncrementIndex(head), std::memory_order_release);  // Hand the slot back to the producer.
+            return true;
+        }
+    }
+
+    /**
+     * Returns the number of elements currently in the queue. Consumer only.
+     * @retval Number of elements in the queue.
+     */
+    uint16_t Length() const {
+        uint32_t length = Distance(head_.load(std::memory_order_relaxed), tail_.load(std::memory_order_acquire));
+        return length > MaxNumElements() ? MaxNumElements() : length;
+    }
+
+    /**
+     * Return the maximum number of elements that can be stored in the queue. This is one less than the length of the
+     * buffer, to match PFBQueue.
+     * @retval Number of elements that can be stored in the queue.
+     */
+    inline uint16_t MaxNumElements() const { return buffer_length_ - 1; }
+
+    /**
+     * Empty out the queue by setting the head equal to the tail. Consumer only.
+     */
+    void Clear() { head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release); }
+
+   private:
+    // Indices count up to a multiple of the buffer length near 2^31 before wrapping, instead of wrapping at the buffer
+    // length, so that an overwriting producer can get far ahead of the consumer without the distance between them
+    // becoming ambiguous. Slots are found with index % buffer_length_.
+    static const uint32_t kMaxIndexWrap = 0x80000000;
+
+    /**
+     * Increments and wraps an index.
+     * @param[in] index Value to increment, must be < index_wrap_.
+     * @retval Incremented and wrapped value.
+     */
+    inline uint32_t IncrementIndex(uint32_t index) const { return index + 1 >= index_wrap_ ? 0 : index + 1; }
+
+    /**
+     * Subtracts from an index, wrapping if necessary.
+     * @param[in] index Value to subtract from, must be < index_wrap_.
+     * @param[in] decrement Value to subtract, must be <= index_wrap_.
+     * @retval Decremented and wrapped value.
+     */
+    inline uint32_t SubtractIndex(uint32_t index, uint32_t decrement) const {
+        return index >= decrement ? index - decrement : index + index_wrap_ - decrement;
+    }
+
+    /**
+     * Returns the number of increments needed to get from one index to another.
+     * @param[in] from Starting index, must be < index_wrap_.
+     * @param[in] to Ending index, must be < index_wrap_.
+     * @retval Distance from the starting index to the ending index.
+     */
+    inline uint32_t Distance(uint32_t from, uint32_t to) const {
+        return to >= from ? to - from : to + index_wrap_ - from;
+    }
+
+    SPSCQueueConfig config_;
+    bool buffer_was_dynamically_allocated_ = false;
+    uint16_t buffer_length_;
+    uint32_t index_wrap_;
+    std::atomic<uint32_t> head_ = 0;  // Written by the consumer.
+    std::atomic<uint32_t> tail_ = 0;  // Written by the producer.
+};
+
+/**
+ * Fixed-capacity hash map with uint32_t keys, for use where heap allocation isn't acceptable. Values live in a
+ * statically allocated slot array and never move once inserted, so pointers returned by Find() / GetOrInsert() stay
+ * valid until the element is erased. Keys are indexed by a separate open-addressing table using Robin Hood probing
+ * (entries that are far from their home bucket steal buckets from entries that are close to theirs), which keeps probe
+ * sequences short and lets lookups of missing keys stop early. Erasing uses backward-shift deletion, so there are no
+ * tombstones to clean up.
+ * @tparam T Value type. Must be default constructible and copy assignable.
+ * @tparam kMaxNumElements Maximum number of elements that can be stored in the map.
+ */
+template <class T, uint16_t kMaxNumElements>
+class FixedHashMap {
+   public:
+    // Index is sized to the smallest power of two with at least twice as many buckets as elements, so the load factor
+    // never exceeds 0.5.
+    static constexpr uint16_t kIndexNumBits = []() {
+        uint16_t num_bits = 0;
+        while ((1u << num_bits) < 2u * kMaxNumElements) num_bits++;
+        return num_bits;
+    }();
+    static constexpr uint16_t kIndexLen = 1u << kIndexNumBits;
+    static_assert(kMaxNumElements > 0 && kIndexLen <= UINT16_MAX, "FixedHashMap capacity out of range.");
+
+    /**
+     * Iterates over occupied value slots in slot order. Iteration order is stable as long as no elements are inserted.
+     * Erasing the element that an iterator points to is allowed and does not invalidate the iterator.
+     */
+    template <class MapType, class ValueType>
+    class IteratorBase {
+       public:
+        IteratorBase(MapType *map, uint16_t slot) : map_(map), slot_(slot) { SkipEmptySlots(); }
+        ValueType &operator*() const { return map_->slots_[slot_]; }
+        ValueType *operator->() const { return &(map_->slots_[slot_]); }
+        IteratorBase &operator++() {
+            slot_++;
+            SkipEmptySlots();
+            return *this;
+        }
+        bool operator==(const IteratorBase &other) const { return slot_ == other.slot_; }
+        bool operator!=(const IteratorBase &other) const { return slot_ != other.slot_; }
+
+       private:
+        void SkipEmptySlots() {
+            while (slot_ < kMaxNumElements && !map_->slot_occupied_[slot_]) slot_++;
+        }
+
+        MapType *map_;
+        uint16_t slot_;
+    };
+    typedef IteratorBase<FixedHashMap, T> Iterator;
+    typedef IteratorBase<const FixedHashMap, const T> ConstIterator;
+
+    /**
+     * Constructor. Starts out empty.
+     */
+    FixedHashMap() { Clear(); }
+
+    /**
+     * Removes all elements from the map.
+     */
+    void Clear() {
+        for (uint16_t i = 0; i < kIndexLen; i++) {
+            index_[i].slot = kEmptySlot;
+        }
+        for (uint16_t i = 0; i < kMaxNumElements; i++) {
+            slot_occupied_[i] = false;
+            // Pop order hands out the lowest slots first.
+            free_slots_[i] = kMaxNumElements - 1 - i;
+        }
+        num_free_slots_ = kMaxNumElements;
+    }
+
+    /**
+     * Looks up an element by key.
+     * @param[in] key Key to look up.
+     * @retval Pointer to the element, or nullptr if the key is not in the map.
+     */
+    T *Find(uint32_t key) {
+        uint16_t bucket = FindBucket(key);
+        return bucket == kNotFound ? nullptr : &slots_[index_[bucket].slot];
+    }
+    const T *Find(uint32_t key) const {
+        uint16_t bucket = FindBucket(key);
+        return bucket == kNotFound ? nullptr : &slots_[index_[bucket].slot];
+    }
+
+    /**
+     * Checks if a key is in the map.
+     * @param[in] key Key to look for.
+     * @retval True if the key is in the map, false otherwise.
+     */
+    bool Contains(uint32_t key) const { return FindBucket(key) != kNotFound; }
+
+    /**
+     * Looks up an element by key, and reserves a slot for it if it isn't in the map yet. Walks the probe sequence only
+     * once for both the lookup and the insertion.
+     * @param[in] key Key to look up or insert.
+     * @param[out] inserted Set to true if a new slot was reserved for the key. The contents of a newly reserved slot
+     * are left over from its previous occupant, and must be initialized by the caller.
+     * @retval Pointer to the element, or nullptr if the key was not found and the map is full.
+     */
+    T *GetOrInsert(uint32_t key, bool &inserted) {
+        inserted = false;
+        uint16_t bucket = HomeBucket(key);
+        uint16_t probe_distance = 0;
+        while (true) {
+            IndexEntry &entry = index_[bucket];
+            if (entry.slot == kEmptySlot || entry.probe_distance < probe_distance) {
+                break;  // Key isn't in the map. This is where it would be inserted.
+            }
+            if (entry.key == key) {
+                return &slots_[entry.slot];
+            }
+            bucket = (bucket + 1) & kIndexMask;
+            probe_distance++;
+        }
+
+        if (num_free_slots_ == 0) {
+            return nullptr;
+        }
+        uint16_t slot = free_slots_[--num_free_slots_];
+        slot_occupied_[slot] = true;
+        inserted = true;
+
+        // Robin Hood insertion: place the new entry here and carry the displaced entry forward until it finds an
+        // empty bucket, swapping with any entry that is closer to its home bucket than the carried entry.
+        IndexEntry carry = {.key = key, .slot = slot, .probe_distance = probe_distance};
+        while (true) {
+            IndexEntry &entry = index_[bucket];
+            if (entry.slot == kEmptySlot) {
+                entry = carry;
+                break;
+            }
+            if (entry.probe_distance < carry.probe_distance) {
+                std::swap(entry, carry);
+            }
+            bucket = (bucket + 1) & kIndexMask;
+            carry.probe_distance++;
+        }
+        return &slots_[slot];
+    }
+
+    /**
+     * Inserts an element, overwriting the existing element if the key is already in the map.
+     * @param[in] key Key to insert.
+     * @param[in] value Value to store.
+     * @retval True if successful, false if the key was not in the map and the map is full.
+     */
+    bool Insert(uint32_t key, const T &value) {
+        bool inserted;
+        T *element = GetOrInsert(key, inserted);
+        if (element == nullptr) {
+            return false;
+        }
+        *element = value;
+        return true;
+    }
+
+    /**
+     * Removes an element from the map. Pointers to other elements are not affected.
+     * @param[in] key Key of the element to remove.
+     * @retval True if the element was removed, false if the key was not in the map.
+     */
+    bool Erase(uint32_t key) {
+        uint16_t bucket = FindBucket(key);
+        if (bucket == kNotFound) {
+            return false;
+        }
+        uint16_t slot = index_[bucket].slot;
+        slot_occupied_[slot] = false;
+        free_slots_[num_free_slots_++] = slot;
+
+        // Backward-shift deletion: pull subsequent entries in the same run one bucket closer to home.
+        uint16_t next_bucket = (bucket + 1) & kIndexMask;
+        while (index_[next_bucket].slot != kEmptySlot && index_[next_bucket].probe_distance > 0) {
+            index_[bucket] = index_[next_bucket];
+            index_[bucket].probe_distance--;
+            bucket = next_bucket;
+            next_bucket = (next_bucket + 1) & kIndexMask;
+        }
+        index_[bucket].slot = kEmptySlot;
+        return true;
+    }
+
+    /**
+     * Returns the slot that an element is stored in. The slot doesn't change for as long as the element is in the map,
+     * so it can be used to index side tables that hold extra data for each element.
+     * @param[in] element Pointer to an element in the map, as returned by Find() or GetOrInsert().
+     * @retval Slot index, from 0 to kMaxNumElements - 1.
+     */
+    inline uint16_t GetSlotIndex(const T *element) const { return element - slots_; }
+
+    /**
+     * Returns the element stored in a slot.
+     * @param[in] slot_index Slot to look in, from 0 to kMaxNumElements - 1.
+     * @retval Pointer to the element, or nullptr if the slot is empty or out of range.
+     */
+    T *GetBySlotIndex(uint16_t slot_index) {
+        return slot_index < kMaxNumElements && slot_occupied_[slot_index] ? &slots_[slot_index] : nullptr;
+    }
+
+    /**
+     * Returns the number of elements in the map.
+     * @retval Number of elements.
+     */
+    inline uint16_t Size() const { return kMaxNumElements - num_free_slots_; }
+
+    /**
+     * Returns the maximum number of elements that can be stored in the map.
+     * @retval Capacity of the map.
+     */
+    inline uint16_t MaxNumElements() const { return kMaxNumElements; }
+
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, kMaxNumElements); }
+    ConstIterator begin() const { return ConstIterator(this, 0); }
+    ConstIterator end() const { return ConstIterator(this, kMaxNumElements); }
+
+   private:
+    static constexpr uint16_t kIndexMask = kIndexLen - 1;
+    static constexpr uint16_t kEmptySlot = UINT16_MAX;
+    static constexpr uint16_t kNotFound = UINT16_MAX;
+
+    struct IndexEntry {
+        uint32_t key;
+        uint16_t slot;            // Index into slots_, or kEmptySlot if the bucket is empty.
+        uint16_t probe_distance;  // Number of buckets between this bucket and the key's home bucket.
+    };
+
+    /**
+     * Fibonacci hash of the key, which spreads out ICAO addresses that are allocated in contiguous blocks.
+     * @param[in] key Key to hash.
+     * @retval Home bucket of the key in the index.
+     */
+    static inline uint16_t HomeBucket(uint32_t key) { return (key * 2654435769u) >> (32 - kIndexNumBits); }
+
+    /**
+     * Finds the index bucket that holds a key.
+     * @param[in] key Key to look for.
+     * @retval Bucket index, or kNotFound if the key is not in the map.
+     */
+    uint16_t FindBucket(uint32_t key) const {
+        uint16_t bucket = HomeBucket(key);
+        uint16_t probe_distance = 0;
+        while (true) {
+            const IndexEntry &entry = index_[bucket];
+            // A Robin Hood run never holds an entry that is closer to home than the key being searched for would be,
+            // so the search can stop as soon as it sees one.
+            if (entry.slot == kEmptySlot || entry.probe_distance < probe_distance) {
+                return kNotFound;
+            }
+            if (entry.key == key) {
+                return bucket;
+            }
+            bucket = (bucket + 1) & kIndexMask;
+            probe_distance++;
+        }
+    }
+
+    IndexEntry index_[kIndexLen];
+    T slots_[kMaxNumElements];
+    bool slot_occupied_[kMaxNumElements];
+    uint16_t free_slots_[kMaxNumElements];  // Stack of unoccupied slot indices.
+    uint16_t num_free_slots_ = kMaxNumElements;
+};
+
+/**
+ * Doubly linked list of indices from 0 to kMaxNumElements - 1, for ordering elements that are stored in a fixed-size
+ * array (e.g. the slots of a FixedHashMap) without moving them. Links are kept in arrays indexed by element, so
+ * inserting, removing, and moving an element are all O(1) and no memory is allocated.
+ * @tparam kMaxNumElements Number of indices that can be stored in the list.
+ */
+template <uint16_t kMaxNumElements>
+class IndexedLinkedList {
+   public:
+    static constexpr uint16_t kInvalidIndex = UINT16_MAX;
+    static_assert(kMaxNumElements < kInvalidIndex - 1, "IndexedLinkedList capacity out of range.");
+
+    /**
+     * Constructor. Starts out empty.
+     */
+    IndexedLinkedList() { Clear(); }
+
+    /**
+     * Removes all indices from the list.
+     */
+    void Clear() {
+        for (uint16_t i = 0; i < kMaxNumElements; i++) {
+            prev_[i] = kUnlinked;
+            next_[i] = kUnlinked;
+        }
+        head_ = kInvalidIndex;
+        tail_ = kInvalidIndex;
+        length_ = 0;
+    }
+
+    /**
+     * Checks if an index is in the list.
+     * @param[in] index Index to look for.
+     * @retval True if the index is in the list, false otherwise.
+     */
+    inline bool Contains(uint16_t index) const { return index < kMaxNumElements && prev_[index] != kUnlinked; }
+
+    /**
+     * Inserts an index into the list before another index. If the index is already in the list, it is moved.
+     * @param[in] index Index to insert.
+     * @param[in] next_index Index that the inserted index should come before. Use kInvalidIndex to insert at the back
+     * of the list.
+     * @retval True if successful, false if index is out of range or next_index is not in the list.
+     */
+    bool InsertBefore(uint16_t index, uint16_t next_index) {
+        if (index >= kMaxNumElements || index == next_index ||
+            (next_index != kInvalidIndex && !Contains(next_index))) {
+            return false;
+        }
+        Remove(index);
+        uint16_t prev_index = next_index == kInvalidIndex ? tail_ : prev_[next_index];
+        prev_[index] = prev_index;
+        next_[index] = next_index;
+        (prev_index == kInvalidIndex ? head_ : next_[prev_index]) = index;
+        (next_index == kInvalidIndex ? tail_ : prev_[next_index]) = index;
+        length_++;
+        return true;
+    }
+
+    /**
+     * Inserts an index at the back of the list, or moves it there if it's already in the list.
+     * @param[in] index Index to insert or move.
+     * @retval True if successful, false if index is out of range.
+     */
+    inline bool MoveToBack(uint16_t index) { return InsertBefore(index, kInvalidIndex); }
+
+    /**
+     * Removes an index from the list.
+     * @param[in] index Index to remove.
+     * @retval True if the index was removed, false if it wasn't in the list.
+     */
+    bool Remove(uint16_t index) {
+        if (!Contains(index)) {
+            return false;
+        }
+        uint16_t prev_index = prev_[index];
+        uint16_t next_index = next_[index];
+        (prev_index == kInvalidIndex ? head_ : next_[prev_index]) = next_index;
+        (next_index == kInvalidIndex ? tail_ : prev_[next_index]) = prev_index;
+        prev_[index] = kUnlinked;
+        next_[index] = kUnlinked;
+        length_--;
+        return true;
+    }
+
+    /**
+     * Returns the index at the front of the list.
+     * @retval Index at the front of the list, or kInvalidIndex if the list is empty.
+     */
+    inline uint16_t Front() const { return head_; }
+
+    /**
+     * Returns the index at the back of the list.
+     * @retval Index at the back of the list, or kInvalidIndex if the list is empty.
+     */
+    inline uint16_t Back() const { return tail_; }
+
+    /**
+     * Returns the index after an index in the list.
+     * @param[in] index Index in the list.
+     * @retval Next index, or kInvalidIndex if index is at the back of the list or not in the list.
+     */
+    inline uint16_t Next(uint16_t index) const { return Contains(index) ? next_[index] : kInvalidIndex; }
+
+    /**
+     * Returns the index before an index in the list.
+     * @param[in] index Index in the list.
+     * @retval Previous index, or kInvalidIndex if index is at the front of the list or not in the list.
+     */
+    inline uint16_t Prev(uint16_t index) const { return Contains(index) ? prev_[index] : kInvalidIndex; }
+
+    /**
+     * Returns the number of indices in the list.
+     * @retval Number of indices in the list.
+     */
+    inline uint16_t Length() const { return length_; }
+
+   private:
+    static constexpr uint16_t kUnlinked = kInvalidIndex - 1;  // Marks indices that aren't in the list.
+
+    uint16_t prev_[kMaxNumElements];
+    uint16_t next_[kMaxNumElements];
+    uint16_t head_ = kInvalidIndex;
+    uint16_t tail_ = kInvalidIndex;
+    uint16_t length_ = 0;
+};
+
 #endif
\ No newline at end of file
@@ -8,9 +8,9 @@ static const int kBitsPerNibble = 4;
 
 inline uint16_t CeilBitsToBytes(uint16_t bits) { return (bits + kBitsPerByte - 1) / kBitsPerByte; }
 
-inline int FeetToMeters(int feet) { return feet * 1000 / 3280; }
+constexpr int FeetToMeters(int feet) { return feet * 1000 / 3280; }
 
-inline int MetersToFeet(int meters) { return meters * 3280 / 1000; }
+constexpr int MetersToFeet(int meters) { return meters * 3280 / 1000; }
 
 inline int KtsToMps(int kts) { return kts * 5144 / 10000; }
 
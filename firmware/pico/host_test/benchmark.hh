@@ -0,0 +1,39 @@
+#ifndef _BENCHMARK_HH_
+#define _BENCHMARK_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Runs a function repeatedly and returns the average wall-clock time per call. Host timings are only useful for
+ * relative comparisons between implementations, not as an estimate of on-target performance.
+ * @param[in] num_iterations Number of times to call func.
+ * @param[in] func Function to benchmark.
+ * @retval Average time per call, in nanoseconds.
+ */
+template <typename Func>
+double BenchmarkNsPerCall(uint32_t num_iterations, Func &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_iterations; i++) {
+        func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / num_iterations;
+}
+
+/**
+ * Prints a benchmark comparison line so that results are easy to find in the test output.
+ * @param[in] name Name of the benchmark.
+ * @param[in] baseline_ns Time per call of the baseline implementation, in nanoseconds.
+ * @param[in] optimized_ns Time per call of the optimized implementation, in nanoseconds.
+ */
+inline void PrintBenchmarkComparison(const char *name, double baseline_ns, double optimized_ns) {
+    printf("[ BENCHMARK] %s: baseline %.1f ns, optimized %.1f ns (%.2fx)\r\n", name, baseline_ns, optimized_ns,
+           baseline_ns / optimized_ns);
+}
+
+// Keeps the compiler from optimizing away benchmarked work whose result is otherwise unused.
+inline volatile uint32_t benchmark_sink = 0;
+
+#endif /* _BENCHMARK_HH_ */
@@ -0,0 +1,48 @@
+#ifndef _PACKET_TEST_UTILS_HH_
+#define _PACKET_TEST_UTILS_HH_
+
+#include <cstdint>
+#include <cstdio>
+
+#include "transponder_packet.hh"
+
+// Returns a packet with the given data (32 or 88 bits) followed by an Address / Parity field for an ICAO address.
+inline DecodedTransponderPacket MakeAddressParityPacket(const char *data_str, uint32_t icao_address) {
+    char packet_str[29];
+    snprintf(packet_str, sizeof(packet_str), "%s000000", data_str);
+    DecodedTransponderPacket packet = DecodedTransponderPacket(packet_str);
+    uint32_t parity = packet.CalculateCRC24(packet.GetPacketBufferLenBits());
+    snprintf(packet_str, sizeof(packet_str), "%s%06X", data_str, parity ^ icao_address);
+    return DecodedTransponderPacket(packet_str);
+}
+
+// Returns a CRC-clean extended squitter with the given DF, CA, ICAO address and ME fields (88 bits).
+inline DecodedTransponderPacket MakeExtendedSquitter(const char *data_str) {
+    char packet_str[29];
+    snprintf(packet_str, sizeof(packet_str), "%s000000", data_str);
+    uint32_t parity = DecodedTransponderPacket(packet_str).CalculateCRC24();
+    snprintf(packet_str, sizeof(packet_str), "%s%06X", data_str, parity);
+    return DecodedTransponderPacket(packet_str);
+}
+
+// Returns an acquisition squitter (DF=11, interrogator code 0) from an airborne aircraft.
+inline DecodedTransponderPacket MakeAcquisitionSquitter(uint32_t icao_address) {
+    char packet_str[15];
+    snprintf(packet_str, sizeof(packet_str), "5D%06X000000", icao_address);
+    uint32_t parity =
+        DecodedTransponderPacket(packet_str).CalculateCRC24(DecodedTransponderPacket::kSquitterPacketLenBits);
+    snprintf(packet_str, sizeof(packet_str), "5D%06X%06X", icao_address, parity);
+    return DecodedTransponderPacket(packet_str);
+}
+
+// Returns an Aircraft ID packet from the given ICAO address, with one bit flipped in the ME field so that it needs to
+// be repaired with bit error correction.
+inline DecodedTransponderPacket MakeCorruptedExtendedSquitter(uint32_t icao_address) {
+    char packet_str[29];
+    snprintf(packet_str, sizeof(packet_str), "8D%06X2058F6B1E35C60000000", icao_address);
+    uint32_t parity = DecodedTransponderPacket(packet_str).CalculateCRC24();
+    snprintf(packet_str, sizeof(packet_str), "8D%06X2258F6B1E35C60%06X", icao_address, parity);
+    return DecodedTransponderPacket(packet_str);
+}
+
+#endif /* _PACKET_TEST_UTILS_HH_ */
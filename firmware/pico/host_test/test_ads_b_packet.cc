@@ -1,3 +1,7 @@
+#include <cstring>
+#include <random>
+
+#include "benchmark.hh"
 #include "gtest/gtest.h"
 #include "transponder_packet.hh"
 
@@ -38,6 +42,33 @@ TEST(DecodedTransponderPacket, GetNBitWordFromBuffer) {
     EXPECT_EQ(GetNBitWordFromBuffer(16, 32 * 3 + 16, packet_buffer), 0x504Du);
 }
 
+TEST(DecodedTransponderPacket, GetNBitWordFromBufferCompileTime) {
+    uint32_t packet_buffer[DecodedTransponderPacket::kMaxPacketLenWords32];
+    packet_buffer[0] = 0x8D76CE88u;
+    packet_buffer[1] = 0x204C9072u;
+    packet_buffer[2] = 0xCB48209Au;
+    packet_buffer[3] = 0x0000504Du;
+
+    // Within a single word.
+    EXPECT_EQ((GetNBitWordFromBuffer<1, 0>(packet_buffer)), 0b1u);
+    EXPECT_EQ((GetNBitWordFromBuffer<5, 0>(packet_buffer)), GetNBitWordFromBuffer(5, 0, packet_buffer));
+    EXPECT_EQ((GetNBitWordFromBuffer<32, 0>(packet_buffer)), 0x8D76CE88u);
+    EXPECT_EQ((GetNBitWordFromBuffer<24, 8>(packet_buffer)), 0x76CE88u);
+    EXPECT_EQ((GetNBitWordFromBuffer<16, 32 * 3 + 16>(packet_buffer)), 0x504Du);
+
+    // Spanning two words.
+    EXPECT_EQ((GetNBitWordFromBuffer<32, 4>(packet_buffer)), 0xD76CE882u);
+    EXPECT_EQ((GetNBitWordFromBuffer<32, 16>(packet_buffer)), 0xCE88204Cu);
+    EXPECT_EQ((GetNBitWordFromBuffer<17, 54>(packet_buffer)), GetNBitWordFromBuffer(17, 54, packet_buffer));
+    EXPECT_EQ((GetNBitWordFromBuffer<17, 71>(packet_buffer)), GetNBitWordFromBuffer(17, 71, packet_buffer));
+    EXPECT_EQ((GetNBitWordFromBuffer<13, 19>(packet_buffer)), GetNBitWordFromBuffer(13, 19, packet_buffer));
+
+    // 64-bit words.
+    EXPECT_EQ((GetNBitWord64FromBuffer<64, 0>(packet_buffer)), 0x8D76CE88204C9072u);
+    EXPECT_EQ((GetNBitWord64FromBuffer<56, 32>(packet_buffer)), 0x204C9072CB4820u);
+    EXPECT_EQ((GetNBitWord64FromBuffer<42, 40>(packet_buffer)), 0x4C9072CB482u >> 2);
+}
+
 TEST(DecodedTransponderPacket, SetNBitWordInBuffer) {
     uint32_t packet_buffer[DecodedTransponderPacket::kMaxPacketLenWords32];
     packet_buffer[0] = 0x8D76CE88u;
@@ -176,6 +207,194 @@ TEST(DecodedTransponderPacket, CRC24Checksum) {
     packet_buffer[3] = 0x504D0000u;  // reset last word
 }
 
+/**
+ * Bit-serial reference implementation of the Mode S CRC24, from
+ * https://mode-s.org/decode/book-the_1090mhz_riddle-junzi_sun.pdf pg. 91. Used to check and benchmark the table-driven
+ * implementation.
+ */
+uint32_t CalculateCRC24BitSerial(const uint32_t buffer[DecodedTransponderPacket::kMaxPacketLenWords32],
+                                 uint16_t packet_len_bits) {
+    uint32_t crc_buffer[DecodedTransponderPacket::kMaxPacketLenWords32];
+    for (uint16_t i = 0; i < DecodedTransponderPacket::kMaxPacketLenWords32; i++) {
+        crc_buffer[i] = buffer[i];
+    }
+    SetNBitWordInBuffer(24, 0x0, packet_len_bits - 24, crc_buffer);
+    for (uint16_t i = 0; i < packet_len_bits - 24; i++) {
+        uint32_t word = GetNBitWordFromBuffer(25, i, crc_buffer);
+        if (word & (0b1 << 24)) {
+            SetNBitWordInBuffer(25, word ^ kCRC24Generator, i, crc_buffer);
+        }
+    }
+    return GetNBitWordFromBuffer(24, packet_len_bits - 24, crc_buffer);
+}
+
+TEST(DecodedTransponderPacket, CRC24TableMatchesBitSerial) {
+    std::mt19937 rng(1090);
+    uint32_t packet_buffer[DecodedTransponderPacket::kMaxPacketLenWords32];
+    for (uint16_t i = 0; i < 10000; i++) {
+        for (uint16_t j = 0; j < DecodedTransponderPacket::kMaxPacketLenWords32; j++) {
+            packet_buffer[j] = rng();
+        }
+        packet_buffer[3] &= 0xFFFF0000;  // Trim to 112 bits.
+        ASSERT_EQ(CalculateCRC24(packet_buffer, 112), CalculateCRC24BitSerial(packet_buffer, 112));
+        ASSERT_EQ(CalculateCRC24(packet_buffer, 56), CalculateCRC24BitSerial(packet_buffer, 56));
+    }
+}
+
+TEST(DecodedTransponderPacket, CRC24Benchmark) {
+    const uint32_t kNumIterations = 100000;
+    uint32_t packet_buffer[DecodedTransponderPacket::kMaxPacketLenWords32] = {0x8D76CE88u, 0x204C9072u, 0xCB48209Au,
+                                                                              0x504D0000u};
+    for (uint16_t packet_len_bits : {56, 112}) {
+        double bit_serial_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+            packet_buffer[0] ^= i;
+            benchmark_sink = CalculateCRC24BitSerial(packet_buffer, packet_len_bits);
+        });
+        double table_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+            packet_buffer[0] ^= i;
+            benchmark_sink = CalculateCRC24(packet_buffer, packet_len_bits);
+        });
+        PrintBenchmarkComparison(packet_len_bits == 56 ? "CRC24 56-bit" : "CRC24 112-bit", bit_serial_ns, table_ns);
+    }
+}
+
+TEST(ModeSFrame, PackAndUnpackWords) {
+    std::mt19937 rng(1090);
+    uint32_t packet_buffer[ModeSFrame::kMaxLenWords32];
+    uint32_t check_buffer[ModeSFrame::kMaxLenWords32];
+    for (uint16_t i = 0; i < 1000; i++) {
+        for (uint16_t j = 0; j < ModeSFrame::kMaxLenWords32; j++) {
+            packet_buffer[j] = rng();
+        }
+        // Long frame. Bits past the end of the frame are dropped.
+        ModeSFrame frame = ModeSFrame(packet_buffer, 112);
+        packet_buffer[3] &= 0xFFFF0000;
+        frame.ToWords32(check_buffer, 112);
+        for (uint16_t j = 0; j < ModeSFrame::kMaxLenWords32; j++) {
+            ASSERT_EQ(check_buffer[j], packet_buffer[j]);
+        }
+        ASSERT_EQ(frame.CalculateCRC24(112), CalculateCRC24(packet_buffer, 112));
+        ASSERT_EQ(frame.GetParity(), (GetNBitWordFromBuffer<24, 88>(packet_buffer)));
+        ASSERT_EQ((frame.GetHeaderField<5, 0>()), (GetNBitWordFromBuffer<5, 0>(packet_buffer)));
+        ASSERT_EQ((frame.GetHeaderField<24, 8>()), (GetNBitWordFromBuffer<24, 8>(packet_buffer)));
+        ASSERT_EQ((frame.GetMessageField<56, 0>()), (GetNBitWord64FromBuffer<56, 32>(packet_buffer)));
+        ASSERT_EQ((frame.GetMessageField<17, 39>()), (GetNBitWordFromBuffer<17, 71>(packet_buffer)));
+
+        // Short frame.
+        frame = ModeSFrame(packet_buffer, 56);
+        packet_buffer[1] &= 0xFFFFFF00;
+        packet_buffer[2] = 0;
+        packet_buffer[3] = 0;
+        frame.ToWords32(check_buffer, 56);
+        for (uint16_t j = 0; j < ModeSFrame::kMaxLenWords32; j++) {
+            ASSERT_EQ(check_buffer[j], packet_buffer[j]);
+        }
+        ASSERT_EQ(frame.message, 0u);
+        ASSERT_EQ(frame.CalculateCRC24(56), CalculateCRC24(packet_buffer, 56));
+        ASSERT_EQ(frame.GetParity(), (GetNBitWordFromBuffer<24, 32>(packet_buffer)));
+    }
+}
+
+TEST(ModeSFrame, FlipBit) {
+    uint32_t packet_buffer[ModeSFrame::kMaxLenWords32] = {0x8D76CE88u, 0x204C9072u, 0xCB48209Au, 0x504D0000u};
+    uint32_t check_buffer[ModeSFrame::kMaxLenWords32];
+    for (uint16_t packet_len_bits : {56, 112}) {
+        for (uint16_t bit_index = 0; bit_index < packet_len_bits; bit_index++) {
+            ModeSFrame frame = ModeSFrame(packet_buffer, packet_len_bits);
+            frame.FlipBit(bit_index, packet_len_bits);
+            frame.ToWords32(check_buffer, packet_len_bits);
+            uint32_t flipped_buffer[ModeSFrame::kMaxLenWords32];
+            ModeSFrame(packet_buffer, packet_len_bits).ToWords32(flipped_buffer, packet_len_bits);
+            flipped_buffer[bit_index / 32] ^= 0x80000000 >> (bit_index % 32);
+            for (uint16_t j = 0; j < ModeSFrame::kMaxLenWords32; j++) {
+                ASSERT_EQ(check_buffer[j], flipped_buffer[j]) << "bit_index=" << bit_index;
+            }
+        }
+    }
+}
+
+TEST(ModeSFrame, Benchmark) {
+    const uint32_t kNumIterations = 1e6;
+    uint32_t packet_buffer[ModeSFrame::kMaxLenWords32] = {0x8D40621Du, 0x58C382D6u, 0x90C8AC28u, 0x63A70000u};
+    ModeSFrame frame = ModeSFrame(packet_buffer, 112);
+
+    // Fields read while ingesting an airborne position message: DF, ICAO, TC, altitude, odd flag, and CPR counts.
+    double words32_fields_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        packet_buffer[1] ^= i;
+        benchmark_sink = GetNBitWordFromBuffer<5, 0>(packet_buffer) + GetNBitWordFromBuffer<24, 8>(packet_buffer) +
+                         GetNBitWordFromBuffer<5, 32>(packet_buffer) + GetNBitWordFromBuffer<12, 40>(packet_buffer) +
+                         GetNBitWordFromBuffer<1, 53>(packet_buffer) + GetNBitWordFromBuffer<17, 54>(packet_buffer) +
+                         GetNBitWordFromBuffer<17, 71>(packet_buffer);
+    });
+    double frame_fields_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        frame.message ^= i;
+        benchmark_sink = frame.GetHeaderField<5, 0>() + frame.GetHeaderField<24, 8>() +
+                         frame.GetMessageField<5, 0>() + frame.GetMessageField<12, 8>() +
+                         frame.GetMessageField<1, 21>() + frame.GetMessageField<17, 22>() +
+                         frame.GetMessageField<17, 39>();
+    });
+    PrintBenchmarkComparison("Airborne position fields (32-bit words vs ModeSFrame)", words32_fields_ns,
+                             frame_fields_ns);
+
+    double words32_crc_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        packet_buffer[1] ^= i;
+        benchmark_sink = CalculateCRC24(packet_buffer, 112);
+    });
+    double frame_crc_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        frame.message ^= i;
+        benchmark_sink = frame.CalculateCRC24(112);
+    });
+    PrintBenchmarkComparison("CRC24 112-bit (32-bit words vs ModeSFrame)", words32_crc_ns, frame_crc_ns);
+}
+
+TEST(DecodedTransponderPacket, CorrectBitErrors) {
+    const uint32_t kValidPacketBuffer[DecodedTransponderPacket::kMaxPacketLenWords32] = {0x8D76CE88u, 0x204C9072u,
+                                                                                         0xCB48209Au, 0x504D0000u};
+    uint32_t packet_buffer[DecodedTransponderPacket::kMaxPacketLenWords32];
+    auto flip_bit = [&](uint16_t bit_index) { packet_buffer[bit_index / 32] ^= 0x80000000 >> (bit_index % 32); };
+
+    // Every single bit error outside of the DF field can be corrected.
+    for (uint16_t i = 0; i < DecodedTransponderPacket::kExtendedSquitterPacketLenBits; i++) {
+        memcpy(packet_buffer, kValidPacketBuffer, sizeof(packet_buffer));
+        flip_bit(i);
+        DecodedTransponderPacket packet = DecodedTransponderPacket(packet_buffer, 4);
+        EXPECT_FALSE(packet.IsValid());
+        EXPECT_EQ(packet.CorrectBitErrors(0), 0);  // Correction disabled.
+        if (i < DecodedTransponderPacket::kDFNUmBits) {
+            EXPECT_EQ(packet.CorrectBitErrors(2), 0);
+            EXPECT_FALSE(packet.IsValid());
+            continue;
+        }
+        EXPECT_EQ(packet.CorrectBitErrors(1), 1);
+        EXPECT_TRUE(packet.IsValid());
+        EXPECT_EQ(packet.GetICAOAddress(), 0x76CE88u);
+        packet.DumpPacketBuffer(packet_buffer);
+        EXPECT_EQ(memcmp(packet_buffer, kValidPacketBuffer, sizeof(packet_buffer)), 0);
+    }
+
+    // 2-bit errors are only corrected in 2-bit mode.
+    for (uint16_t i = DecodedTransponderPacket::kDFNUmBits;
+         i < DecodedTransponderPacket::kExtendedSquitterPacketLenBits; i++) {
+        for (uint16_t j = i + 1; j < DecodedTransponderPacket::kExtendedSquitterPacketLenBits; j++) {
+            memcpy(packet_buffer, kValidPacketBuffer, sizeof(packet_buffer));
+            flip_bit(i);
+            flip_bit(j);
+            DecodedTransponderPacket packet = DecodedTransponderPacket(packet_buffer, 4);
+            ASSERT_EQ(packet.CorrectBitErrors(1), 0);
+            ASSERT_EQ(packet.CorrectBitErrors(2), 2);
+            ASSERT_TRUE(packet.IsValid());
+            packet.DumpPacketBuffer(packet_buffer);
+            ASSERT_EQ(memcmp(packet_buffer, kValidPacketBuffer, sizeof(packet_buffer)), 0);
+        }
+    }
+
+    // Valid packets and packets that aren't DF17/18 are left alone.
+    DecodedTransponderPacket valid_packet = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D");
+    EXPECT_EQ(valid_packet.CorrectBitErrors(2), 0);
+    DecodedTransponderPacket comm_b_packet = DecodedTransponderPacket((char *)"A0001838CA3E51F0A8000047A6A6");
+    EXPECT_EQ(comm_b_packet.CorrectBitErrors(2), 0);
+}
+
 TEST(DecodedTransponderPacket, PacketFields) {
     uint32_t packet_buffer[DecodedTransponderPacket::kMaxPacketLenWords32];  // note: may contain garbage
     const uint16_t packet_buffer_used_len = 4;  // number of 32 bit words populated in the packet buffer
@@ -218,6 +437,56 @@ TEST(DecodedTransponderPacket, ConstructInvalidShortFrame) {
     EXPECT_FALSE(packet.IsValid());  // Automatically marking all 56-bit packets with unknown ICAO as invalid for now.
 }
 
+TEST(DecodedTransponderPacket, AllCallReply) {
+    // All-call reply to an interrogator with a non-zero interrogator code.
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"5D484FDEA248F5");
+    EXPECT_TRUE(tpacket.IsValid());
+    EXPECT_FALSE(tpacket.HasAddressParity());
+    AllCallReplyPacket packet = AllCallReplyPacket(tpacket);
+    EXPECT_EQ(packet.GetDownlinkFormat(), static_cast<uint16_t>(DecodedTransponderPacket::kDownlinkFormatAllCallReply));
+    EXPECT_EQ(packet.GetICAOAddress(), 0x484FDEu);
+    EXPECT_EQ(packet.GetCapability(), ADSBPacket::kCALevel2PlusTransponderAirborneCanSetCA7);
+    EXPECT_EQ(packet.GetInterrogatorCode(), 0x16u);
+
+    // Flipping a bit leaves a CRC residual that doesn't fit in the interrogator code.
+    tpacket = DecodedTransponderPacket((char *)"5D484FDFA248F5");
+    EXPECT_FALSE(tpacket.IsValid());
+    EXPECT_EQ(tpacket.GetDecodeError(), DecodedTransponderPacket::kDecodeErrorInvalidChecksum);
+}
+
+TEST(DecodedTransponderPacket, AddressParityLongFrame) {
+    // Build a Comm-B altitude reply (DF=20) with the ICAO address overlaid on its parity field.
+    char packet_str[29] = "A0001838CA3E51F0A80000000000";
+    uint32_t parity = DecodedTransponderPacket(packet_str).CalculateCRC24() ^ 0xA4F239;
+    snprintf(packet_str + 22, 7, "%06X", parity);
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket(packet_str);
+    EXPECT_TRUE(tpacket.HasAddressParity());
+    EXPECT_FALSE(tpacket.IsValid());  // Needs to be validated against known ICAO addresses.
+    EXPECT_EQ(tpacket.GetICAOAddress(), 0xA4F239u);
+    EXPECT_EQ(tpacket.GetDecodeError(), DecodedTransponderPacket::kDecodeErrorNone);
+}
+
+TEST(DecodedTransponderPacket, DecodeErrors) {
+    char debug_string[DecodedTransponderPacket::kDebugStrLen];
+
+    DecodedTransponderPacket valid_packet = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D");
+    EXPECT_EQ(valid_packet.GetDecodeError(), DecodedTransponderPacket::kDecodeErrorNone);
+    EXPECT_EQ(valid_packet.GetDebugString(debug_string), 0);
+    EXPECT_STREQ(debug_string, "");
+
+    DecodedTransponderPacket bad_crc_packet = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504E");
+    EXPECT_EQ(bad_crc_packet.GetDecodeError(), DecodedTransponderPacket::kDecodeErrorInvalidChecksum);
+    EXPECT_GT(bad_crc_packet.GetDebugString(debug_string), 0);
+    EXPECT_STREQ(debug_string, "Invalid checksum, expected 9a504e but calculated 9a504d.\r\n");
+
+    DecodedTransponderPacket bad_length_packet = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48");
+    EXPECT_EQ(bad_length_packet.GetDecodeError(), DecodedTransponderPacket::kDecodeErrorBitLengthMismatch);
+    EXPECT_GT(bad_length_packet.GetDebugString(debug_string), 0);
+
+    // Packets get queued in bulk for reporting, make sure they stay compact.
+    EXPECT_LE(sizeof(DecodedTransponderPacket), sizeof(RawTransponderPacket) + 16);
+}
+
 TEST(DecodedTransponderPacket, DumpPacketBufferBytes) {
     // Dumping packet buffer to a byte buffer (instead of a 32-bit word buffer) was added after the fact, and its
     // implementation needs to be checked for accuracy. Nominal packet.
@@ -237,4 +506,84 @@ TEST(DecodedTransponderPacket, DumpPacketBufferBytes) {
         EXPECT_EQ((packet_buffer_words[i] >> 8) & 0xFF, check_buffer_bytes[i * kBytesPerWord + 2]);
         EXPECT_EQ(packet_buffer_words[i] & 0xFF, check_buffer_bytes[i * kBytesPerWord + 3]);
     }
-}
\ No newline at end of file
+}
+TEST(CommBPacket, InferAndDecodeRegisters) {
+    // Test vectors from The 1090MHz Riddle (Junzi Sun), Chapter 18.
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"A000029C85E42F313000007047D3");
+    tpacket.ForceValid();
+    CommBPacket packet = CommBPacket(tpacket);
+    EXPECT_EQ(packet.InferBDS(), CommBPacket::kBDS40SelectedVerticalIntention);
+    int32_t altitude_ft;
+    EXPECT_TRUE(packet.GetMCPSelectedAltitudeFt(altitude_ft));
+    EXPECT_EQ(altitude_ft, 3008);
+    EXPECT_TRUE(packet.GetFMSSelectedAltitudeFt(altitude_ft));
+    EXPECT_EQ(altitude_ft, 3008);
+    uint16_t baro_pressure_setting_mb_e1;
+    EXPECT_TRUE(packet.GetBaroPressureSettingMbE1(baro_pressure_setting_mb_e1));
+    EXPECT_EQ(baro_pressure_setting_mb_e1, 10200);
+
+    tpacket = DecodedTransponderPacket((char *)"A000139381951536E024D4CCF6B5");
+    tpacket.ForceValid();
+    packet = CommBPacket(tpacket);
+    EXPECT_EQ(packet.InferBDS(), CommBPacket::kBDS50TrackAndTurnReport);
+    float angle_deg;
+    EXPECT_TRUE(packet.GetRollAngleDeg(angle_deg));
+    EXPECT_NEAR(angle_deg, 2.1f, 0.1f);
+    EXPECT_TRUE(packet.GetTrueTrackDeg(angle_deg));
+    EXPECT_NEAR(angle_deg, 114.258f, 0.01f);
+    uint16_t speed_kts;
+    EXPECT_TRUE(packet.GetGroundSpeedKts(speed_kts));
+    EXPECT_EQ(speed_kts, 438);
+    EXPECT_TRUE(packet.GetTrueAirspeedKts(speed_kts));
+    EXPECT_EQ(speed_kts, 424);
+
+    tpacket = DecodedTransponderPacket((char *)"A00004128F39F91A7E27C46ADC21");
+    tpacket.ForceValid();
+    packet = CommBPacket(tpacket);
+    EXPECT_EQ(packet.InferBDS(), CommBPacket::kBDS60HeadingAndSpeedReport);
+    EXPECT_TRUE(packet.GetMagneticHeadingDeg(angle_deg));
+    EXPECT_NEAR(angle_deg, 42.715f, 0.01f);
+    EXPECT_TRUE(packet.GetIndicatedAirspeedKts(speed_kts));
+    EXPECT_EQ(speed_kts, 252);
+    uint16_t mach_e3;
+    EXPECT_TRUE(packet.GetMachE3(mach_e3));
+    EXPECT_EQ(mach_e3, 420);
+    int16_t vertical_rate_fpm;
+    EXPECT_TRUE(packet.GetBaroVerticalRateFpm(vertical_rate_fpm));
+    EXPECT_EQ(vertical_rate_fpm, -1920);
+    EXPECT_TRUE(packet.GetInertialVerticalRateFpm(vertical_rate_fpm));
+    EXPECT_EQ(vertical_rate_fpm, -1920);
+}
+
+TEST(CommBPacket, RejectImplausibleRegisters) {
+    // An empty MB field would match every register.
+    EXPECT_EQ(CommBPacket::InferBDS(0x0), CommBPacket::kBDSUnknown);
+    // BDS 2,0 (Aircraft Identification) starts with its register number, which can't be a zeroed field.
+    EXPECT_EQ(CommBPacket::InferBDS(0x2010C3D34C7820), CommBPacket::kBDSUnknown);
+
+    // BDS 4,0 vector from above, with a reserved bit set.
+    uint64_t mb = 0x85E42F31300000;
+    EXPECT_EQ(CommBPacket::InferBDS(mb), CommBPacket::kBDS40SelectedVerticalIntention);
+    EXPECT_EQ(CommBPacket::InferBDS(mb | (0b1 << (56 - 44))), CommBPacket::kBDSUnknown);
+    // Clearing the baro pressure setting status bit leaves a value behind in an unavailable field.
+    EXPECT_EQ(CommBPacket::InferBDS(mb & ~(uint64_t(0b1) << (56 - 27))), CommBPacket::kBDSUnknown);
+
+    // BDS 5,0 vector from above, with true airspeed raised so that it's 300kts away from ground speed.
+    mb = 0x81951536E024D4;
+    EXPECT_EQ(CommBPacket::InferBDS(mb), CommBPacket::kBDS50TrackAndTurnReport);
+    EXPECT_EQ(CommBPacket::InferBDS((mb & ~uint64_t(0x3FF)) | ((438 - 300) / 2)), CommBPacket::kBDSUnknown);
+
+    // BDS 6,0 vector from above, with the Mach number set to 2.0.
+    mb = 0x8F39F91A7E27C4;
+    EXPECT_EQ(CommBPacket::InferBDS(mb), CommBPacket::kBDS60HeadingAndSpeedReport);
+    EXPECT_EQ(CommBPacket::InferBDS((mb & ~(uint64_t(0x3FF) << 22)) | (uint64_t(500) << 22)), CommBPacket::kBDSUnknown);
+}
+
+TEST(CommBPacket, InferBDSBenchmark) {
+    const uint64_t kMBs[] = {0x85E42F31300000, 0x81951536E024D4, 0x8F39F91A7E27C4, 0x2010C3D34C7820};
+    const uint16_t kNumMBs = sizeof(kMBs) / sizeof(kMBs[0]);
+    const uint32_t kNumIterations = 1e6;
+    double infer_ns = BenchmarkNsPerCall(
+        kNumIterations, [&](uint32_t i) { benchmark_sink = CommBPacket::InferBDS(kMBs[i % kNumMBs]); });
+    printf("[ BENCHMARK] CommBPacket::InferBDS: %.1f ns per MB field\r\n", infer_ns);
+}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
 #include "aircraft_dictionary.hh"
+#include "benchmark.hh"
 #include "decode_utils.hh"  // for location calculation utility functions
 #include "gtest/gtest.h"
 #include "hal_god_powers.hh"  // for changing timestamp
+#include "packet_test_utils.hh"
 #include "transponder_packet.hh"
 
 constexpr float kLatDegCloseEnough = 0.001f;
@@ -31,7 +37,9 @@ TEST(AircraftDictionary, BasicInsertRemove) {
 }
 
 TEST(AircraftDictionary, InsertThenRemoveTooMany) {
-    AircraftDictionary dictionary = AircraftDictionary();
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.eviction_policy = AircraftDictionary::kEvictionPolicyRejectNew;
+    AircraftDictionary dictionary = AircraftDictionary(config);
     EXPECT_EQ(dictionary.GetNumAircraft(), 0);
 
     Aircraft test_aircraft = Aircraft(0);
@@ -53,6 +61,8 @@ TEST(AircraftDictionary, InsertThenRemoveTooMany) {
     test_aircraft.icao_address = 0xBEEB;
     EXPECT_FALSE(dictionary.InsertAircraft(test_aircraft));
     EXPECT_FALSE(dictionary.GetAircraftPtr(test_aircraft.icao_address));
+    EXPECT_EQ(dictionary.stats_num_aircraft_rejected, 2u);
+    EXPECT_EQ(dictionary.stats_num_aircraft_evicted, 0u);
 
     // Remove all aircraft.
     for (uint16_t i = 0; i < AircraftDictionary::kMaxNumAircraft; i++) {
@@ -66,6 +76,102 @@ TEST(AircraftDictionary, InsertThenRemoveTooMany) {
     EXPECT_FALSE(dictionary.RemoveAircraft(0));
 }
 
+// Fills a dictionary with aircraft 1 to kMaxNumAircraft, heard from 1ms apart in that order.
+void FillDictionary(AircraftDictionary &dictionary) {
+    for (uint16_t i = 1; i <= AircraftDictionary::kMaxNumAircraft; i++) {
+        inc_time_since_boot_ms(1);
+        ASSERT_TRUE(dictionary.GetAircraftPtr(i));
+    }
+}
+
+TEST(AircraftDictionary, EvictStalestWhenFull) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+    FillDictionary(dictionary);
+    // Aircraft 1 and 2 have had positions, so aircraft 3 is evicted first even though it's not the stalest. Aircraft 2
+    // is still protected after a failed position decode clears its valid flag.
+    dictionary.GetAircraftPtr(1)->last_position_timestamp_ms = get_time_since_boot_ms();
+    dictionary.GetAircraftPtr(2)->last_position_timestamp_ms = get_time_since_boot_ms();
+    dictionary.GetAircraftPtr(2)->WriteBitFlag(Aircraft::kBitFlagPositionValid, false);
+
+    inc_time_since_boot_ms(1);
+    EXPECT_TRUE(dictionary.GetAircraftPtr(0xBEEB));
+    EXPECT_FALSE(dictionary.ContainsAircraft(3));
+    EXPECT_TRUE(dictionary.ContainsAircraft(1));
+    EXPECT_EQ(dictionary.GetNumAircraft(), static_cast<uint16_t>(AircraftDictionary::kMaxNumAircraft));
+
+    // Aircraft with positions are evicted once there are no aircraft without positions near the stale end.
+    for (uint16_t i = 4; i < 4 + 16; i++) {
+        dictionary.GetAircraftPtr(i)->last_position_timestamp_ms = get_time_since_boot_ms();
+    }
+    Aircraft aircraft = Aircraft(0xBEEC);
+    aircraft.last_message_timestamp_ms = get_time_since_boot_ms();
+    EXPECT_TRUE(dictionary.InsertAircraft(aircraft));
+    EXPECT_FALSE(dictionary.ContainsAircraft(1));
+    EXPECT_TRUE(dictionary.ContainsAircraft(2));
+    EXPECT_EQ(dictionary.stats_num_aircraft_evicted, 2u);
+    EXPECT_EQ(dictionary.stats_num_aircraft_rejected, 0u);
+
+    // Evicted aircraft are also gone from the expiry list, so pruning still works.
+    inc_time_since_boot_ms(60000);
+    EXPECT_EQ(dictionary.Update(get_time_since_boot_ms()), AircraftDictionary::kMaxNumAircraft - 2);
+    EXPECT_TRUE(dictionary.ContainsAircraft(0xBEEB));
+    EXPECT_TRUE(dictionary.ContainsAircraft(0xBEEC));
+
+    dictionary.Init();
+    EXPECT_EQ(dictionary.stats_num_aircraft_evicted, 0u);
+}
+
+TEST(AircraftDictionary, EvictLowestFrameRateWhenFull) {
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.eviction_policy = AircraftDictionary::kEvictionPolicyEvictLowestFrameRate;
+    AircraftDictionary dictionary = AircraftDictionary(config);
+    set_time_since_boot_ms(1000);
+    FillDictionary(dictionary);
+    for (Aircraft &aircraft : dictionary.dict) {
+        aircraft.last_position_timestamp_ms = get_time_since_boot_ms();
+        aircraft.stats_frames_received_in_last_interval = 10;
+    }
+    dictionary.GetAircraftPtr(100)->stats_frames_received_in_last_interval = 2;
+    dictionary.GetAircraftPtr(200)->stats_frames_received_in_last_interval = 2;
+    dictionary.GetAircraftPtr(300)->stats_frames_received_in_last_interval = 5;
+    dictionary.GetAircraftPtr(300)->last_position_timestamp_ms = 0;
+    // Aircraft 100 had a position before a failed decode, so it isn't treated as an aircraft without a position.
+    dictionary.GetAircraftPtr(100)->WriteBitFlag(Aircraft::kBitFlagPositionValid, false);
+
+    // Aircraft without a position are evicted first.
+    inc_time_since_boot_ms(1);
+    EXPECT_TRUE(dictionary.GetAircraftPtr(0xBEEB));
+    EXPECT_FALSE(dictionary.ContainsAircraft(300));
+    // Ties are broken by evicting the stalest aircraft.
+    dictionary.GetAircraftPtr(0xBEEB)->last_position_timestamp_ms = get_time_since_boot_ms();
+    dictionary.GetAircraftPtr(0xBEEB)->stats_frames_received_in_last_interval = 2;
+    EXPECT_TRUE(dictionary.GetAircraftPtr(0xBEEC));
+    EXPECT_TRUE(dictionary.ContainsAircraft(0xBEEB));
+    EXPECT_FALSE(dictionary.ContainsAircraft(100));
+    EXPECT_TRUE(dictionary.ContainsAircraft(200));
+    EXPECT_EQ(dictionary.stats_num_aircraft_evicted, 2u);
+}
+
+TEST(AircraftDictionary, PhantomBurstDoesNotLockOutTraffic) {
+    // A burst of packets with corrupted ICAO addresses fills the dictionary with aircraft that are only heard from
+    // once. A real aircraft that shows up afterwards should still get in, and should survive the rest of the burst.
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+    Aircraft *real_aircraft = dictionary.GetAircraftPtr(0xABCDEF);
+    ASSERT_TRUE(real_aircraft);
+    real_aircraft->last_position_timestamp_ms = get_time_since_boot_ms();
+    for (uint32_t i = 1; i <= 2 * AircraftDictionary::kMaxNumAircraft; i++) {
+        inc_time_since_boot_ms(1);
+        EXPECT_TRUE(dictionary.GetAircraftPtr(i));
+    }
+    EXPECT_TRUE(dictionary.ContainsAircraft(0xABCDEF));
+    inc_time_since_boot_ms(1);
+    EXPECT_TRUE(dictionary.GetAircraftPtr(0x123456));
+    EXPECT_EQ(dictionary.stats_num_aircraft_rejected, 0u);
+    EXPECT_EQ(dictionary.stats_num_aircraft_evicted, static_cast<uint32_t>(AircraftDictionary::kMaxNumAircraft + 2));
+}
+
 TEST(AircraftDictionary, UseAircraftPtr) {
     AircraftDictionary dictionary = AircraftDictionary();
     Aircraft *aircraft = dictionary.GetAircraftPtr(12345);
@@ -79,6 +185,157 @@ TEST(AircraftDictionary, UseAircraftPtr) {
     ASSERT_EQ(aircraft_out.airframe_type, Aircraft::kAirframeTypeHeavy);
 }
 
+TEST(AircraftDictionary, PruneStaleAircraft) {
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.aircraft_prune_interval_ms = 10000;
+    AircraftDictionary dictionary = AircraftDictionary(config);
+
+    set_time_since_boot_ms(100000);
+    ASSERT_TRUE(dictionary.GetAircraftPtr(1));  // Last message at 100000ms.
+    inc_time_since_boot_ms(2000);
+    ASSERT_TRUE(dictionary.GetAircraftPtr(2));  // Last message at 102000ms.
+
+    // Inserted aircraft keep their timestamps, even if they are out of order.
+    Aircraft aircraft = Aircraft(3);
+    aircraft.last_message_timestamp_ms = 101000;
+    ASSERT_TRUE(dictionary.InsertAircraft(aircraft));
+    aircraft = Aircraft(4);
+    aircraft.last_message_timestamp_ms = 99000;
+    ASSERT_TRUE(dictionary.InsertAircraft(aircraft));
+
+    EXPECT_EQ(dictionary.Update(109000), 0);
+    EXPECT_EQ(dictionary.GetNumAircraft(), 4);
+    EXPECT_EQ(dictionary.Update(110500), 2);
+    EXPECT_FALSE(dictionary.ContainsAircraft(1));
+    EXPECT_FALSE(dictionary.ContainsAircraft(4));
+    EXPECT_EQ(dictionary.Update(111500), 1);
+    EXPECT_FALSE(dictionary.ContainsAircraft(3));
+    EXPECT_TRUE(dictionary.ContainsAircraft(2));
+
+    // Hearing from an aircraft again keeps it from getting pruned.
+    set_time_since_boot_ms(110000);
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x7C1B28));
+    set_time_since_boot_ms(111000);
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"200006A2DE8B1C");
+    tpacket.ForceValid();
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));  // Mode C, ICAO address 0x7C1B28.
+    // Aircraft heard from after the pruning timestamp aren't pruned.
+    EXPECT_EQ(dictionary.Update(100000), 0);
+    EXPECT_TRUE(dictionary.ContainsAircraft(0x7C1B28));
+    ASSERT_TRUE(dictionary.RemoveAircraft(2));
+    EXPECT_EQ(dictionary.Update(121000), 0);
+    EXPECT_EQ(dictionary.GetNumAircraft(), 1);
+    EXPECT_EQ(dictionary.Update(121001), 1);
+    EXPECT_EQ(dictionary.GetNumAircraft(), 0);
+}
+
+TEST(AircraftDictionary, PruneSimulatedTraffic) {
+    // Simulate a few hours of traffic, with aircraft flying in and out of range and dropping packets while in range.
+    // Aircraft send Mode C replies with random payloads, from random allocated ICAO addresses.
+    struct SimAircraft {
+        DecodedTransponderPacket packet;
+        uint32_t icao_address;
+        uint32_t leave_timestamp_ms;
+        uint32_t last_message_timestamp_ms;
+    };
+    const uint32_t kStepMs = 1000;
+    const uint32_t kSimDurationMs = 3 * 60 * 60 * 1000;  // 3 hours.
+    const uint32_t kMinVisibleMs = 2 * 60 * 1000;
+    const uint32_t kMaxVisibleMs = 30 * 60 * 1000;
+    const float kArrivalProbabilityPerStep = 0.4f;  // ~250 aircraft in range at a time.
+    const float kPacketProbabilityPerStep = 0.7f;
+
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.candidate_min_num_sightings = 1;  // Every simulated aircraft is real, no need to wait for a confirmation.
+    AircraftDictionary dictionary = AircraftDictionary(config);
+    const uint32_t prune_interval_ms = AircraftDictionary::AircraftDictionaryConfig_t().aircraft_prune_interval_ms;
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> visible_ms(kMinVisibleMs, kMaxVisibleMs);
+    std::vector<SimAircraft> sim_aircraft;
+    std::vector<SimAircraft> departed_aircraft;
+    uint32_t num_pruned = 0;
+    uint32_t max_num_aircraft = 0;
+
+    set_time_since_boot_ms(0);
+    for (uint32_t timestamp_ms = kStepMs; timestamp_ms <= kSimDurationMs; timestamp_ms += kStepMs) {
+        set_time_since_boot_ms(timestamp_ms);
+        if (chance(rng) < kArrivalProbabilityPerStep) {
+            char data_str[9];
+            snprintf(data_str, sizeof(data_str), "20%06X", rng() & 0xFFFFFF);
+            uint32_t icao_address;
+            do {
+                icao_address = rng() & 0xFFFFFF;
+            } while (!IsAllocatedICAOAddress(icao_address));
+            DecodedTransponderPacket tpacket = MakeAddressParityPacket(data_str, icao_address);
+            tpacket.ForceValid();
+            sim_aircraft.push_back({.packet = tpacket,
+                                    .icao_address = tpacket.GetICAOAddress(),
+                                    .leave_timestamp_ms = timestamp_ms + visible_ms(rng),
+                                    .last_message_timestamp_ms = 0});
+        }
+        for (SimAircraft &aircraft : sim_aircraft) {
+            if (chance(rng) < kPacketProbabilityPerStep) {
+                ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(aircraft.packet));
+                aircraft.last_message_timestamp_ms = timestamp_ms;
+            }
+        }
+        // Aircraft that leave stop sending packets, but are remembered until they should have been pruned.
+        for (auto it = sim_aircraft.begin(); it != sim_aircraft.end();) {
+            if (timestamp_ms >= it->leave_timestamp_ms) {
+                departed_aircraft.push_back(*it);
+                it = sim_aircraft.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        num_pruned += dictionary.Update(get_time_since_boot_ms());
+        max_num_aircraft = std::max(max_num_aircraft, static_cast<uint32_t>(dictionary.GetNumAircraft()));
+
+        // Every aircraft left in the dictionary has been heard from within the prune interval.
+        for (Aircraft &aircraft : dictionary.dict) {
+            ASSERT_LE(timestamp_ms - aircraft.last_message_timestamp_ms, prune_interval_ms);
+        }
+        // Every aircraft that was heard from within the prune interval is still in the dictionary.
+        for (SimAircraft &aircraft : sim_aircraft) {
+            if (aircraft.last_message_timestamp_ms != 0) {
+                ASSERT_TRUE(dictionary.ContainsAircraft(aircraft.icao_address));
+            }
+        }
+        for (auto it = departed_aircraft.begin(); it != departed_aircraft.end();) {
+            if (timestamp_ms - it->last_message_timestamp_ms > prune_interval_ms) {
+                ASSERT_FALSE(dictionary.ContainsAircraft(it->icao_address));
+                it = departed_aircraft.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    EXPECT_GT(num_pruned, 3000u);
+    EXPECT_GT(max_num_aircraft, 150u);
+    EXPECT_LT(max_num_aircraft, static_cast<uint32_t>(AircraftDictionary::kMaxNumAircraft));
+
+    // Pruning cost shouldn't grow with the number of aircraft in the dictionary.
+    const uint32_t kNumIterations = 100000;
+    AircraftDictionary small_dictionary = AircraftDictionary();
+    AircraftDictionary full_dictionary = AircraftDictionary();
+    for (uint16_t i = 0; i < AircraftDictionary::kMaxNumAircraft; i++) {
+        if (i < 10) {
+            ASSERT_TRUE(small_dictionary.GetAircraftPtr(i + 1));
+        }
+        ASSERT_TRUE(full_dictionary.GetAircraftPtr(i + 1));
+    }
+    uint32_t timestamp_ms = get_time_since_boot_ms();
+    double small_ns = BenchmarkNsPerCall(kNumIterations,
+                                         [&](uint32_t i) { benchmark_sink = small_dictionary.Update(timestamp_ms); });
+    double full_ns =
+        BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) { benchmark_sink = full_dictionary.Update(timestamp_ms); });
+    PrintBenchmarkComparison("AircraftDictionary::Update (full dictionary vs 10 aircraft)", full_ns, small_ns);
+    EXPECT_EQ(full_dictionary.GetNumAircraft(), static_cast<uint16_t>(AircraftDictionary::kMaxNumAircraft));
+    EXPECT_LT(full_ns, 10 * small_ns + 50);
+}
+
 TEST(AircraftDictionary, AccessFakeAircraft) {
     AircraftDictionary dictionary = AircraftDictionary();
     EXPECT_EQ(dictionary.GetNumAircraft(), 0);
@@ -93,9 +350,11 @@ TEST(AircraftDictionary, ApplyAircraftIDMessage) {
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
     EXPECT_EQ(dictionary.GetNumAircraft(), 1);
     Aircraft aircraft;
+    AircraftDetails details;
     EXPECT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
     EXPECT_EQ(aircraft.icao_address, 0x76CE88u);
-    EXPECT_EQ(aircraft.transponder_capability, 5);
+    EXPECT_EQ(details.transponder_capability, 5);
     EXPECT_EQ(aircraft.airframe_type, Aircraft::kAirframeTypeNoCategoryInfo);
     EXPECT_STREQ(aircraft.callsign, "SIA224");
 
@@ -103,8 +362,9 @@ TEST(AircraftDictionary, ApplyAircraftIDMessage) {
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
     EXPECT_EQ(dictionary.GetNumAircraft(), 2);
     EXPECT_TRUE(dictionary.GetAircraft(0x7C7181, aircraft));
+    EXPECT_TRUE(dictionary.GetAircraftDetails(0x7C7181, details));
     EXPECT_EQ(aircraft.icao_address, 0x7C7181u);
-    EXPECT_EQ(aircraft.transponder_capability, 5);
+    EXPECT_EQ(details.transponder_capability, 5);
     EXPECT_EQ(aircraft.airframe_type, Aircraft::kAirframeTypeLight);
     EXPECT_STREQ(aircraft.callsign, "WPF");
 
@@ -112,8 +372,9 @@ TEST(AircraftDictionary, ApplyAircraftIDMessage) {
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
     EXPECT_EQ(dictionary.GetNumAircraft(), 3);
     EXPECT_TRUE(dictionary.GetAircraft(0x7C7745, aircraft));
+    EXPECT_TRUE(dictionary.GetAircraftDetails(0x7C7745, details));
     EXPECT_EQ(aircraft.icao_address, 0x7C7745u);
-    EXPECT_EQ(aircraft.transponder_capability, 5);
+    EXPECT_EQ(details.transponder_capability, 5);
     EXPECT_EQ(aircraft.airframe_type, Aircraft::kAirframeTypeMedium1);
     EXPECT_STREQ(aircraft.callsign, "XUF");
 
@@ -121,8 +382,9 @@ TEST(AircraftDictionary, ApplyAircraftIDMessage) {
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
     EXPECT_EQ(dictionary.GetNumAircraft(), 4);
     EXPECT_TRUE(dictionary.GetAircraft(0x7C80AD, aircraft));
+    EXPECT_TRUE(dictionary.GetAircraftDetails(0x7C80AD, details));
     EXPECT_EQ(aircraft.icao_address, 0x7C80ADu);
-    EXPECT_EQ(aircraft.transponder_capability, 5);
+    EXPECT_EQ(details.transponder_capability, 5);
     EXPECT_EQ(aircraft.airframe_type, Aircraft::kAirframeTypeMedium2);
     EXPECT_STREQ(aircraft.callsign, "VOZ1851");
 
@@ -130,12 +392,31 @@ TEST(AircraftDictionary, ApplyAircraftIDMessage) {
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
     EXPECT_EQ(dictionary.GetNumAircraft(), 5);
     EXPECT_TRUE(dictionary.GetAircraft(0x7C1465, aircraft));
+    EXPECT_TRUE(dictionary.GetAircraftDetails(0x7C1465, details));
     EXPECT_EQ(aircraft.icao_address, 0x7C1465u);
-    EXPECT_EQ(aircraft.transponder_capability, 5);
+    EXPECT_EQ(details.transponder_capability, 5);
     EXPECT_EQ(aircraft.airframe_type, Aircraft::kAirframeTypeHeavy);
     EXPECT_STREQ(aircraft.callsign, "QFA475");
 }
 
+TEST(AircraftDictionary, AircraftDetails) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    AircraftDetails details;
+    EXPECT_FALSE(dictionary.GetAircraftDetails(0x76CE88, details));
+
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
+    Aircraft *aircraft = dictionary.GetAircraftPtr(0x76CE88);
+    ASSERT_NE(aircraft, nullptr);
+    EXPECT_EQ(dictionary.GetAircraftDetails(*aircraft).transponder_capability, 5);
+
+    // Details are reset when the aircraft is replaced.
+    EXPECT_TRUE(dictionary.InsertAircraft(Aircraft(0x76CE88)));
+    EXPECT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
+    EXPECT_EQ(details.transponder_capability, 0);
+    EXPECT_EQ(details.gnss_antenna_offset_right_of_roll_axis_m, INT8_MAX);
+}
+
 TEST(AircraftDictionary, IngestInvalidAircrfaftIDMessage) {
     AircraftDictionary dictionary = AircraftDictionary();
     DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"7D76CE88204C9072CB48209A504D");
@@ -153,68 +434,74 @@ TEST(decode_utils, CalcNLCPRFromLat) {
 
 TEST(Aircraft, SetCPRLatLon) {
     Aircraft aircraft;
+    CPRPacketPair cpr_packets;
     EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
 
     // Send n_lat_cpr out of bounds (bigger than 2^17 bits max value).
-    EXPECT_FALSE(aircraft.SetCPRLatLon(0xFFFFFF, 53663, true));
-    EXPECT_FALSE(aircraft.SetCPRLatLon(0xFFFFFF, 53663, false));
+    EXPECT_FALSE(cpr_packets.SetCPRLatLon(0xFFFFFF, 53663, true));
+    EXPECT_FALSE(cpr_packets.SetCPRLatLon(0xFFFFFF, 53663, false));
     // Send n_lon_cpr out of bounds (bigger than 2^17 bits max value).
-    EXPECT_FALSE(aircraft.SetCPRLatLon(52455, 0xFFFFFF, false));
-    EXPECT_FALSE(aircraft.SetCPRLatLon(52455, 0xFFFFFF, true));
+    EXPECT_FALSE(cpr_packets.SetCPRLatLon(52455, 0xFFFFFF, false));
+    EXPECT_FALSE(cpr_packets.SetCPRLatLon(52455, 0xFFFFFF, true));
 
     // Send two even packets at startup, no odd packets.
     aircraft = Aircraft();  // clear everything
+    cpr_packets = CPRPacketPair();
     EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(578, 13425, false));
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(578, 13425, false));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(578, 4651, false));
-    EXPECT_FALSE(aircraft.DecodePosition());
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(578, 4651, false));
+    EXPECT_FALSE(aircraft.DecodePosition(cpr_packets));
     EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
 
     // Send two odd packets at startup, no even packets.
     aircraft = Aircraft();  // clear everything
+    cpr_packets = CPRPacketPair();
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(236, 13425, true));
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(236, 13425, true));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(236, 857, true));
-    EXPECT_FALSE(aircraft.DecodePosition());
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(236, 857, true));
+    EXPECT_FALSE(aircraft.DecodePosition(cpr_packets));
     EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
 
     // Send one odd packet and one even packet at startup.
     aircraft = Aircraft();  // clear everything
+    cpr_packets = CPRPacketPair();
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(74158, 50194, true));
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(74158, 50194, true));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(93000, 51372, false));
-    EXPECT_TRUE(aircraft.DecodePosition());
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(93000, 51372, false));
+    EXPECT_TRUE(aircraft.DecodePosition(cpr_packets));
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
-    EXPECT_NEAR(aircraft.latitude_deg, 52.25720f, 1e-4);  // even latitude
-    EXPECT_NEAR(aircraft.longitude_deg, 3.91937f, 1e-4);  // longitude calculated from even latitude
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 52.25720f, 1e-4);  // even latitude
+    EXPECT_NEAR(aircraft.longitude_deg_e7 / 1e7, 3.91937f, 1e-4);  // longitude calculated from even latitude
 
     // Send one even packet and one odd packet at startup.
     aircraft = Aircraft();  // clear everything
+    cpr_packets = CPRPacketPair();
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(93000, 51372, false));
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(93000, 51372, false));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(74158, 50194, true));
-    EXPECT_TRUE(aircraft.DecodePosition());
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(74158, 50194, true));
+    EXPECT_TRUE(aircraft.DecodePosition(cpr_packets));
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
-    EXPECT_NEAR(aircraft.latitude_deg, 52.26578f, 1e-4);  // odd latitude
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 52.26578f, 1e-4);  // odd latitude
     // don't have a test value available for the longitude calculated from odd latitude
 
     // Straddle two position packets between different latitude
     aircraft = Aircraft();  // clear everything
-    EXPECT_TRUE(aircraft.SetCPRLatLon(93006, 50194, true));
+    cpr_packets = CPRPacketPair();
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(93006, 50194, true));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.SetCPRLatLon(93000, 51372, false));
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(93000, 51372, false));
     inc_time_since_boot_ms();
-    EXPECT_TRUE(aircraft.DecodePosition());
+    EXPECT_TRUE(aircraft.DecodePosition(cpr_packets));
     inc_time_since_boot_ms();
     // Position established, now send the curveball.
-    EXPECT_TRUE(aircraft.SetCPRLatLon(93000 - 5000, 50194, true));
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(93000 - 5000, 50194, true));
     inc_time_since_boot_ms();
-    EXPECT_FALSE(aircraft.DecodePosition());
+    EXPECT_FALSE(aircraft.DecodePosition(cpr_packets));
 
     // EXPECT_NEAR(aircraft.latitude, 52.25720f, 1e-4);
     // EXPECT_NEAR(aircraft.longitude, 3.91937f, 1e-4);
@@ -222,9 +509,9 @@ TEST(Aircraft, SetCPRLatLon) {
     // Another test message.
     // aircraft = Aircraft(); // clear everything
     // inc_time_since_boot_ms();
-    // EXPECT_TRUE(aircraft.SetCPRLatLon(74158, 50194, true));
+    // EXPECT_TRUE(cpr_packets.SetCPRLatLon(74158, 50194, true));
     // inc_time_since_boot_ms();
-    // EXPECT_TRUE(aircraft.SetCPRLatLon(93000, 51372, false));
+    // EXPECT_TRUE(cpr_packets.SetCPRLatLon(93000, 51372, false));
     // EXPECT_TRUE(aircraft.position_valid);
     // EXPECT_FLOAT_EQ(aircraft.latitude, 52.25720f);
     // EXPECT_FLOAT_EQ(aircraft.longitude, 3.91937f);
@@ -234,6 +521,229 @@ TEST(Aircraft, SetCPRLatLon) {
     /** Test Longitude **/
 }
 
+TEST(Aircraft, DecodePositionLocal) {
+    Aircraft aircraft;
+    CPRPacketPair cpr_packets;
+    // Local decode needs at least one packet.
+    EXPECT_FALSE(aircraft.DecodePositionLocal(cpr_packets, 520000000, 40000000));
+
+    // Even packet from the SetCPRLatLon test, decoded against a nearby reference. Should match the global decode.
+    inc_time_since_boot_ms();
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(93000, 51372, false));
+    EXPECT_TRUE(aircraft.DecodePositionLocal(cpr_packets, 520000000, 40000000));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 52.25720f, 1e-4);
+    EXPECT_NEAR(aircraft.longitude_deg_e7 / 1e7, 3.91937f, 1e-4);
+    EXPECT_TRUE(aircraft.HasRecentPosition());
+
+    // Any reference within half a zone of the aircraft decodes to the same position.
+    EXPECT_TRUE(aircraft.DecodePositionLocal(cpr_packets, 500000000, 10000000));
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 52.25720f, 1e-4);
+    EXPECT_NEAR(aircraft.longitude_deg_e7 / 1e7, 3.91937f, 1e-4);
+
+    // Odd packet decodes against the previous position without needing a new even packet.
+    inc_time_since_boot_ms();
+    EXPECT_TRUE(cpr_packets.SetCPRLatLon(74158, 50194, true));
+    EXPECT_TRUE(aircraft.DecodePositionLocal(cpr_packets, aircraft.latitude_deg_e7, aircraft.longitude_deg_e7));
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 52.26578f, 1e-4);
+
+    // Position becomes too old to use as a reference.
+    inc_time_since_boot_ms(Aircraft::kCPRLocalDecodeMaxAgeMs + 1);
+    EXPECT_FALSE(aircraft.HasRecentPosition());
+}
+
+/**
+ * Floating point reference for global CPR decoding (Equations 5.5 - 5.15). Instantiated with float to benchmark the
+ * previous floating point decode path, and with double as ground truth for the integer decoder.
+ */
+template <typename T>
+bool DecodeCPRGlobalReference(uint32_t n_lat_even, uint32_t n_lon_even, uint32_t n_lat_odd, uint32_t n_lon_odd,
+                              bool odd_last, T &lat_deg, T &lon_deg) {
+    const T kNumCounts = kCPRNumCounts;
+    T lat_cpr_even = n_lat_even / kNumCounts, lon_cpr_even = n_lon_even / kNumCounts;
+    T lat_cpr_odd = n_lat_odd / kNumCounts, lon_cpr_odd = n_lon_odd / kNumCounts;
+    int32_t lat_zone_index = std::floor(59 * lat_cpr_even - 60 * lat_cpr_odd + T(0.5));
+    T lat_even = T(360) / 60 * (CPRMod(lat_zone_index, 60) + lat_cpr_even);
+    T lat_odd = T(360) / 59 * (CPRMod(lat_zone_index, 59) + lat_cpr_odd);
+    lat_even = lat_even >= 270 ? lat_even - 360 : lat_even;
+    lat_odd = lat_odd >= 270 ? lat_odd - 360 : lat_odd;
+    uint16_t nl_cpr = CalcNLCPRFromLat(odd_last ? lat_odd : lat_even);
+    if (nl_cpr != CalcNLCPRFromLat(odd_last ? lat_even : lat_odd)) {
+        return false;
+    }
+    int32_t lon_zone_index = std::floor(lon_cpr_even * (nl_cpr - 1) - lon_cpr_odd * nl_cpr + T(0.5));
+    int32_t num_lon_zones = odd_last ? std::max(nl_cpr - 1, 1) : std::max<int32_t>(nl_cpr, 1);
+    lat_deg = odd_last ? lat_odd : lat_even;
+    T lon_cpr = odd_last ? lon_cpr_odd : lon_cpr_even;
+    lon_deg = T(360) / num_lon_zones * (CPRMod(lon_zone_index, num_lon_zones) + lon_cpr);
+    lon_deg = lon_deg >= 180 ? lon_deg - 360 : lon_deg;
+    return true;
+}
+
+/**
+ * Encodes a position into CPR counts, in double precision.
+ */
+void EncodeCPR(double lat_deg, double lon_deg, bool odd, uint32_t &n_lat, uint32_t &n_lon) {
+    double d_lat = 360.0 / (odd ? kCPRNumLatZonesOdd : kCPRNumLatZonesEven);
+    double lat_zone_fraction = lat_deg / d_lat - floor(lat_deg / d_lat);
+    double yz = floor(kCPRNumCounts * lat_zone_fraction + 0.5);
+    double r_lat = d_lat * (yz / kCPRNumCounts + floor(lat_deg / d_lat));
+    double d_lon = 360.0 / std::max(CalcNLCPRFromLat(r_lat) - (odd ? 1 : 0), 1);
+    double lon_zone_fraction = lon_deg / d_lon - floor(lon_deg / d_lon);
+    double xz = floor(kCPRNumCounts * lon_zone_fraction + 0.5);
+    n_lat = static_cast<uint32_t>(yz) % kCPRNumCounts;
+    n_lon = static_cast<uint32_t>(xz) % kCPRNumCounts;
+}
+
+struct CPRPair {
+    uint32_t n_lat_even, n_lon_even, n_lat_odd, n_lon_odd;
+};
+
+std::vector<CPRPair> GenerateRandomCPRPairs(uint16_t num_pairs) {
+    std::mt19937 rng(1090);
+    std::uniform_real_distribution<double> lat_dist(-85.0, 85.0);
+    std::uniform_real_distribution<double> lon_dist(-180.0, 180.0);
+    std::vector<CPRPair> pairs(num_pairs);
+    for (CPRPair &pair : pairs) {
+        double lat_deg = lat_dist(rng), lon_deg = lon_dist(rng);
+        EncodeCPR(lat_deg, lon_deg, false, pair.n_lat_even, pair.n_lon_even);
+        EncodeCPR(lat_deg, lon_deg, true, pair.n_lat_odd, pair.n_lon_odd);
+    }
+    return pairs;
+}
+
+TEST(Aircraft, DecodePositionMatchesDoublePrecision) {
+    std::vector<CPRPair> pairs = GenerateRandomCPRPairs(10000);
+    uint16_t num_decoded = 0;
+    double max_int_error_deg = 0.0, max_float_error_deg = 0.0;
+    for (const CPRPair &pair : pairs) {
+        double lat_deg, lon_deg;
+        if (!DecodeCPRGlobalReference<double>(pair.n_lat_even, pair.n_lon_even, pair.n_lat_odd, pair.n_lon_odd, true,
+                                              lat_deg, lon_deg)) {
+            continue;  // Pair straddles an NL transition.
+        }
+        Aircraft aircraft;
+        CPRPacketPair cpr_packets;
+        inc_time_since_boot_ms();
+        ASSERT_TRUE(cpr_packets.SetCPRLatLon(pair.n_lat_even, pair.n_lon_even, false));
+        inc_time_since_boot_ms();
+        ASSERT_TRUE(cpr_packets.SetCPRLatLon(pair.n_lat_odd, pair.n_lon_odd, true));
+        if (!aircraft.DecodePosition(cpr_packets)) {
+            continue;
+        }
+        num_decoded++;
+        // Integer decode is within rounding distance of a 1e-7 degree unit.
+        ASSERT_NEAR(aircraft.latitude_deg_e7 / 1e7, lat_deg, 1.5e-7);
+        ASSERT_NEAR(aircraft.longitude_deg_e7 / 1e7, lon_deg, 1.5e-7);
+        max_int_error_deg = std::max({max_int_error_deg, fabs(aircraft.latitude_deg_e7 / 1e7 - lat_deg),
+                                      fabs(aircraft.longitude_deg_e7 / 1e7 - lon_deg)});
+
+        float lat_deg_float, lon_deg_float;
+        if (DecodeCPRGlobalReference<float>(pair.n_lat_even, pair.n_lon_even, pair.n_lat_odd, pair.n_lon_odd, true,
+                                            lat_deg_float, lon_deg_float)) {
+            max_float_error_deg =
+                std::max({max_float_error_deg, fabs(lat_deg_float - lat_deg), fabs(lon_deg_float - lon_deg)});
+        }
+    }
+    EXPECT_GT(num_decoded, 9900);
+    // The float path only keeps ~3e-5 degrees of precision at large angles.
+    EXPECT_LT(max_int_error_deg, max_float_error_deg);
+}
+
+TEST(Aircraft, DecodePositionBenchmark) {
+    const uint32_t kNumIterations = 1'000'000;
+    const uint16_t kNumPairs = 1024;
+    std::vector<CPRPair> pairs = GenerateRandomCPRPairs(kNumPairs);
+
+    double float_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        const CPRPair &pair = pairs[i % kNumPairs];
+        float lat_deg, lon_deg;
+        DecodeCPRGlobalReference<float>(pair.n_lat_even, pair.n_lon_even, pair.n_lat_odd, pair.n_lon_odd, true,
+                                        lat_deg, lon_deg);
+        benchmark_sink = static_cast<uint32_t>(lat_deg + lon_deg);
+    });
+    Aircraft aircraft;
+    CPRPacketPair cpr_packets;
+    double int_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        const CPRPair &pair = pairs[i % kNumPairs];
+        cpr_packets.SetCPRLatLon(pair.n_lat_even, pair.n_lon_even, false);
+        cpr_packets.SetCPRLatLon(pair.n_lat_odd, pair.n_lon_odd, true);
+        aircraft.DecodePosition(cpr_packets);
+        benchmark_sink = aircraft.latitude_deg_e7 + aircraft.longitude_deg_e7;
+    });
+    PrintBenchmarkComparison("CPR global decode (float vs integer)", float_ns, int_ns);
+}
+
+TEST(AircraftDictionary, ApplyAirbornePositionMessageLocalDecode) {
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.receiver_position_valid = true;
+    config.receiver_latitude_deg_e7 = 205000000;
+    config.receiver_longitude_deg_e7 = -1560000000;
+    AircraftDictionary dictionary = AircraftDictionary(config);
+    DecodedTransponderPacket even_tpacket = DecodedTransponderPacket((char *)"8da6147f5859f18cdf4d244ac6fa");
+    ASSERT_TRUE(even_tpacket.IsValid());
+    DecodedTransponderPacket odd_tpacket = DecodedTransponderPacket((char *)"8da6147f585b05533e2ba73e43cb");
+    ASSERT_TRUE(odd_tpacket.IsValid());
+
+    set_time_since_boot_ms(1e3);
+
+    // A single even packet is enough to get a position when the receiver position is known.
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
+    ASSERT_EQ(dictionary.GetNumAircraft(), 1);
+    auto &aircraft = *dictionary.dict.begin();
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 20.326522568524894f, 0.01f);
+    EXPECT_NEAR(aircraft.longitude_deg_e7 / 1e7, -156.5328535600142f, 0.01f);
+
+    // Odd packet gets decoded against the aircraft's last position, and matches the result of a global decode.
+    inc_time_since_boot_ms(1e3);
+    aircraft.ResetUpdatedBitFlags();
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 20.326522568524894f, kLatDegCloseEnough);
+    EXPECT_NEAR(aircraft.longitude_deg_e7 / 1e7, -156.5328535600142f, kLonDegCloseEnough);
+
+    // Every following packet updates the position, no need to wait for an odd / even pair.
+    inc_time_since_boot_ms(1e3);
+    aircraft.ResetUpdatedBitFlags();
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 20.326522568524894f, 0.01f);
+}
+
+TEST(AircraftDictionary, NewAircraftStartsWithEmptyCPRPackets) {
+    // Aircraft are packed tightly so that large dictionaries fit in RAM. Guard against layout regressions.
+    EXPECT_LE(sizeof(Aircraft), 72u);
+
+    AircraftDictionary dictionary = AircraftDictionary();
+    DecodedTransponderPacket even_tpacket = DecodedTransponderPacket((char *)"8da6147f5859f18cdf4d244ac6fa");
+    DecodedTransponderPacket odd_tpacket = DecodedTransponderPacket((char *)"8da6147f585b05533e2ba73e43cb");
+
+    set_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
+    // Replace the aircraft. CPR packets are stored out of line, and must not carry over to the new aircraft.
+    ASSERT_TRUE(dictionary.InsertAircraft(Aircraft(0xA6147F)));
+    inc_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    Aircraft aircraft;
+    ASSERT_TRUE(dictionary.GetAircraft(0xA6147F, aircraft));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+
+    // Same for an aircraft that reuses the slot of a removed aircraft.
+    ASSERT_TRUE(dictionary.RemoveAircraft(0xA6147F));
+    inc_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0xA6147F, aircraft));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+
+    // Once both packets are from the same aircraft, position gets decoded.
+    inc_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0xA6147F, aircraft));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+}
+
 TEST(AircraftDictionary, ApplyAirbornePositionMessage) {
     AircraftDictionary dictionary = AircraftDictionary();
     DecodedTransponderPacket even_tpacket = DecodedTransponderPacket((char *)"8da6147f5859f18cdf4d244ac6fa");
@@ -249,15 +759,14 @@ TEST(AircraftDictionary, ApplyAirbornePositionMessage) {
     // Ingest even packet.
     ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
     ASSERT_EQ(dictionary.GetNumAircraft(), 1);
-    auto itr = dictionary.dict.begin();
-    auto &aircraft = itr->second;
+    auto &aircraft = *dictionary.dict.begin();
 
     // Aircraft should exist but not have its location filled out.
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne));
     EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
     ASSERT_EQ(aircraft.icao_address, (uint32_t)0xA6147F);
-    EXPECT_FLOAT_EQ(aircraft.latitude_deg, 0.0f);
-    EXPECT_FLOAT_EQ(aircraft.longitude_deg, 0.0f);
+    EXPECT_EQ(aircraft.latitude_deg_e7, 0);
+    EXPECT_EQ(aircraft.longitude_deg_e7, 0);
     // Altitude should be filled out.
     EXPECT_EQ(aircraft.altitude_source, Aircraft::AltitudeSource::kAltitudeSourceBaro);
     EXPECT_EQ(aircraft.baro_altitude_ft, 16975);
@@ -270,14 +779,99 @@ TEST(AircraftDictionary, ApplyAirbornePositionMessage) {
     // Aircraft should now have a valid location.
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
     ASSERT_EQ(aircraft.icao_address, 0xA6147Fu);
-    EXPECT_NEAR(aircraft.latitude_deg, 20.326522568524894f, kLatDegCloseEnough);
-    EXPECT_NEAR(aircraft.longitude_deg, -156.5328535600142f, kLonDegCloseEnough);
+    EXPECT_NEAR(aircraft.latitude_deg_e7 / 1e7, 20.326522568524894f, kLatDegCloseEnough);
+    EXPECT_NEAR(aircraft.longitude_deg_e7 / 1e7, -156.5328535600142f, kLonDegCloseEnough);
     // Altitude should be filled out.
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedBaroAltitude));
     EXPECT_EQ(aircraft.altitude_source, Aircraft::AltitudeSource::kAltitudeSourceBaro);
     EXPECT_EQ(aircraft.baro_altitude_ft, 17000);
 }
 
+TEST(AircraftDictionary, ApplySurfacePositionMessage) {
+    // Surface position messages from The 1090MHz Riddle.
+    DecodedTransponderPacket odd_tpacket = DecodedTransponderPacket((char *)"8C4841753A9A153237AEF0F275BE");
+    ASSERT_TRUE(odd_tpacket.IsValid());
+    DecodedTransponderPacket even_tpacket = DecodedTransponderPacket((char *)"8C4841753AAB238733C8CD4020B1");
+    ASSERT_TRUE(even_tpacket.IsValid());
+    set_time_since_boot_ms(1e3);
+
+    // Surface positions can't be decoded without a reference, even with an odd / even pair.
+    AircraftDictionary dictionary = AircraftDictionary();
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    inc_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
+    Aircraft *aircraft = dictionary.GetAircraftPtr(0x484175);
+    ASSERT_NE(aircraft, nullptr);
+    EXPECT_FALSE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne));
+    EXPECT_FALSE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+    EXPECT_EQ(dictionary.stats_num_surface_positions_undecodable, 2u);
+    // Movement and ground track are still decoded.
+    EXPECT_TRUE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedHorizontalVelocity));
+    EXPECT_TRUE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedTrack));
+    EXPECT_EQ(aircraft->velocity_source, Aircraft::VelocitySource::kVelocitySourceGroundSpeed);
+    EXPECT_FLOAT_EQ(aircraft->velocity_kts, 18.0f);
+    EXPECT_FLOAT_EQ(aircraft->track_deg, 140.625f);
+
+    // Decode against the receiver position.
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.receiver_position_valid = true;
+    config.receiver_latitude_deg_e7 = 519900000;
+    config.receiver_longitude_deg_e7 = 43750000;
+    dictionary = AircraftDictionary(config);
+    inc_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    aircraft = dictionary.GetAircraftPtr(0x484175);
+    ASSERT_NE(aircraft, nullptr);
+    EXPECT_TRUE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
+    EXPECT_NEAR(aircraft->latitude_deg_e7 / 1e7, 52.32056, 1e-5);
+    EXPECT_NEAR(aircraft->longitude_deg_e7 / 1e7, 4.73574, 1e-5);
+    EXPECT_FLOAT_EQ(aircraft->velocity_kts, 17.0f);
+    EXPECT_FLOAT_EQ(aircraft->track_deg, 92.8125f);
+
+    // Following packets get decoded against the aircraft's last position.
+    inc_time_since_boot_ms(1e3);
+    aircraft->ResetUpdatedBitFlags();
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(even_tpacket));
+    EXPECT_TRUE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
+    EXPECT_NEAR(aircraft->latitude_deg_e7 / 1e7, 52.32304, 1e-5);
+    EXPECT_NEAR(aircraft->longitude_deg_e7 / 1e7, 4.73047, 1e-5);
+
+    // Taxiing aircraft can go quiet for longer than the airborne local decode window, the last position is still
+    // close enough to be used as a reference.
+    inc_time_since_boot_ms(Aircraft::kCPRLocalDecodeMaxAgeMs * 3);
+    aircraft->ResetUpdatedBitFlags();
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    EXPECT_TRUE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedPosition));
+    EXPECT_NEAR(aircraft->latitude_deg_e7 / 1e7, 52.32056, 1e-5);
+    EXPECT_NEAR(aircraft->longitude_deg_e7 / 1e7, 4.73574, 1e-5);
+    EXPECT_EQ(dictionary.stats_num_surface_positions_undecodable, 0u);
+}
+
+TEST(AircraftDictionary, SetReceiverPositionEnablesSurfaceDecode) {
+    DecodedTransponderPacket odd_tpacket = DecodedTransponderPacket((char *)"8C4841753A9A153237AEF0F275BE");
+    ASSERT_TRUE(odd_tpacket.IsValid());
+    set_time_since_boot_ms(1e3);
+
+    AircraftDictionary dictionary = AircraftDictionary();
+    int32_t latitude_deg_e7, longitude_deg_e7;
+    EXPECT_FALSE(dictionary.GetReceiverPosition(latitude_deg_e7, longitude_deg_e7));
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    EXPECT_EQ(dictionary.stats_num_surface_positions_undecodable, 1u);
+
+    // Receiver position gets set at runtime from settings, after the dictionary is constructed.
+    dictionary.SetReceiverPosition(true, 519900000, 43750000);
+    EXPECT_TRUE(dictionary.GetReceiverPosition(latitude_deg_e7, longitude_deg_e7));
+    EXPECT_EQ(latitude_deg_e7, 519900000);
+    EXPECT_EQ(longitude_deg_e7, 43750000);
+    inc_time_since_boot_ms(1e3);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(odd_tpacket));
+    Aircraft *aircraft = dictionary.GetAircraftPtr(0x484175);
+    ASSERT_NE(aircraft, nullptr);
+    EXPECT_TRUE(aircraft->HasBitFlag(Aircraft::BitFlag::kBitFlagPositionValid));
+    EXPECT_NEAR(aircraft->latitude_deg_e7 / 1e7, 52.32056, 1e-5);
+    EXPECT_EQ(dictionary.stats_num_surface_positions_undecodable, 1u);
+}
+
 // TODO: Add test case for ingesting Airborne Position message with GNSS altitude.
 
 TEST(AircraftDictionary, IngestAirborneVelocityMessage) {
@@ -290,12 +884,11 @@ TEST(AircraftDictionary, IngestAirborneVelocityMessage) {
     // Ingest the airborne velocities packet.
     ASSERT_TRUE(dictionary.IngestADSBPacket(packet));
     ASSERT_EQ(dictionary.GetNumAircraft(), 1);
-    auto itr = dictionary.dict.begin();
-    auto &aircraft = itr->second;  // NOTE: Aircraft is a mutable reference until we get to Message A!
+    auto &aircraft = *dictionary.dict.begin();  // NOTE: Aircraft is a mutable reference until we get to Message A!
 
     // Aircraft should now have velocities populated.
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedTrack));
-    EXPECT_NEAR(aircraft.track_deg, 304.2157021324374, kFloatCloseEnough);
+    EXPECT_NEAR(aircraft.track_deg, 304.2157021324374, 0.05);  // CalcGroundSpeedAndTrack is accurate to 0.05 degrees.
     // Velocity should actually evaluate to 120 when evaluated with doubles, but there is some float error with the sqrt
     // that I think gets pretty nasty.
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedHorizontalVelocity));
@@ -321,7 +914,7 @@ TEST(AircraftDictionary, IngestAirborneVelocityMessage) {
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagUpdatedTrack));
     EXPECT_EQ(aircraft.vertical_rate_fpm, -832);
     EXPECT_EQ(aircraft.velocity_source, Aircraft::VelocitySource::kVelocitySourceGroundSpeed);
-    EXPECT_NEAR(aircraft.track_deg, 182.88f, 0.01);
+    EXPECT_NEAR(aircraft.track_deg, 182.88f, 0.05);
     EXPECT_NEAR(aircraft.velocity_kts, 159.20f, 0.01);
 
     // Test altitude difference between baro and GNSS altitude for Message A by re-ingesting.
@@ -356,8 +949,9 @@ TEST(AircraftDictionary, IngestAirborneVelocityMessage) {
 
 TEST(AircraftDictionary, IngestModeC) {
     // Try ingesting a Mode C packet that's marked as valid so that it doesn't require a cross-check with the
-    // dictionary.
+    // dictionary. Address / Parity packets can't add new aircraft on their own, so add the aircraft first.
     AircraftDictionary dictionary = AircraftDictionary();
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x7C1B28u));
     DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"200006A2DE8B1C");
     tpacket.ForceValid();  // Mark it as valid so that it gets digested.
     EXPECT_EQ(tpacket.GetICAOAddress(), 0x7C1B28u);
@@ -374,6 +968,7 @@ TEST(AircraftDictionary, IngestModeC) {
     EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagAlert));
 
     // Ingest a Mode C packet with an alert and ident.
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0xD3CCBFu));
     tpacket = DecodedTransponderPacket((char *)"24000E3956BBA1");
     tpacket.ForceValid();
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
@@ -384,6 +979,7 @@ TEST(AircraftDictionary, IngestModeC) {
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagAlert));
 
     // Ingest a Mode C packet with aircraft on the ground.
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x7C7539u));
     tpacket = DecodedTransponderPacket((char *)"210000992F8C48");
     tpacket.ForceValid();
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
@@ -397,6 +993,7 @@ TEST(AircraftDictionary, IngestModeC) {
 TEST(AircraftDictionary, IngestModeA) {
     // Ingest a Mode A packet with an alert and ident.
     AircraftDictionary dictionary = AircraftDictionary();
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x739EE9u));
     DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"2C0006A2DEE500");
     tpacket.ForceValid();
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
@@ -407,6 +1004,7 @@ TEST(AircraftDictionary, IngestModeA) {
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagIdent));
 
     // Ingest a Mode A packet with an ident but no alert.
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x5863BAu));
     tpacket = DecodedTransponderPacket((char *)"2D0006A2DEE500");
     tpacket.ForceValid();
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
@@ -416,6 +1014,7 @@ TEST(AircraftDictionary, IngestModeA) {
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagIdent));
 
     // Ingest a Mode A packet with no ident and no alert. Aircraft is airborne.
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0xA8BBE7u));
     tpacket = DecodedTransponderPacket((char *)"28000D08CEE4C5");
     tpacket.ForceValid();
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
@@ -426,6 +1025,7 @@ TEST(AircraftDictionary, IngestModeA) {
     EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::BitFlag::kBitFlagIsAirborne));
 
     // Ingest a Mode A packet with no ident and no alert. Aircraft is on ground.
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x7C1471u));
     tpacket = DecodedTransponderPacket((char *)"29001E0D3CB4BF");
     tpacket.ForceValid();
     EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
@@ -450,4 +1050,689 @@ TEST(Aircraft, AircraftStats) {
     EXPECT_EQ(aircraft.stats_frames_received_in_last_interval, 2);
     EXPECT_EQ(aircraft.stats_mode_ac_frames_received_in_last_interval, 1);
     EXPECT_EQ(aircraft.stats_mode_s_frames_received_in_last_interval, 1);
-}
\ No newline at end of file
+}
+TEST(AircraftDictionary, CorrectBitErrors) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    // Repaired packets can't add new aircraft on their own.
+    ASSERT_TRUE(dictionary.GetAircraftPtr(0x7C80AD));
+
+    // Aircraft ID packet from ADSBPacket.ConstructFromTransponderPacket with one bit flipped in the ME field.
+    DecodedTransponderPacket packet = DecodedTransponderPacket((char *)"8D7C80AD2258F6B1E35C60FF1925");
+    EXPECT_FALSE(packet.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_TRUE(packet.IsValid());
+    EXPECT_TRUE(dictionary.ContainsAircraft(0x7C80AD));
+    EXPECT_EQ(dictionary.stats_num_packets_corrected_1_bit, 1u);
+
+    // Same packet with a second bit flipped can't be corrected in 1-bit mode.
+    packet = DecodedTransponderPacket((char *)"8D7C80AD2218F6B1E35C60FF1925");
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_EQ(dictionary.stats_num_packets_corrected_2_bit, 0u);
+
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.max_num_bits_to_correct = 2;
+    AircraftDictionary dictionary_2_bit = AircraftDictionary(config);
+    ASSERT_TRUE(dictionary_2_bit.GetAircraftPtr(0x7C80AD));
+    EXPECT_TRUE(dictionary_2_bit.IngestDecodedTransponderPacket(packet));
+    EXPECT_EQ(dictionary_2_bit.stats_num_packets_corrected_2_bit, 1u);
+}
+
+TEST(AircraftDictionary, RepairedPacketsAddCandidateAircraft) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+
+    // A repaired packet from a new aircraft needs to be seen twice to add the aircraft.
+    DecodedTransponderPacket packet = MakeCorruptedExtendedSquitter(0x7C80AD);
+    EXPECT_FALSE(packet.IsValid());
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0x7C80AD));
+    packet = MakeCorruptedExtendedSquitter(0x7C80AD);
+    inc_time_since_boot_ms(1000);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_TRUE(dictionary.ContainsAircraft(0x7C80AD));
+    EXPECT_EQ(dictionary.stats_num_candidates_promoted, 1u);
+    EXPECT_EQ(dictionary.stats_num_packets_corrected_1_bit, 2u);
+
+    // Candidates are forgotten after the candidate TTL.
+    const uint32_t candidate_ttl_ms = AircraftDictionary::AircraftDictionaryConfig_t().candidate_ttl_ms;
+    packet = MakeCorruptedExtendedSquitter(0xA4F239);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    inc_time_since_boot_ms(candidate_ttl_ms + 1);
+    packet = MakeCorruptedExtendedSquitter(0xA4F239);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    inc_time_since_boot_ms(candidate_ttl_ms);
+    packet = MakeCorruptedExtendedSquitter(0xA4F239);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_TRUE(dictionary.ContainsAircraft(0xA4F239));
+
+    // Candidates with unallocated ICAO addresses are never added.
+    for (uint16_t i = 0; i < 3; i++) {
+        packet = MakeCorruptedExtendedSquitter(0xB00001);
+        EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    }
+    EXPECT_FALSE(dictionary.ContainsAircraft(0xB00001));
+    EXPECT_EQ(dictionary.stats_num_candidates_unallocated, 3u);
+
+    // A CRC-clean packet adds a new aircraft right away.
+    packet = MakeCorruptedExtendedSquitter(0x3C6444);
+    packet.CorrectBitErrors(1);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_TRUE(dictionary.ContainsAircraft(0x3C6444));
+    EXPECT_EQ(dictionary.GetNumAircraft(), 3);
+    EXPECT_EQ(dictionary.stats_num_candidates_promoted, 2u);
+}
+
+TEST(AircraftDictionary, UntrustedPacketsAddCandidateAircraft) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+
+    // Address / Parity packets that were marked as valid from outside of the dictionary need to be seen twice.
+    DecodedTransponderPacket packet = MakeAddressParityPacket("200006A2", 0x7C80AD);
+    packet.ForceValid();
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0x7C80AD));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_TRUE(dictionary.ContainsAircraft(0x7C80AD));
+
+    // Unallocated addresses are never added, even from packets that were marked as valid.
+    packet = MakeAddressParityPacket("200006A2", 0xB00001);
+    packet.ForceValid();
+    for (uint16_t i = 0; i < 3; i++) {
+        EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    }
+    EXPECT_FALSE(dictionary.ContainsAircraft(0xB00001));
+    EXPECT_EQ(dictionary.stats_num_candidates_unallocated, 3u);
+    EXPECT_EQ(dictionary.stats_num_candidates_promoted, 1u);
+}
+
+TEST(AircraftDictionary, AllCallRepliesValidateAddressParityPackets) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+
+    // Mode C reply at 10000ft from an aircraft that hasn't been seen before can't be validated.
+    DecodedTransponderPacket mode_c_packet = MakeAddressParityPacket("200006A2", 0x484FDE);
+    EXPECT_EQ(mode_c_packet.GetICAOAddress(), 0x484FDEu);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(mode_c_packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0x484FDE));
+
+    // All-call replies remember the ICAO address, but don't add an aircraft to the dictionary.
+    DecodedTransponderPacket all_call_packet = DecodedTransponderPacket((char *)"5D484FDEA248F5");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(all_call_packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0x484FDE));
+
+    // Now the Mode C reply can be validated, but it only adds the aircraft once the address has been confirmed.
+    mode_c_packet = MakeAddressParityPacket("200006A2", 0x484FDE);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(mode_c_packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0x484FDE));
+    mode_c_packet = MakeAddressParityPacket("200006A2", 0x484FDE);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(mode_c_packet));
+    Aircraft aircraft;
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.baro_altitude_ft, 10000);
+
+    // All-call replies update aircraft that are in the dictionary.
+    inc_time_since_boot_ms(1000);
+    all_call_packet = MakeAcquisitionSquitter(0x484FDE);
+    EXPECT_TRUE(all_call_packet.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(all_call_packet));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.last_message_timestamp_ms, get_time_since_boot_ms());
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagIsAirborne));
+    AircraftDetails details;
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x484FDE, details));
+    EXPECT_EQ(details.transponder_capability, ADSBPacket::kCALevel2PlusTransponderAirborneCanSetCA7);
+
+    // Addresses from all-call replies expire.
+    const uint32_t ttl_ms = AircraftDictionary::AircraftDictionaryConfig_t().recent_icao_address_ttl_ms;
+    all_call_packet = MakeAcquisitionSquitter(0xA4F239);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(all_call_packet));
+    inc_time_since_boot_ms(ttl_ms + 1);
+    mode_c_packet = MakeAddressParityPacket("200006A2", 0xA4F239);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(mode_c_packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0xA4F239));
+
+    // All-call replies with unallocated addresses don't validate Address / Parity packets.
+    all_call_packet = MakeAcquisitionSquitter(0xB00001);
+    EXPECT_TRUE(all_call_packet.IsValid());
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(all_call_packet));
+    EXPECT_EQ(dictionary.stats_num_candidates_unallocated, 1u);
+    for (uint16_t i = 0; i < 3; i++) {
+        mode_c_packet = MakeAddressParityPacket("200006A2", 0xB00001);
+        EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(mode_c_packet));
+    }
+    EXPECT_FALSE(dictionary.ContainsAircraft(0xB00001));
+}
+
+TEST(AircraftDictionary, IngestModeSSurveillanceReplies) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+    DecodedTransponderPacket all_call_packet = MakeAcquisitionSquitter(0x484FDE);
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(all_call_packet));
+
+    // Short air-air surveillance reply (DF=0) from an airborne aircraft at 10000ft. The first reply only makes the
+    // aircraft a candidate.
+    DecodedTransponderPacket packet = MakeAddressParityPacket("000006A2", 0x484FDE);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    packet = MakeAddressParityPacket("000006A2", 0x484FDE);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    Aircraft aircraft;
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.baro_altitude_ft, 10000);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagIsAirborne));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagUpdatedBaroAltitude));
+    EXPECT_EQ(aircraft.stats_frames_received_in_last_interval, 0);
+
+    // Altitude codes that can't be decoded don't overwrite the altitude.
+    packet = MakeAddressParityPacket("00000000", 0x484FDE);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.baro_altitude_ft, 10000);
+
+    // Long air-air surveillance reply (DF=16) from an aircraft on the ground at 25ft.
+    packet = MakeAddressParityPacket("8400009900000000000000", 0x484FDE);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.baro_altitude_ft, 25);
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagIsAirborne));
+
+    // Comm-B altitude reply (DF=20) from an airborne aircraft at 10000ft.
+    packet = MakeAddressParityPacket("A00006A200000000000000", 0x484FDE);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.baro_altitude_ft, 10000);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagIsAirborne));
+
+    // Comm-B identity reply (DF=21) from an aircraft on the ground squawking 3751.
+    packet = MakeAddressParityPacket("A9001B3A00000000000000", 0x484FDE);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(packet));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_EQ(aircraft.squawk, 03751u);
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagIsAirborne));
+
+    // All of the replies were counted as Mode S frames.
+    Aircraft *aircraft_ptr = dictionary.GetAircraftPtr(0x484FDE);
+    aircraft_ptr->UpdateStats();
+    EXPECT_EQ(aircraft_ptr->stats_mode_s_frames_received_in_last_interval, 5);
+    EXPECT_EQ(aircraft_ptr->stats_mode_ac_frames_received_in_last_interval, 0);
+
+    // Replies from aircraft that haven't been seen aren't ingested.
+    packet = MakeAddressParityPacket("A00006A200000000000000", 0xA4F239);
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(packet));
+    EXPECT_FALSE(dictionary.ContainsAircraft(0xA4F239));
+}
+
+TEST(AircraftDictionary, IngestCommBRegisters) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+
+    // Comm-B vectors from The 1090MHz Riddle (Junzi Sun), readdressed so that they're all from the same aircraft.
+    const uint32_t icao_address = 0x484FDE;
+    DecodedTransponderPacket bds40_packet = MakeAddressParityPacket("A000029C85E42F31300000", icao_address);
+    DecodedTransponderPacket bds50_packet = MakeAddressParityPacket("A000139381951536E024D4", icao_address);
+    DecodedTransponderPacket bds60_packet = MakeAddressParityPacket("A00004128F39F91A7E27C4", icao_address);
+    ASSERT_NE(dictionary.GetAircraftPtr(icao_address), nullptr);
+
+    Aircraft aircraft;
+    AircraftDetails details;
+    ASSERT_TRUE(dictionary.GetAircraft(icao_address, aircraft));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagSelectedAltitudeValid));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagRollAngleValid));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagHeadingValid));
+
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds40_packet));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds50_packet));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds60_packet));
+    ASSERT_TRUE(dictionary.GetAircraft(icao_address, aircraft));
+    ASSERT_TRUE(dictionary.GetAircraftDetails(icao_address, details));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagSelectedAltitudeValid));
+    EXPECT_EQ(details.selected_altitude_ft, 3008);
+    EXPECT_EQ(details.baro_pressure_setting_mb_e1, 10200);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagRollAngleValid));
+    EXPECT_NEAR(details.roll_deg, 2.1f, 0.1f);
+    EXPECT_EQ(details.true_airspeed_kts, 424);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagHeadingValid));
+    EXPECT_NEAR(details.heading_deg, 42.715f, 0.01f);
+    EXPECT_EQ(details.indicated_airspeed_kts, 252);
+    EXPECT_EQ(details.mach_e3, 420);
+    // Without ADS-B velocities, ground speed, track and vertical rate come from the Comm-B registers.
+    EXPECT_EQ(aircraft.velocity_source, Aircraft::VelocitySource::kVelocitySourceGroundSpeed);
+    EXPECT_FLOAT_EQ(aircraft.velocity_kts, 438.0f);
+    EXPECT_NEAR(aircraft.track_deg, 114.258f, 0.01f);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagUpdatedHorizontalVelocity));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagUpdatedTrack));
+    EXPECT_EQ(aircraft.vertical_rate_source, Aircraft::VerticalRateSource::kVerticalRateSourceBaro);
+    EXPECT_EQ(aircraft.vertical_rate_fpm, -1920);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagUpdatedVerticalVelocity));
+    // Altitude from the reply is ingested along with the Comm-B message.
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagUpdatedBaroAltitude));
+
+    // A Comm-B message that doesn't match any register still updates the identity, but not the Comm-B fields.
+    DecodedTransponderPacket empty_packet = MakeAddressParityPacket("A9001B3A00000000000000", icao_address);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(empty_packet));
+    EXPECT_EQ(dictionary.stats_num_comm_b_unknown, 1u);
+    ASSERT_TRUE(dictionary.GetAircraft(icao_address, aircraft));
+    ASSERT_TRUE(dictionary.GetAircraftDetails(icao_address, details));
+    EXPECT_EQ(aircraft.squawk, 03751u);
+    EXPECT_EQ(details.selected_altitude_ft, 3008);
+    EXPECT_EQ(details.indicated_airspeed_kts, 252);
+}
+
+TEST(AircraftDictionary, ADSBVelocityTakesPrecedenceOverCommB) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    set_time_since_boot_ms(1000);
+    DecodedTransponderPacket adsb_packet = DecodedTransponderPacket((char *)"8dae56bc99246508b8080b6c230f");
+    ASSERT_TRUE(dictionary.IngestDecodedTransponderPacket(adsb_packet));
+    Aircraft adsb_aircraft;
+    ASSERT_TRUE(dictionary.GetAircraft(0xAE56BC, adsb_aircraft));
+    ASSERT_EQ(adsb_aircraft.velocity_source, Aircraft::VelocitySource::kVelocitySourceGroundSpeed);
+    DecodedTransponderPacket bds50_packet = MakeAddressParityPacket("A000139381951536E024D4", 0xAE56BC);
+    DecodedTransponderPacket bds60_packet = MakeAddressParityPacket("A00004128F39F91A7E27C4", 0xAE56BC);
+
+    // Comm-B registers don't overwrite a recent ADS-B velocity.
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds50_packet));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds60_packet));
+    Aircraft aircraft;
+    ASSERT_TRUE(dictionary.GetAircraft(0xAE56BC, aircraft));
+    EXPECT_FLOAT_EQ(aircraft.velocity_kts, adsb_aircraft.velocity_kts);
+    EXPECT_FLOAT_EQ(aircraft.track_deg, adsb_aircraft.track_deg);
+    EXPECT_EQ(aircraft.vertical_rate_fpm, adsb_aircraft.vertical_rate_fpm);
+
+    // Once ADS-B velocities stop, Comm-B registers take over.
+    inc_time_since_boot_ms(AircraftDetails::kADSBVelocityMaxAgeMs + 1);
+    bds50_packet = MakeAddressParityPacket("A000139381951536E024D4", 0xAE56BC);
+    bds60_packet = MakeAddressParityPacket("A00004128F39F91A7E27C4", 0xAE56BC);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds50_packet));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(bds60_packet));
+    ASSERT_TRUE(dictionary.GetAircraft(0xAE56BC, aircraft));
+    EXPECT_FLOAT_EQ(aircraft.velocity_kts, 438.0f);
+    EXPECT_NEAR(aircraft.track_deg, 114.258f, 0.01f);
+    EXPECT_EQ(aircraft.vertical_rate_fpm, -1920);
+}
+
+TEST(AircraftDictionary, IngestCommBBenchmark) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    DecodedTransponderPacket comm_b_tpacket = DecodedTransponderPacket((char *)"A00004128F39F91A7E27C46ADC21");
+    DecodedTransponderPacket mode_c_tpacket = MakeAddressParityPacket("200006A2", comm_b_tpacket.GetICAOAddress());
+    ASSERT_NE(dictionary.GetAircraftPtr(comm_b_tpacket.GetICAOAddress()), nullptr);
+
+    // Packets are copied on every iteration, since Address / Parity packets are marked valid during ingestion.
+    const uint32_t kNumIterations = 1e5;
+    double mode_c_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        DecodedTransponderPacket tpacket = mode_c_tpacket;
+        benchmark_sink = dictionary.IngestDecodedTransponderPacket(tpacket);
+    });
+    double comm_b_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        DecodedTransponderPacket tpacket = comm_b_tpacket;
+        benchmark_sink = dictionary.IngestDecodedTransponderPacket(tpacket);
+    });
+    printf("[ BENCHMARK] IngestDecodedTransponderPacket: DF=4 %.1f ns, DF=20 with Comm-B %.1f ns per packet\r\n",
+           mode_c_ns, comm_b_ns);
+    EXPECT_EQ(dictionary.stats_num_comm_b_unknown, 0u);
+}
+
+TEST(AircraftDictionary, IngestGillhamCodedAirbornePositionAltitude) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    // Airborne position with Q=0 and a Gillham coded altitude of 60000ft, built from a TC=11 packet at 38000ft.
+    DecodedTransponderPacket tpacket = MakeExtendedSquitter("8D40621D5822B2D690C8AC");
+    ASSERT_TRUE(tpacket.IsValid());
+    dictionary.IngestDecodedTransponderPacket(tpacket);
+    Aircraft aircraft;
+    ASSERT_TRUE(dictionary.GetAircraft(0x40621D, aircraft));
+    EXPECT_EQ(aircraft.baro_altitude_ft, 60000);
+    EXPECT_EQ(aircraft.altitude_source, Aircraft::kAltitudeSourceBaro);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagUpdatedBaroAltitude));
+}
+
+TEST(AircraftDictionary, IngestAircraftStatusMessage) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    Aircraft aircraft;
+    AircraftDetails details;
+
+    // Emergency / priority status, with no emergency and the aircraft's squawk.
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"8DA2C1B6E112B600000000760759");
+    ASSERT_TRUE(tpacket.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0xA2C1B6, aircraft));
+    EXPECT_EQ(aircraft.emergency_state, Aircraft::kEmergencyStateNone);
+    EXPECT_EQ(aircraft.squawk, 06513u);
+
+    // ACAS RA broadcasts are built from scratch. An ICAO address of 0 leaves just the CRC in the parity field.
+    tpacket = MakeExtendedSquitter("8D484FDEE2800000000000");
+    ASSERT_TRUE(tpacket.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x484FDE, details));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagTCASRA));
+    EXPECT_EQ(details.acas_active_resolution_advisories, 0b1u << 13);
+    EXPECT_EQ(details.acas_resolution_advisory_complements, 0u);
+
+    // Same RA, but terminated.
+    tpacket = MakeExtendedSquitter("8D484FDEE2800020000000");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0x484FDE, aircraft));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagTCASRA));
+
+    // Subtype 0 has no information.
+    tpacket = MakeExtendedSquitter("8D484FDEE0000000000000");
+    EXPECT_FALSE(dictionary.IngestDecodedTransponderPacket(tpacket));
+}
+
+TEST(AircraftDictionary, IngestTargetStateAndStatusInfoMessage) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"8DA05629EA21485CBF3F8CADAEEB");
+    ASSERT_TRUE(tpacket.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(tpacket));
+
+    Aircraft aircraft;
+    AircraftDetails details;
+    ASSERT_TRUE(dictionary.GetAircraft(0xA05629, aircraft));
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0xA05629, details));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagSelectedAltitudeValid));
+    EXPECT_EQ(details.selected_altitude_ft, 16992);
+    EXPECT_EQ(details.baro_pressure_setting_mb_e1, 10128);
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagSelectedHeadingValid));
+    EXPECT_NEAR(details.selected_heading_deg, 66.8f, 0.1f);
+    EXPECT_EQ(details.navigation_accuracy_category_position, Aircraft::kEPULessThan30Meters);
+    EXPECT_EQ(details.navigation_integrity_category_baro, Aircraft::kBAIGillHamInputCrossCheckedOrNonGillhamSource);
+    EXPECT_EQ(details.source_integrity_level, Aircraft::kPOERCLessThanOrEqualTo1em7PerFlightHour);
+    EXPECT_EQ(details.autopilot_modes, (0b1 << Aircraft::kAutopilotModeBitValid) |
+                                           (0b1 << Aircraft::kAutopilotModeBitEngaged) |
+                                           (0b1 << Aircraft::kAutopilotModeBitVNAV) |
+                                           (0b1 << Aircraft::kAutopilotModeBitLNAV));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagTCASOperational));
+}
+
+TEST(AircraftDictionary, ADSBMessageCache) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    Aircraft aircraft;
+    AircraftDetails details;
+
+    // The first message in a class is always decoded.
+    DecodedTransponderPacket id_tpacket = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, 0u);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 1u);
+
+    // Repeats are accepted and counted, without being decoded again.
+    for (uint16_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    }
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, 3u);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 1u);
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STREQ(aircraft.callsign, "SIA224");
+
+    // Operation status messages share the IDENT and TCAS RA flags with Mode S replies, so they're always decoded.
+    DecodedTransponderPacket op_status_tpacket = MakeExtendedSquitter("8D76CE88F8230016004AB8");
+    ASSERT_TRUE(op_status_tpacket.IsValid());
+    DecodedTransponderPacket mode_c_tpacket = MakeAddressParityPacket("200006A2", 0x76CE88);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(op_status_tpacket));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(mode_c_tpacket));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(op_status_tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_TRUE(aircraft.HasBitFlag(Aircraft::kBitFlagIdent));
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
+    EXPECT_EQ(details.adsb_version, 2);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, 4u);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 1u);
+
+    // A changed ME field is decoded.
+    DecodedTransponderPacket new_id_tpacket = MakeExtendedSquitter("8D76CE88204C9072CB4860");
+    ASSERT_TRUE(new_id_tpacket.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(new_id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 2u);
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STRNE(aircraft.callsign, "SIA224");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 3u);
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STREQ(aircraft.callsign, "SIA224");
+
+    // So is a changed capability, which is also written by all-call replies.
+    DecodedTransponderPacket ca4_id_tpacket = MakeExtendedSquitter("8C76CE88204C9072CB4820");
+    ASSERT_TRUE(ca4_id_tpacket.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(ca4_id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 4u);
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
+    EXPECT_EQ(details.transponder_capability, 4);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 5u);
+
+    // All-call replies write the capability too, so they invalidate the cached aircraft ID.
+    DecodedTransponderPacket ca4_all_call_tpacket = MakeAddressParityPacket("5C76CE88", 0);
+    ASSERT_TRUE(ca4_all_call_tpacket.IsValid());
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(ca4_all_call_tpacket));
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
+    EXPECT_EQ(details.transponder_capability, 4);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 6u);
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
+    EXPECT_EQ(details.transponder_capability, 5);
+
+    // Caches belong to a single aircraft, and are reset when the aircraft is replaced.
+    EXPECT_TRUE(dictionary.InsertAircraft(Aircraft(0x76CE88)));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 7u);
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STREQ(aircraft.callsign, "SIA224");
+
+    // Position and velocity messages are never cached.
+    uint32_t num_hits = dictionary.stats_num_adsb_message_cache_hits;
+    uint32_t num_misses = dictionary.stats_num_adsb_message_cache_misses;
+    DecodedTransponderPacket velocity_tpacket = DecodedTransponderPacket((char *)"8D485020994409940838175B284F");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(velocity_tpacket));
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(velocity_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, num_hits);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, num_misses);
+
+    dictionary.Init();
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, 0u);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 0u);
+}
+
+TEST(AircraftDictionary, ADSBMessageCacheBenchmark) {
+    AircraftDictionary dictionary = AircraftDictionary();
+    // Alternating between two aircraft IDs misses the cache every time, repeating the same one always hits.
+    DecodedTransponderPacket id_tpackets[2] = {DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D"),
+                                               MakeExtendedSquitter("8D76CE88204C9072CB4860")};
+    const uint32_t kNumIterations = 1e5;
+    double uncached_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        benchmark_sink = dictionary.IngestDecodedTransponderPacket(id_tpackets[i & 0b1]);
+    });
+    double cached_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        benchmark_sink = dictionary.IngestDecodedTransponderPacket(id_tpackets[0]);
+    });
+    PrintBenchmarkComparison("IngestDecodedTransponderPacket repeated aircraft ID", uncached_ns, cached_ns);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, kNumIterations - 1);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, kNumIterations + 1);
+}
+
+TEST(AircraftDictionary, LazyDecode) {
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.lazy_decode = true;
+    AircraftDictionary dictionary = AircraftDictionary(config);
+    Aircraft aircraft;
+    AircraftDetails details;
+
+    // Messages are accepted without being decoded.
+    DecodedTransponderPacket id_tpacket = DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D");
+    DecodedTransponderPacket op_status_tpacket = MakeExtendedSquitter("8D76CE88F8230006004AB8");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    Aircraft *aircraft_ptr = dictionary.GetAircraftPtr(0x76CE88);
+    ASSERT_NE(aircraft_ptr, nullptr);
+    EXPECT_STREQ(aircraft_ptr->callsign, "?");
+
+    // A message of a different type gets the pending message decoded first, so that they're applied in order.
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(op_status_tpacket));
+    EXPECT_STREQ(aircraft_ptr->callsign, "SIA224");
+    EXPECT_NE(dictionary.GetAircraftDetails(*aircraft_ptr).adsb_version, 2);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, 1u);
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_misses, 1u);
+
+    // Reading the aircraft decodes it.
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STREQ(aircraft.callsign, "SIA224");
+    EXPECT_EQ(aircraft.airframe_type, Aircraft::kAirframeTypeNoCategoryInfo);
+    ASSERT_TRUE(dictionary.GetAircraftDetails(0x76CE88, details));
+    EXPECT_EQ(details.transponder_capability, 5);
+    EXPECT_EQ(details.adsb_version, 2);
+
+    // Iterating over dict doesn't decode anything, reporters call DecodePendingMessages first.
+    DecodedTransponderPacket new_id_tpacket = MakeExtendedSquitter("8D76CE88204C9072CB4860");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(new_id_tpacket));
+    EXPECT_STREQ(aircraft_ptr->callsign, "SIA224");
+    dictionary.DecodePendingMessages();
+    EXPECT_STRNE(aircraft_ptr->callsign, "SIA224");
+
+    // A repeat of the cached message replaces an older pending message instead of being applied before it.
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STREQ(aircraft.callsign, "SIA224");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(new_id_tpacket));
+    uint32_t num_hits = dictionary.stats_num_adsb_message_cache_hits;
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(id_tpacket));
+    EXPECT_EQ(dictionary.stats_num_adsb_message_cache_hits, num_hits + 1);
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_STREQ(aircraft.callsign, "SIA224");
+
+    // Messages that fail to decode are still accepted.
+    DecodedTransponderPacket no_info_tpacket = MakeExtendedSquitter("8D76CE88E0000000000000");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(no_info_tpacket));
+    dictionary.DecodePendingMessages();
+
+    // A pending IDENT from an operation status message doesn't overwrite the flight status of a newer reply.
+    DecodedTransponderPacket op_status_ident_tpacket = MakeExtendedSquitter("8D76CE88F8230016004AB8");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(op_status_ident_tpacket));
+    DecodedTransponderPacket mode_c_tpacket = MakeAddressParityPacket("200006A2", 0x76CE88);
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(mode_c_tpacket));
+    ASSERT_TRUE(dictionary.GetAircraft(0x76CE88, aircraft));
+    EXPECT_FALSE(aircraft.HasBitFlag(Aircraft::kBitFlagIdent));
+
+    // Velocity messages are decoded during ingestion, so that they're timestamped with the time they were received.
+    DecodedTransponderPacket velocity_tpacket = DecodedTransponderPacket((char *)"8D485020994409940838175B284F");
+    EXPECT_TRUE(dictionary.IngestDecodedTransponderPacket(velocity_tpacket));
+    aircraft_ptr = dictionary.GetAircraftPtr(0x485020);
+    ASSERT_NE(aircraft_ptr, nullptr);
+    EXPECT_TRUE(aircraft_ptr->HasBitFlag(Aircraft::kBitFlagUpdatedHorizontalVelocity));
+    EXPECT_EQ(dictionary.GetAircraftDetails(*aircraft_ptr).last_adsb_velocity_timestamp_ms, get_time_since_boot_ms());
+}
+
+TEST(AircraftDictionary, LazyDecodeBenchmark) {
+    AircraftDictionary::AircraftDictionaryConfig_t config;
+    config.lazy_decode = true;
+    AircraftDictionary eager_dictionary = AircraftDictionary();
+    AircraftDictionary lazy_dictionary = AircraftDictionary(config);
+    // Alternate between two aircraft IDs so that every message misses the cache.
+    DecodedTransponderPacket id_tpackets[2] = {DecodedTransponderPacket((char *)"8D76CE88204C9072CB48209A504D"),
+                                               MakeExtendedSquitter("8D76CE88204C9072CB4860")};
+    const uint32_t kNumIterations = 1e5;
+    double eager_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        benchmark_sink = eager_dictionary.IngestDecodedTransponderPacket(id_tpackets[i & 0b1]);
+    });
+    double lazy_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        benchmark_sink = lazy_dictionary.IngestDecodedTransponderPacket(id_tpackets[i & 0b1]);
+    });
+    PrintBenchmarkComparison("IngestDecodedTransponderPacket aircraft ID, lazy decode", eager_ns, lazy_ns);
+
+    Aircraft eager_aircraft, lazy_aircraft;
+    ASSERT_TRUE(eager_dictionary.GetAircraft(0x76CE88, eager_aircraft));
+    ASSERT_TRUE(lazy_dictionary.GetAircraft(0x76CE88, lazy_aircraft));
+    EXPECT_STREQ(lazy_aircraft.callsign, eager_aircraft.callsign);
+}
+
+TEST(RecentICAOAddressSet, InsertAndExpire) {
+    RecentICAOAddressSet set;
+    const uint32_t kTTLMs = 1000;
+    EXPECT_FALSE(set.Contains(0xABCDEF, 0, kTTLMs));
+    set.Insert(0xABCDEF, 0);
+    EXPECT_TRUE(set.Contains(0xABCDEF, 1000, kTTLMs));
+    EXPECT_FALSE(set.Contains(0xABCDEF, 1001, kTTLMs));
+    set.Insert(0xABCDEF, 1001);  // Refresh.
+    EXPECT_TRUE(set.Contains(0xABCDEF, 1001, kTTLMs));
+
+    // When the set overflows, the most recently seen addresses are kept.
+    const uint16_t kNumEntries = RecentICAOAddressSet::kNumSets * RecentICAOAddressSet::kNumWays;
+    set.Clear();
+    EXPECT_FALSE(set.Contains(0xABCDEF, 1001, kTTLMs));
+    for (uint32_t i = 0; i < 4 * kNumEntries; i++) {
+        set.Insert(i, i / 4);
+    }
+    uint16_t num_recent_kept = 0;
+    for (uint32_t i = 3 * kNumEntries; i < 4 * kNumEntries; i++) {
+        num_recent_kept += set.Contains(i, kNumEntries, kTTLMs);
+    }
+    EXPECT_GT(num_recent_kept, kNumEntries / 2);
+    EXPECT_FALSE(set.Contains(0, kNumEntries, kTTLMs));
+}
+
+TEST(AircraftCandidateTable, RecordSighting) {
+    AircraftCandidateTable table;
+    const uint32_t kTTLMs = 1000;
+    EXPECT_EQ(table.RecordSighting(0xABCDEF, 0, kTTLMs), 1);
+    EXPECT_EQ(table.RecordSighting(0xABCDEF, 500, kTTLMs), 2);
+    EXPECT_EQ(table.RecordSighting(0xABCDEF, 1000, kTTLMs), 3);
+    EXPECT_EQ(table.RecordSighting(0xABCDEF, 1001, kTTLMs), 1);  // Expired, starts over.
+    table.Remove(0xABCDEF);
+    EXPECT_EQ(table.RecordSighting(0xABCDEF, 1002, kTTLMs), 1);
+
+    // Fill up every entry, so that addresses have to be replaced. The address with the oldest first sighting in a set
+    // is replaced first, so the most recent sightings are kept.
+    const uint16_t kNumEntries = AircraftCandidateTable::kNumSets * AircraftCandidateTable::kNumWays;
+    table.Clear();
+    for (uint32_t i = 0; i < 4 * kNumEntries; i++) {
+        table.RecordSighting(i, 100 + i, kTTLMs);
+    }
+    uint16_t num_recent_kept = 0;
+    for (uint32_t i = 3 * kNumEntries; i < 4 * kNumEntries; i++) {
+        num_recent_kept += table.RecordSighting(i, 100 + 4 * kNumEntries, kTTLMs) == 2;
+    }
+    // Sets don't fill evenly, so some recent addresses are replaced by more recent addresses in the same set.
+    EXPECT_GT(num_recent_kept, kNumEntries / 2);
+    EXPECT_EQ(table.RecordSighting(0, 100 + 4 * kNumEntries, kTTLMs), 1);  // Oldest address was replaced.
+}
+
+// Stand-in for the old owning ADSBPacket, which derived from DecodedTransponderPacket, added its decoded capability and
+// typecode, and was passed by value through each layer of the ingestion path.
+struct CopiedADSBPacket {
+    DecodedTransponderPacket packet;
+    ADSBPacket::Capability capability;
+    ADSBPacket::TypeCode typecode;
+};
+
+__attribute__((noinline)) uint32_t ApplyCopiedPacket(CopiedADSBPacket packet) {
+    return packet.packet.GetICAOAddress() ^ packet.packet.GetPacketBufferLenBits();
+}
+
+__attribute__((noinline)) uint32_t IngestCopiedPacket(CopiedADSBPacket packet) { return ApplyCopiedPacket(packet); }
+
+__attribute__((noinline)) uint32_t ApplyPacketView(const ADSBPacket &packet) {
+    return packet.GetICAOAddress() ^ packet.GetPacketBufferLenBits();
+}
+
+__attribute__((noinline)) uint32_t IngestPacketView(const ADSBPacket &packet) { return ApplyPacketView(packet); }
+
+TEST(AircraftDictionary, PacketHandoffBenchmark) {
+    const uint32_t kNumIterations = 1'000'000;
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"8dae56bc99246508b8080b6c230f");
+    ASSERT_TRUE(tpacket.IsValid());
+
+    double copy_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        CopiedADSBPacket packet = {.packet = tpacket,
+                                   .capability = ADSBPacket::kCALevel2PlusTransponderAirborneCanSetCA7,
+                                   .typecode = ADSBPacket::kTypeCodeAirborneVelocities};
+        benchmark_sink = IngestCopiedPacket(packet);
+    });
+    double view_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        ADSBPacket packet = ADSBPacket(tpacket);
+        benchmark_sink = IngestPacketView(packet);
+    });
+    PrintBenchmarkComparison("ADSBPacket handoff (copy vs view)", copy_ns, view_ns);
+
+    AircraftDictionary dictionary = AircraftDictionary();
+    double ingest_ns = BenchmarkNsPerCall(
+        kNumIterations, [&](uint32_t i) { benchmark_sink = dictionary.IngestDecodedTransponderPacket(tpacket); });
+    printf("[ BENCHMARK] IngestDecodedTransponderPacket: %.1f ns per packet\r\n", ingest_ns);
+    EXPECT_EQ(dictionary.GetNumAircraft(), 1);
+}
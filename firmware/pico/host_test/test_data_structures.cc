@@ -1,8 +1,13 @@
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include "benchmark.hh"
 #include "data_structures.hh"
 #include "gtest/gtest.h"
 
-template <class T>
-void FillAndEmptyQueue(PFBQueue<T> &queue, uint16_t queue_max_length) {
+template <class Queue>
+void FillAndEmptyQueue(Queue &queue, uint16_t queue_max_length) {
     ASSERT_EQ(queue.Length(), 0);
     // Fill up the queue.
     for (uint16_t i = 0; i < queue_max_length; i++) {
@@ -104,4 +109,361 @@ TEST(PFBQueue, OverwriteWhenFull) {
         EXPECT_TRUE(queue.Pop(out));
         EXPECT_EQ(out, i);
     }
-}
\ No newline at end of file
+}
+
+TEST(PFBQueue, OverwriteWrapsHead) {
+    uint16_t buf_len_num_elements = 4;
+    PFBQueue<uint32_t> queue = PFBQueue<uint32_t>(
+        {.buf_len_num_elements = buf_len_num_elements, .buffer = nullptr, .overwrite_when_full = true});
+
+    // Overwrite enough times for the head to wrap around the end of the buffer more than once.
+    for (uint32_t i = 0; i < 5u * buf_len_num_elements; i++) {
+        EXPECT_TRUE(queue.Push(i));
+        EXPECT_EQ(queue.Length(), std::min<uint32_t>(i + 1, queue.MaxNumElements()));
+    }
+    for (uint32_t i = 5u * buf_len_num_elements - queue.MaxNumElements(); i < 5u * buf_len_num_elements; i++) {
+        uint32_t out;
+        EXPECT_TRUE(queue.Pop(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_EQ(queue.Length(), 0);
+}
+
+TEST(SPSCQueue, BasicConstruction) {
+    uint16_t buf_len_num_elements = 5;
+    SPSCQueue<uint32_t> queue =
+        SPSCQueue<uint32_t>({.buf_len_num_elements = buf_len_num_elements, .buffer = nullptr});
+    FillAndEmptyQueue(queue, buf_len_num_elements - 1);
+
+    uint32_t buffer[buf_len_num_elements];
+    SPSCQueue<uint32_t> static_queue =
+        SPSCQueue<uint32_t>({.buf_len_num_elements = buf_len_num_elements, .buffer = buffer});
+    FillAndEmptyQueue(static_queue, buf_len_num_elements - 1);
+
+    EXPECT_TRUE(static_queue.Push(1));
+    EXPECT_TRUE(static_queue.Push(2));
+    static_queue.Clear();
+    EXPECT_EQ(static_queue.Length(), 0);
+    uint32_t out;
+    EXPECT_FALSE(static_queue.Pop(out));
+}
+
+TEST(SPSCQueue, OverwriteWhenFull) {
+    uint16_t buf_len_num_elements = 4;
+    SPSCQueue<uint32_t> queue = SPSCQueue<uint32_t>(
+        {.buf_len_num_elements = buf_len_num_elements, .buffer = nullptr, .overwrite_when_full = true});
+
+    // Push far more elements than fit, the consumer only gets the newest ones.
+    for (uint32_t i = 0; i < 5u * buf_len_num_elements; i++) {
+        EXPECT_TRUE(queue.Push(i));
+        EXPECT_EQ(queue.Length(), std::min<uint32_t>(i + 1, queue.MaxNumElements()));
+    }
+    for (uint32_t i = 5u * buf_len_num_elements - queue.MaxNumElements(); i < 5u * buf_len_num_elements; i++) {
+        uint32_t out;
+        EXPECT_TRUE(queue.Pop(out));
+        EXPECT_EQ(out, i);
+    }
+    uint32_t out;
+    EXPECT_FALSE(queue.Pop(out));
+}
+
+// Element big enough that copying it isn't atomic, so that torn reads would show up as mismatched words.
+struct SPSCQueueStressTestElement {
+    static const uint16_t kNumWords = 16;
+    uint32_t words[kNumWords];
+
+    SPSCQueueStressTestElement(uint32_t value = 0) {
+        for (uint16_t i = 0; i < kNumWords; i++) {
+            words[i] = value;
+        }
+    }
+    bool IsConsistent() const {
+        for (uint16_t i = 1; i < kNumWords; i++) {
+            if (words[i] != words[0]) return false;
+        }
+        return true;
+    }
+};
+
+TEST(SPSCQueue, TwoThreadStress) {
+    const uint32_t kNumElements = 1e6;
+    SPSCQueue<SPSCQueueStressTestElement> queue =
+        SPSCQueue<SPSCQueueStressTestElement>({.buf_len_num_elements = 7, .buffer = nullptr});
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < kNumElements; i++) {
+            while (!queue.Push(SPSCQueueStressTestElement(i))) {
+                std::this_thread::yield();  // Full, wait for the consumer.
+            }
+        }
+    });
+
+    // Every element arrives exactly once, in order, and intact.
+    uint32_t num_errors = 0;
+    for (uint32_t i = 0; i < kNumElements;) {
+        SPSCQueueStressTestElement element;
+        if (!queue.Pop(element)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!element.IsConsistent() || element.words[0] != i) num_errors++;
+        i++;
+    }
+    producer.join();
+    EXPECT_EQ(num_errors, 0u);
+    EXPECT_EQ(queue.Length(), 0);
+}
+
+TEST(SPSCQueue, TwoThreadStressOverwriteWhenFull) {
+    const uint32_t kNumElements = 1e6;
+    // Producer can get this far ahead of the last element received, which is more than the queue holds, so it keeps
+    // overwriting elements while the consumer is reading them.
+    const uint32_t kMaxLeadNumElements = 12;
+    SPSCQueue<SPSCQueueStressTestElement> queue = SPSCQueue<SPSCQueueStressTestElement>(
+        {.buf_len_num_elements = 8, .buffer = nullptr, .overwrite_when_full = true});
+    std::atomic<uint32_t> last_value_received = 0;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 1; i <= kNumElements; i++) {
+            while (i - last_value_received.load(std::memory_order_acquire) > kMaxLeadNumElements) {
+                std::this_thread::yield();
+            }
+            EXPECT_TRUE(queue.Push(SPSCQueueStressTestElement(i)));
+        }
+    });
+
+    // Elements can be dropped, but the ones that arrive are intact and in order.
+    uint32_t num_errors = 0;
+    uint32_t num_received = 0;
+    uint32_t last_value = 0;
+    while (last_value != kNumElements) {  // Newest element is never dropped.
+        SPSCQueueStressTestElement element;
+        if (!queue.Pop(element)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!element.IsConsistent() || element.words[0] <= last_value) num_errors++;
+        last_value = element.words[0];
+        num_received++;
+        last_value_received.store(last_value, std::memory_order_release);
+    }
+    producer.join();
+    EXPECT_EQ(num_errors, 0u);
+    // Consumer receives at least one element for every kMaxLeadNumElements pushed.
+    EXPECT_GE(num_received, kNumElements / kMaxLeadNumElements);
+}
+
+TEST(FixedHashMap, InsertFindErase) {
+    FixedHashMap<uint32_t, 10> map;
+    EXPECT_EQ(map.Size(), 0);
+    EXPECT_EQ(map.Find(0), nullptr);
+    EXPECT_FALSE(map.Erase(0));
+
+    // Key 0 is a valid key.
+    EXPECT_TRUE(map.Insert(0, 100));
+    EXPECT_TRUE(map.Insert(0xABCDEF, 200));
+    EXPECT_EQ(map.Size(), 2);
+    ASSERT_NE(map.Find(0), nullptr);
+    EXPECT_EQ(*map.Find(0), 100u);
+    EXPECT_EQ(*map.Find(0xABCDEF), 200u);
+
+    // Inserting an existing key overwrites it.
+    EXPECT_TRUE(map.Insert(0, 300));
+    EXPECT_EQ(map.Size(), 2);
+    EXPECT_EQ(*map.Find(0), 300u);
+
+    EXPECT_TRUE(map.Erase(0));
+    EXPECT_FALSE(map.Contains(0));
+    EXPECT_TRUE(map.Contains(0xABCDEF));
+    EXPECT_EQ(map.Size(), 1);
+    map.Clear();
+    EXPECT_EQ(map.Size(), 0);
+    EXPECT_FALSE(map.Contains(0xABCDEF));
+}
+
+TEST(FixedHashMap, FullAndPointerStability) {
+    FixedHashMap<uint32_t, 20> map;
+    uint32_t *pointers[20];
+    for (uint16_t i = 0; i < map.MaxNumElements(); i++) {
+        bool inserted = false;
+        pointers[i] = map.GetOrInsert(i * 0x100, inserted);
+        ASSERT_NE(pointers[i], nullptr);
+        EXPECT_TRUE(inserted);
+        *pointers[i] = i;
+    }
+    // Map is full.
+    bool inserted = true;
+    EXPECT_EQ(map.GetOrInsert(0xFFFFFF, inserted), nullptr);
+    EXPECT_FALSE(inserted);
+    EXPECT_FALSE(map.Insert(0xFFFFFF, 0));
+    // Existing keys can still be looked up and overwritten.
+    EXPECT_EQ(map.GetOrInsert(0x100, inserted), pointers[1]);
+    EXPECT_FALSE(inserted);
+    EXPECT_TRUE(map.Insert(0x100, 1));
+
+    // Erasing elements shuffles the index around, but values must not move.
+    for (uint16_t i = 0; i < map.MaxNumElements(); i += 2) {
+        EXPECT_TRUE(map.Erase(i * 0x100));
+    }
+    for (uint16_t i = 1; i < map.MaxNumElements(); i += 2) {
+        EXPECT_EQ(map.Find(i * 0x100), pointers[i]);
+        EXPECT_EQ(*pointers[i], i);
+    }
+}
+
+TEST(FixedHashMap, IterateAndEraseWhileIterating) {
+    FixedHashMap<uint32_t, 50> map;
+    for (uint32_t i = 0; i < 50; i++) {
+        map.Insert(i, i);
+    }
+    uint32_t sum = 0;
+    for (uint32_t &value : map) {
+        sum += value;
+        if (value % 2 == 0) {
+            EXPECT_TRUE(map.Erase(value));
+        }
+    }
+    EXPECT_EQ(sum, 49u * 50u / 2u);
+    EXPECT_EQ(map.Size(), 25);
+    const FixedHashMap<uint32_t, 50> &const_map = map;
+    uint16_t num_elements = 0;
+    for (const uint32_t &value : const_map) {
+        EXPECT_EQ(value % 2, 1u);
+        num_elements++;
+    }
+    EXPECT_EQ(num_elements, 25);
+}
+
+TEST(FixedHashMap, MatchesUnorderedMap) {
+    // Random operations on ICAO-like keys, checked against std::unordered_map. Keys are drawn from a small range so
+    // that the map fills up and probe runs get long and wrap around the end of the index.
+    FixedHashMap<uint32_t, 100> map;
+    std::unordered_map<uint32_t, uint32_t> reference;
+    std::mt19937 rng(12345);
+    for (uint32_t i = 0; i < 100000; i++) {
+        uint32_t key = 0x7C0000 + (rng() % 300);
+        switch (rng() % 3) {
+            case 0: {
+                bool inserted;
+                uint32_t *value = map.GetOrInsert(key, inserted);
+                if (reference.count(key) > 0) {
+                    ASSERT_FALSE(inserted);
+                    ASSERT_EQ(*value, reference[key]);
+                } else if (reference.size() < 100) {
+                    ASSERT_TRUE(inserted);
+                    *value = i;
+                    reference[key] = i;
+                } else {
+                    ASSERT_EQ(value, nullptr);
+                }
+                break;
+            }
+            case 1:
+                ASSERT_EQ(map.Erase(key), reference.erase(key) > 0);
+                break;
+            case 2: {
+                uint32_t *value = map.Find(key);
+                auto itr = reference.find(key);
+                ASSERT_EQ(value != nullptr, itr != reference.end());
+                if (value != nullptr) {
+                    ASSERT_EQ(*value, itr->second);
+                }
+                break;
+            }
+        }
+        ASSERT_EQ(map.Size(), reference.size());
+    }
+}
+
+TEST(FixedHashMap, Benchmark) {
+    // Aircraft-sized payload, with a mix of lookups, insertions, and removals over a churning set of ICAO addresses.
+    struct Payload {
+        uint32_t data[64];
+    };
+    const uint16_t kNumKeys = 128;
+    uint32_t keys[kNumKeys];
+    std::mt19937 rng(42);
+    for (uint16_t i = 0; i < kNumKeys; i++) {
+        keys[i] = rng() & 0xFFFFFF;
+    }
+    const uint32_t kNumIterations = 1000000;
+
+    std::unordered_map<uint32_t, Payload> unordered_map;
+    double unordered_map_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        Payload &payload = unordered_map[keys[i % kNumKeys]];  // Lookup or insert.
+        payload.data[0] = i;
+        if (i % 4 == 0) unordered_map.erase(keys[(i + kNumKeys / 2) % kNumKeys]);
+        benchmark_sink = unordered_map.size();
+    });
+
+    static FixedHashMap<Payload, 100> fixed_map;
+    double fixed_map_ns = BenchmarkNsPerCall(kNumIterations, [&](uint32_t i) {
+        bool inserted;
+        Payload *payload = fixed_map.GetOrInsert(keys[i % kNumKeys], inserted);
+        if (payload != nullptr) payload->data[0] = i;
+        if (i % 4 == 0) fixed_map.Erase(keys[(i + kNumKeys / 2) % kNumKeys]);
+        benchmark_sink = fixed_map.Size();
+    });
+
+    PrintBenchmarkComparison("FixedHashMap vs std::unordered_map", unordered_map_ns, fixed_map_ns);
+}
+
+TEST(IndexedLinkedList, InsertMoveRemove) {
+    const uint16_t kNone = IndexedLinkedList<8>::kInvalidIndex;
+    IndexedLinkedList<8> list;
+    EXPECT_EQ(list.Length(), 0);
+    EXPECT_EQ(list.Front(), kNone);
+    EXPECT_EQ(list.Back(), kNone);
+    EXPECT_FALSE(list.Remove(3));
+    EXPECT_FALSE(list.MoveToBack(8));  // Out of range.
+
+    // 3, 1, 5
+    EXPECT_TRUE(list.MoveToBack(3));
+    EXPECT_TRUE(list.MoveToBack(1));
+    EXPECT_TRUE(list.MoveToBack(5));
+    EXPECT_EQ(list.Length(), 3);
+    EXPECT_EQ(list.Front(), 3);
+    EXPECT_EQ(list.Back(), 5);
+    EXPECT_EQ(list.Next(3), 1);
+    EXPECT_EQ(list.Prev(1), 3);
+    EXPECT_EQ(list.Next(5), kNone);
+    EXPECT_EQ(list.Prev(3), kNone);
+
+    // 0, 3, 1, 7, 5
+    EXPECT_TRUE(list.InsertBefore(0, 3));
+    EXPECT_TRUE(list.InsertBefore(7, 5));
+    EXPECT_FALSE(list.InsertBefore(2, 4));  // Can't insert before an index that isn't in the list.
+    EXPECT_EQ(list.Length(), 5);
+    const uint16_t kExpectedOrder[] = {0, 3, 1, 7, 5};
+    uint16_t i = 0;
+    for (uint16_t index = list.Front(); index != kNone; index = list.Next(index)) {
+        ASSERT_LT(i, 5);
+        EXPECT_EQ(index, kExpectedOrder[i++]);
+    }
+    EXPECT_EQ(i, 5);
+
+    // Moving an index that's already in the list doesn't change the length. 0, 1, 7, 5, 3
+    EXPECT_TRUE(list.MoveToBack(3));
+    EXPECT_EQ(list.Length(), 5);
+    EXPECT_EQ(list.Back(), 3);
+    EXPECT_EQ(list.Next(0), 1);
+
+    // Remove from the front, middle, and back. 1, 5
+    EXPECT_TRUE(list.Remove(0));
+    EXPECT_TRUE(list.Remove(7));
+    EXPECT_TRUE(list.Remove(3));
+    EXPECT_FALSE(list.Remove(3));
+    EXPECT_FALSE(list.Contains(3));
+    EXPECT_TRUE(list.Contains(5));
+    EXPECT_EQ(list.Length(), 2);
+    EXPECT_EQ(list.Front(), 1);
+    EXPECT_EQ(list.Back(), 5);
+    EXPECT_EQ(list.Next(1), 5);
+    EXPECT_EQ(list.Prev(5), 1);
+
+    list.Clear();
+    EXPECT_EQ(list.Length(), 0);
+    EXPECT_FALSE(list.Contains(1));
+    EXPECT_EQ(list.Front(), kNone);
+    EXPECT_EQ(list.Back(), kNone);
+}
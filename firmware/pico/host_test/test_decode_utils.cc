@@ -1,5 +1,84 @@
+#include <cmath>
+
+#include "benchmark.hh"
 #include "decode_utils.hh"  // for location calculation utility functions
 #include "gtest/gtest.h"
+#include "unit_conversions.hh"
+
+// Closed form of NL(lat) from Equation 5.3, evaluated in double precision. Returns a non-integer NL so that callers can
+// tell when lat is too close to a transition latitude to trust the result.
+double CalcNLCPRFromLatClosedForm(double lat) {
+    if (fabs(lat) > 87.0) {
+        return 1.0;
+    } else if (fabs(lat) == 87.0) {
+        return 2.0;
+    }
+    return 2.0 * M_PI / acos(1.0 - (1.0 - cos(M_PI / (2.0 * kCPRNz))) / pow(cos(M_PI / 180.0 * lat), 2));
+}
+
+// Previous implementation of CalcNLCPRFromLat, kept for benchmarking.
+uint16_t CalcNLCPRFromLatTranscendental(float lat) {
+    if (fabsf(lat) > 87.0f) {
+        return 1;
+    }
+    return floorf(2.0f * (float)M_PI /
+                  acosf(1 - (1 - cosf((float)M_PI / (2.0f * kCPRNz))) / powf(cosf((float)M_PI / 180.0f * lat), 2)));
+}
+
+// Previous implementations of AltitudeCodeToAltitudeFt and IdentityCodeToSquawk, kept for benchmarking and for checking
+// the lookup tables.
+int32_t AltitudeCodeToAltitudeFtBitwise(uint16_t altitude_code) {
+    // Altitude Code Format
+    //                                     M        Q
+    // +----+----+----+----+----+----+---+----+---+----+----+----+----+
+    // | C1 | A1 | C2 | A2 | C4 | A4 | 0 | B1 | 0 | B2 | D2 | B4 | D4 |
+    // +----+----+----+----+----+----+---+----+---+----+----+----+----+
+
+    if (altitude_code == 0b0) {
+        // All bits are 0: Altitude information not available or invalid.
+        return kAltitudeDecodeErrorNotAvailableOrInvalid;
+    }
+    bool m = (altitude_code >> 6) & 0b1;
+    bool q = (altitude_code >> 4) & 0b1;
+    if (m) {
+        // M=1: Altitude in meters.
+        // Remove the M bit to get altitude in meters.
+        int16_t altitude_meters = ((altitude_code & (0b111111 << 7)) >> 1) | (altitude_code & 0b111111);
+        // Return altitude in feet.
+        return MetersToFeet(altitude_meters);
+    } else if (q) {
+        // M=0, Q=1: Altitude in 25ft increments.
+        int16_t left_blob = altitude_code & (0b111111 << 7);
+        int16_t mid_bit = altitude_code & (0b1 << 5);
+        int16_t right_blob = altitude_code & 0b1111;
+        int16_t altitude_feet_increments = (left_blob >> 2) | (mid_bit >> 1) | right_blob;
+        return 25 * altitude_feet_increments - 1000;
+    } else {
+        // M=0, Q=0: Regular Mode C reply.
+        return GillhamToAltitudeFt(AltitudeCodeToGillham(altitude_code));
+    }
+}
+
+uint16_t IdentityCodeToSquawkBitwise(uint16_t identity_code) {
+    uint8_t d1 = (identity_code & (0b1 << 4)) >> 4;
+    uint8_t d2 = (identity_code & (0b1 << 2)) >> 2;
+    uint8_t d4 = identity_code & 0b1;
+
+    uint8_t a1 = (identity_code & (0b1 << 11)) >> 11;
+    uint8_t a2 = (identity_code & (0b1 << 9)) >> 9;
+    uint8_t a4 = (identity_code & (0b1 << 7)) >> 7;
+
+    uint8_t b1 = (identity_code & (0b1 << 5)) >> 5;
+    uint8_t b2 = (identity_code & (0b1 << 3)) >> 3;
+    uint8_t b4 = (identity_code & (0b1 << 1)) >> 1;
+
+    uint8_t c1 = (identity_code & (0b1 << 12)) >> 12;
+    uint8_t c2 = (identity_code & (0b1 << 10)) >> 10;
+    uint8_t c4 = (identity_code & (0b1 << 8)) >> 8;
+
+    return (a4 << 11) | (a2 << 10) | (a1 << 9) | (b4 << 8) | (b2 << 7) | (b1 << 6) | (c4 << 5) | (c2 << 4) | (c1 << 3) |
+           (d4 << 2) | (d2 << 1) | d1;
+}
 
 TEST(DecodeUtils, GrayCodeConversion) {
     EXPECT_EQ(GrayToBinary(0b0000), 0u);
@@ -399,4 +478,216 @@ TEST(DecodeUtils, AltitudeCodeToAltitudeFt) {
 
 TEST(DecodeUtils, IdentityCodeToSquawk) {
     EXPECT_EQ(IdentityCodeToSquawk(0b1000101101101), 0356);  // Octal 0356.
-}
\ No newline at end of file
+}
+
+TEST(DecodeUtils, AltitudeAndIdentityCodeTables) {
+    for (uint16_t code = 0; code < kNumAltitudeCodes; code++) {
+        ASSERT_EQ(AltitudeCodeToAltitudeFt(code), AltitudeCodeToAltitudeFtBitwise(code)) << "AC=" << code;
+        ASSERT_EQ(IdentityCodeToSquawk(code), IdentityCodeToSquawkBitwise(code)) << "ID=" << code;
+    }
+    // Bits above the 13-bit code are ignored.
+    EXPECT_EQ(AltitudeCodeToAltitudeFt(0b1110011010100010), 10000);
+    EXPECT_EQ(IdentityCodeToSquawk(0b1111000101101101), 0356);
+    // Gillham coded altitudes go all the way up to 126,700ft.
+    EXPECT_EQ(AltitudeCodeToAltitudeFt(0b0010000101011), 60000);
+    // Invalid Gillham codes.
+    EXPECT_EQ(AltitudeCodeToAltitudeFt(0b0000000000010), kAltitudeDecodeErrorGillhamDecodeError);
+}
+
+TEST(DecodeUtils, AltitudeCodeToAltitudeFtBenchmark) {
+    const uint32_t kNumIterations = 1e6;
+    // Step through codes with a large odd stride, so that consecutive lookups don't hit the same cache line.
+    double bitwise_ns = BenchmarkNsPerCall(kNumIterations, [](uint32_t i) {
+        benchmark_sink = AltitudeCodeToAltitudeFtBitwise((i * 4099) % kNumAltitudeCodes) +
+                         IdentityCodeToSquawkBitwise((i * 4099) % kNumAltitudeCodes);
+    });
+    double table_ns = BenchmarkNsPerCall(kNumIterations, [](uint32_t i) {
+        benchmark_sink = AltitudeCodeToAltitudeFt((i * 4099) % kNumAltitudeCodes) +
+                         IdentityCodeToSquawk((i * 4099) % kNumAltitudeCodes);
+    });
+    PrintBenchmarkComparison("Mode A/C decode (bitwise vs table)", bitwise_ns, table_ns);
+}
+TEST(DecodeUtils, CalcNLCPRFromLatMatchesClosedForm) {
+    // Sweep every latitude in 1e-4 degree steps.
+    uint32_t num_checked = 0;
+    for (int32_t lat_e4 = -900000; lat_e4 <= 900000; lat_e4++) {
+        float lat = lat_e4 / 1e4f;
+        double nl_exact = CalcNLCPRFromLatClosedForm(lat);
+        if (fabs(nl_exact - round(nl_exact)) < 1e-5 && nl_exact > 2.0) {
+            continue;  // Too close to a transition latitude for float rounding to agree.
+        }
+        ASSERT_EQ(CalcNLCPRFromLat(lat), static_cast<uint16_t>(floor(nl_exact))) << "lat=" << lat;
+        num_checked++;
+    }
+    EXPECT_GT(num_checked, 1790000u);
+
+    // Special cases.
+    EXPECT_EQ(CalcNLCPRFromLat(0.0f), 59);
+    EXPECT_EQ(CalcNLCPRFromLat(87.0f), 2);
+    EXPECT_EQ(CalcNLCPRFromLat(-87.0f), 2);
+    EXPECT_EQ(CalcNLCPRFromLat(87.0001f), 1);
+    EXPECT_EQ(CalcNLCPRFromLat(90.0f), 1);
+    EXPECT_EQ(CalcNLCPRFromLat(-90.0f), 1);
+}
+
+TEST(DecodeUtils, CalcNLCPRFromLatBenchmark) {
+    const uint32_t kNumIterations = 1'000'000;
+    double transcendental_ns = BenchmarkNsPerCall(kNumIterations, [](uint32_t i) {
+        benchmark_sink = CalcNLCPRFromLatTranscendental(static_cast<float>(i % 180000) / 1000.0f - 90.0f);
+    });
+    double table_ns = BenchmarkNsPerCall(kNumIterations, [](uint32_t i) {
+        benchmark_sink = CalcNLCPRFromLat(static_cast<float>(i % 180000) / 1000.0f - 90.0f);
+    });
+    PrintBenchmarkComparison("CalcNLCPRFromLat", transcendental_ns, table_ns);
+}
+
+TEST(DecodeUtils, CalcNLCPRFromLatBAMMatchesClosedForm) {
+    // Sweep latitudes between -90 and 90 degrees in steps of 2^12 BAM (~3.4e-4 degrees).
+    const double kBAMToDeg = 360.0 / 4294967296.0;
+    for (int64_t lat_bam = -kBAM90Deg; lat_bam <= kBAM90Deg; lat_bam += 1 << 12) {
+        double nl_exact = CalcNLCPRFromLatClosedForm(lat_bam * kBAMToDeg);
+        if (fabs(nl_exact - round(nl_exact)) < 1e-6 && nl_exact > 2.0) {
+            continue;  // Too close to a transition latitude.
+        }
+        ASSERT_EQ(CalcNLCPRFromLatBAM(static_cast<int32_t>(lat_bam)), static_cast<uint16_t>(floor(nl_exact)))
+            << "lat_bam=" << lat_bam;
+    }
+    EXPECT_EQ(CalcNLCPRFromLatBAM(0), 59);
+    EXPECT_EQ(CalcNLCPRFromLatBAM(kBAM90Deg), 1);
+    EXPECT_EQ(CalcNLCPRFromLatBAM(-kBAM90Deg), 1);
+    EXPECT_EQ(CalcNLCPRFromLatBAM(INT32_MIN), 1);
+}
+
+TEST(DecodeUtils, BAMConversions) {
+    EXPECT_EQ(BAMToDegE7(0), 0);
+    EXPECT_EQ(BAMToDegE7(kBAM90Deg), 900000000);
+    EXPECT_EQ(BAMToDegE7(-kBAM90Deg), -900000000);
+    EXPECT_EQ(BAMToDegE7(INT32_MIN), -1800000000);
+    EXPECT_EQ(DegE7ToBAM(900000000), kBAM90Deg);
+    EXPECT_EQ(DegE7ToBAM(-900000000), -kBAM90Deg);
+    EXPECT_EQ(DegE7ToBAM(1800000000), INT32_MIN);  // 180 degrees wraps to -180 degrees.
+
+    // Round trips are within 1 unit of the original value.
+    for (int32_t deg_e7 = -1800000000; deg_e7 < 1800000000; deg_e7 += 123457) {
+        ASSERT_NEAR(BAMToDegE7(DegE7ToBAM(deg_e7)), deg_e7, 1);
+    }
+
+    // CPR zones.
+    EXPECT_EQ(CPRZoneToBAM(0, 0, kCPRNumLatZonesEven), 0);
+    EXPECT_EQ(BAMToDegE7(CPRZoneToBAM(1, 0, kCPRNumLatZonesEven)), 60000000);  // Even zones are 6 degrees.
+    EXPECT_EQ(BAMToDegE7(CPRZoneToBAM(-1, kCPRNumCounts / 2, kCPRNumLatZonesEven)), -30000000);
+    EXPECT_EQ(BAMToDegE7(CPRZoneToBAM(kCPRNumLatZonesEven, 0, kCPRNumLatZonesEven)), 0);  // Wraps after a full turn.
+    EXPECT_EQ(CPRMod(-1, 60), 59);
+    EXPECT_EQ(CPRMod(61, 60), 1);
+}
+
+TEST(DecodeUtils, CalcGroundSpeedAndTrack) {
+    uint32_t ground_speed_kts_e3;
+    uint32_t track_bam;
+    CalcGroundSpeedAndTrack(0, 0, ground_speed_kts_e3, track_bam);
+    EXPECT_EQ(ground_speed_kts_e3, 0u);
+    EXPECT_EQ(track_bam, 0u);
+    CalcGroundSpeedAndTrack(0, 100, ground_speed_kts_e3, track_bam);  // North.
+    EXPECT_EQ(ground_speed_kts_e3, 100000u);
+    EXPECT_EQ(track_bam, 0u);
+    CalcGroundSpeedAndTrack(0, -100, ground_speed_kts_e3, track_bam);  // South.
+    EXPECT_EQ(ground_speed_kts_e3, 100000u);
+    EXPECT_EQ(track_bam, 1u << 31);
+    CalcGroundSpeedAndTrack(100, 0, ground_speed_kts_e3, track_bam);  // East.
+    EXPECT_NEAR(ground_speed_kts_e3, 100000u, 10);  // Within 0.01kts.
+    EXPECT_NEAR(BAMToDegE7(track_bam), 900'000'000, 500'000);  // Within 0.05 degrees.
+    CalcGroundSpeedAndTrack(-3, -4, ground_speed_kts_e3, track_bam);  // South-west.
+    EXPECT_NEAR(ground_speed_kts_e3, 5000u, 10);
+    EXPECT_NEAR(BAMToDegE7(track_bam), -1'431'301'270, 500'000);  // 216.8698730 degrees.
+    CalcGroundSpeedAndTrack(-4088, 4088, ground_speed_kts_e3, track_bam);  // Supersonic, north-west.
+    EXPECT_NEAR(ground_speed_kts_e3, 5'781'302u, 10);
+    EXPECT_NEAR(BAMToDegE7(track_bam), -450'000'000, 500'000);
+}
+
+TEST(DecodeUtils, CalcGroundSpeedAndTrackAccuracy) {
+    // Every velocity that can be encoded in an airborne velocities message (10-bit magnitudes plus a sign bit), with
+    // supersonic velocities being 4x the subsonic ones.
+    const int32_t kMaxVelocityComponentKts = 1022;
+    for (int32_t scale = 1; scale <= 4; scale += 3) {
+        for (int32_t v_ew_kts = -kMaxVelocityComponentKts; v_ew_kts <= kMaxVelocityComponentKts; v_ew_kts++) {
+            for (int32_t v_ns_kts = -kMaxVelocityComponentKts; v_ns_kts <= kMaxVelocityComponentKts; v_ns_kts++) {
+                uint32_t ground_speed_kts_e3;
+                uint32_t track_bam;
+                CalcGroundSpeedAndTrack(v_ew_kts * scale, v_ns_kts * scale, ground_speed_kts_e3, track_bam);
+                double expected_ground_speed_kts = std::hypot(v_ew_kts * scale, v_ns_kts * scale);
+                ASSERT_NEAR(ground_speed_kts_e3 * 1e-3, expected_ground_speed_kts, 0.01)
+                    << "v_ew_kts=" << v_ew_kts * scale << " v_ns_kts=" << v_ns_kts * scale;
+                if (v_ew_kts == 0 && v_ns_kts == 0) {
+                    continue;  // Track is undefined.
+                }
+                double track_error_deg =
+                    std::remainder(track_bam * 360.0 / 4294967296.0 - std::atan2(v_ew_kts, v_ns_kts) * 180.0 / M_PI,
+                                   360.0);
+                ASSERT_LT(std::abs(track_error_deg), 0.05)
+                    << "v_ew_kts=" << v_ew_kts * scale << " v_ns_kts=" << v_ns_kts * scale;
+            }
+        }
+    }
+}
+
+TEST(DecodeUtils, CalcGroundSpeedAndTrackBenchmark) {
+    const uint32_t kNumIterations = 1e6;
+    // Previous implementation, kept for benchmarking.
+    double float_ns = BenchmarkNsPerCall(kNumIterations, [](uint32_t i) {
+        float v_x_kts = static_cast<int32_t>(i % 2045) - 1022;
+        float v_y_kts = static_cast<int32_t>((i * 7) % 2045) - 1022;
+        float track_rad = atan2f(v_x_kts, v_y_kts);
+        track_rad = track_rad < 0.0f ? (track_rad + (2.0f * M_PI)) : track_rad;
+        benchmark_sink = sqrtf(v_x_kts * v_x_kts + v_y_kts * v_y_kts) + track_rad * 360.0f / (2.0f * M_PI);
+    });
+    double cordic_ns = BenchmarkNsPerCall(kNumIterations, [](uint32_t i) {
+        uint32_t ground_speed_kts_e3;
+        uint32_t track_bam;
+        CalcGroundSpeedAndTrack(static_cast<int32_t>(i % 2045) - 1022, static_cast<int32_t>((i * 7) % 2045) - 1022,
+                                ground_speed_kts_e3, track_bam);
+        benchmark_sink = ground_speed_kts_e3 + track_bam;
+    });
+    // The host has hardware floating point and the RP2040 doesn't, so this isn't representative of the target.
+    PrintBenchmarkComparison("Ground speed and track (float vs CORDIC)", float_ns, cordic_ns);
+}
+
+TEST(DecodeUtils, SurfaceMovementToGroundSpeedKts) {
+    EXPECT_EQ(SurfaceMovementToGroundSpeedKts(0), kSurfaceMovementNotAvailable);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(1), 0.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(2), 0.125f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(8), 0.875f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(9), 1.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(12), 1.75f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(13), 2.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(38), 14.5f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(39), 15.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(93), 69.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(94), 70.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(108), 98.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(109), 100.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(123), 170.0f);
+    EXPECT_FLOAT_EQ(SurfaceMovementToGroundSpeedKts(124), 175.0f);
+    EXPECT_EQ(SurfaceMovementToGroundSpeedKts(125), kSurfaceMovementNotAvailable);
+    EXPECT_EQ(SurfaceMovementToGroundSpeedKts(127), kSurfaceMovementNotAvailable);
+}
+
+TEST(DecodeUtils, IsAllocatedICAOAddress) {
+    for (uint16_t i = 1; i < sizeof(kAllocatedICAOAddressBlocks) / sizeof(ICAOAddressBlock); i++) {
+        EXPECT_GT(kAllocatedICAOAddressBlocks[i].first_address, kAllocatedICAOAddressBlocks[i - 1].last_address);
+    }
+    static_assert(IsAllocatedICAOAddress(0xA4F239));  // United States.
+    EXPECT_TRUE(IsAllocatedICAOAddress(0x7C1B28));    // Australia.
+    EXPECT_TRUE(IsAllocatedICAOAddress(0x3C6444));    // Germany.
+    EXPECT_TRUE(IsAllocatedICAOAddress(0x8A8000));    // Indonesia, whose block is 0x8A0000-0x8AFFFF.
+    EXPECT_TRUE(IsAllocatedICAOAddress(0xC00001));    // Canada.
+    EXPECT_TRUE(IsAllocatedICAOAddress(0x004000));    // First address of a block.
+    EXPECT_TRUE(IsAllocatedICAOAddress(0xF093FF));    // Last address of the last block.
+
+    static_assert(!IsAllocatedICAOAddress(0x000000));
+    EXPECT_FALSE(IsAllocatedICAOAddress(0xFFFFFF));  // All-call address.
+    EXPECT_FALSE(IsAllocatedICAOAddress(0x003FFF));
+    EXPECT_FALSE(IsAllocatedICAOAddress(0x8B0000));
+    EXPECT_FALSE(IsAllocatedICAOAddress(0xB00000));
+    EXPECT_FALSE(IsAllocatedICAOAddress(0xD3CCBF));
+    EXPECT_FALSE(IsAllocatedICAOAddress(0xF09400));
+}
@@ -2,9 +2,11 @@
 #include "transponder_packet.hh"
 
 TEST(ModeCPacket, JasonPlaynePackets) {
-    ModeCPacket packet = ModeCPacket(DecodedTransponderPacket((char *)"200006A2DE8B1C"));
+    // Views need a parent packet that outlives them.
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"200006A2DE8B1C");
+    ModeCPacket packet = ModeCPacket(tpacket);
     EXPECT_FALSE(packet.IsValid());
-    packet.ForceValid();
+    tpacket.ForceValid();
     EXPECT_TRUE(packet.IsValid());
     EXPECT_EQ(packet.GetUtilityMessage(), 0);
     EXPECT_FALSE(packet.HasAlert());
@@ -12,9 +14,10 @@ TEST(ModeCPacket, JasonPlaynePackets) {
     EXPECT_TRUE(packet.IsAirborne());
     EXPECT_EQ(packet.GetICAOAddress(), 0x7C1B28u);
 
-    packet = ModeCPacket(DecodedTransponderPacket((char *)"210000992F8C48"));
+    tpacket = DecodedTransponderPacket((char *)"210000992F8C48");
+    packet = ModeCPacket(tpacket);
     EXPECT_FALSE(packet.IsValid());
-    packet.ForceValid();
+    tpacket.ForceValid();
     EXPECT_TRUE(packet.IsValid());
     EXPECT_EQ(packet.GetUtilityMessage(), 0);
     EXPECT_FALSE(packet.HasAlert());
@@ -24,9 +27,10 @@ TEST(ModeCPacket, JasonPlaynePackets) {
 }
 
 TEST(ModeAPacket, JasonPlaynePackets) {
-    ModeAPacket packet = ModeAPacket(DecodedTransponderPacket((char *)"29001B3AF47E76"));
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"29001B3AF47E76");
+    ModeAPacket packet = ModeAPacket(tpacket);
     EXPECT_FALSE(packet.IsValid());
-    packet.ForceValid();
+    tpacket.ForceValid();
     EXPECT_TRUE(packet.IsValid());
     EXPECT_EQ(packet.GetUtilityMessage(), ModeAPacket::UtilityMessageType::kUtilityMessageNoInformation);
     EXPECT_FALSE(packet.HasAlert());
@@ -35,9 +39,10 @@ TEST(ModeAPacket, JasonPlaynePackets) {
     EXPECT_EQ(packet.GetICAOAddress(), 0x7C1474u);
     EXPECT_FALSE(packet.HasIdent());
 
-    packet = ModeAPacket(DecodedTransponderPacket((char *)"2820050BD0D698"));
+    tpacket = DecodedTransponderPacket((char *)"2820050BD0D698");
+    packet = ModeAPacket(tpacket);
     EXPECT_FALSE(packet.IsValid());
-    packet.ForceValid();
+    tpacket.ForceValid();
     EXPECT_TRUE(packet.IsValid());
     EXPECT_EQ(packet.GetUtilityMessage(), ModeAPacket::UtilityMessageType::kUtilityMessageNoInformation);
     EXPECT_EQ(packet.GetDownlinkRequest(),
@@ -49,7 +54,8 @@ TEST(ModeAPacket, JasonPlaynePackets) {
     EXPECT_FALSE(packet.HasIdent());
 
     // Edit the previous packet to force an ident.
-    packet = ModeAPacket(DecodedTransponderPacket((char *)"2D20050BD0D698"));
+    tpacket = DecodedTransponderPacket((char *)"2D20050BD0D698");
+    packet = ModeAPacket(tpacket);
     EXPECT_EQ(packet.GetUtilityMessage(), ModeAPacket::UtilityMessageType::kUtilityMessageNoInformation);
     EXPECT_EQ(packet.GetDownlinkRequest(),
               ModeAPacket::DownlinkRequest::kDownlinkRequestCommBBroadcastMessage1Available);
@@ -59,7 +65,8 @@ TEST(ModeAPacket, JasonPlaynePackets) {
     EXPECT_TRUE(packet.HasIdent());
 
     // Edit the previous packet to force an ident and alert.
-    packet = ModeAPacket(DecodedTransponderPacket((char *)"2C20050BD0D698"));
+    tpacket = DecodedTransponderPacket((char *)"2C20050BD0D698");
+    packet = ModeAPacket(tpacket);
     EXPECT_EQ(packet.GetUtilityMessage(), ModeAPacket::UtilityMessageType::kUtilityMessageNoInformation);
     EXPECT_EQ(packet.GetDownlinkRequest(),
               ModeAPacket::DownlinkRequest::kDownlinkRequestCommBBroadcastMessage1Available);
@@ -67,4 +74,20 @@ TEST(ModeAPacket, JasonPlaynePackets) {
     EXPECT_EQ(packet.GetSquawk(), 00664u);
     EXPECT_FALSE(packet.IsAirborne());  // Not sure if in air or on ground, default to on ground.
     EXPECT_TRUE(packet.HasIdent());
-}
\ No newline at end of file
+}
+TEST(AirAirSurveillancePacket, AltitudeAndVerticalStatus) {
+    // Short air-air surveillance reply (DF=0) built from the altitude code of the first Mode C packet above.
+    DecodedTransponderPacket tpacket = DecodedTransponderPacket((char *)"000006A2000000");
+    tpacket.ForceValid();
+    AirAirSurveillancePacket packet = AirAirSurveillancePacket(tpacket);
+    EXPECT_TRUE(packet.IsValid());
+    EXPECT_EQ(packet.GetAltitudeFt(), 10000);
+    EXPECT_TRUE(packet.IsAirborne());
+
+    // Long air-air surveillance reply (DF=16) with the vertical status bit set to on ground.
+    tpacket = DecodedTransponderPacket((char *)"8400009900000000000000000000");
+    tpacket.ForceValid();
+    packet = AirAirSurveillancePacket(tpacket);
+    EXPECT_EQ(packet.GetAltitudeFt(), 25);
+    EXPECT_FALSE(packet.IsAirborne());
+}
@@ -18,6 +18,7 @@ TEST(CSBeeUtils, AircraftToCSBeeString) {
     char message[kCSBeeMessageStrMaxLen];
 
     Aircraft aircraft;
+    AircraftDetails details;
     aircraft.flags = UINT32_MAX;  // Set allll the flags.
     aircraft.last_message_timestamp_ms = 1000;
     aircraft.last_message_signal_strength_dbm = -75;
@@ -28,7 +29,7 @@ TEST(CSBeeUtils, AircraftToCSBeeString) {
     aircraft.stats_frames_received_in_last_interval = 4;
     aircraft.stats_mode_ac_frames_received_in_last_interval = 1;
     aircraft.stats_mode_s_frames_received_in_last_interval = 3;
-    aircraft.transponder_capability = ADSBPacket::Capability::kCALevel2PlusTransponderOnSurfaceCanSetCA7;
+    details.transponder_capability = ADSBPacket::Capability::kCALevel2PlusTransponderOnSurfaceCanSetCA7;
     aircraft.icao_address = 0x12345E;
     strcpy(aircraft.callsign, "ABCDEFG");
     aircraft.squawk = 01234;
@@ -36,27 +37,27 @@ TEST(CSBeeUtils, AircraftToCSBeeString) {
     aircraft.baro_altitude_ft = 1000;
     aircraft.gnss_altitude_ft = 997;
     aircraft.altitude_source = Aircraft::AltitudeSource::kAltitudeSourceBaro;
-    aircraft.latitude_deg = -120.654321;
-    aircraft.longitude_deg = -80.123456;
+    aircraft.latitude_deg_e7 = -1206543210;
+    aircraft.longitude_deg_e7 = -801234560;
     aircraft.track_deg = 300.5678;
     aircraft.velocity_kts = 123.45;
     aircraft.velocity_source = Aircraft::VelocitySource::kVelocitySourceAirspeedTrue;
     aircraft.vertical_rate_fpm = -200;
     aircraft.vertical_rate_source = Aircraft::VerticalRateSource::kVerticalRateSourceBaro;
-    aircraft.navigation_integrity_category = static_cast<Aircraft::NICRadiusOfContainment>(0b1011);
-    aircraft.navigation_integrity_category_baro = static_cast<Aircraft::NICBarometricAltitudeIntegrity>(0b1);
-    aircraft.navigation_accuracy_category_velocity = static_cast<Aircraft::NACHorizontalVelocityError>(0b101);
-    aircraft.navigation_accuracy_category_position = static_cast<Aircraft::NACEstimatedPositionUncertainty>(0b1101);
-    aircraft.geometric_vertical_accuracy = static_cast<Aircraft::GVA>(0b11);
-    aircraft.source_integrity_level = static_cast<Aircraft::SILProbabilityOfExceedingNICRadiusOfContainmnent>(
+    details.navigation_integrity_category = static_cast<Aircraft::NICRadiusOfContainment>(0b1011);
+    details.navigation_integrity_category_baro = static_cast<Aircraft::NICBarometricAltitudeIntegrity>(0b1);
+    details.navigation_accuracy_category_velocity = static_cast<Aircraft::NACHorizontalVelocityError>(0b101);
+    details.navigation_accuracy_category_position = static_cast<Aircraft::NACEstimatedPositionUncertainty>(0b1101);
+    details.geometric_vertical_accuracy = static_cast<Aircraft::GVA>(0b11);
+    details.source_integrity_level = static_cast<Aircraft::SILProbabilityOfExceedingNICRadiusOfContainmnent>(
         Aircraft::kPOERCLessThanOrEqualTo1em5PerFlightHour);
-    aircraft.system_design_assurance = static_cast<Aircraft::SystemDesignAssurance>(0b11);
-    aircraft.gnss_antenna_offset_right_of_roll_axis_m = -6;
-    aircraft.length_m = 10;
-    aircraft.width_m = 20;
-    aircraft.adsb_version = 3;
+    details.system_design_assurance = static_cast<Aircraft::SystemDesignAssurance>(0b11);
+    details.gnss_antenna_offset_right_of_roll_axis_m = -6;
+    details.length_m = 10;
+    details.width_m = 20;
+    details.adsb_version = 3;
 
-    WriteCSBeeAircraftMessageStr(message, aircraft);
+    WriteCSBeeAircraftMessageStr(message, aircraft, details);
     std::string_view message_view(message);
     printf("%s\r\n", message_view.data());
     printf("%s\r\n", message_view.data());
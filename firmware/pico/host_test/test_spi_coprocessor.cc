@@ -27,10 +27,8 @@ TEST(SPICoprocessor, SCWritePacket) {
     EXPECT_EQ(packet.IsValid(), packet_copy.IsValid());
     RawTransponderPacket *tpacket_copy = (RawTransponderPacket *)packet_copy.data;
     EXPECT_EQ(tpacket.buffer_len_bits, tpacket_copy->buffer_len_bits);
-    EXPECT_EQ(tpacket.buffer[0], tpacket_copy->buffer[0]);
-    EXPECT_EQ(tpacket.buffer[1], tpacket_copy->buffer[1]);
-    EXPECT_EQ(tpacket.buffer[2], tpacket_copy->buffer[2]);
-    EXPECT_EQ(tpacket.buffer[3], tpacket_copy->buffer[3]);
+    EXPECT_EQ(tpacket.frame.header_and_parity, tpacket_copy->frame.header_and_parity);
+    EXPECT_EQ(tpacket.frame.message, tpacket_copy->frame.message);
 
     // Poke packet and make checksum fail.
     packet.data[0] = ~packet.data[0];
@@ -83,12 +81,14 @@ TEST(SPICoprocessor, SCResponsePacket) {
     EXPECT_TRUE(packet_copy.IsValid());
     EXPECT_EQ(packet_copy.cmd, packet.cmd);
     RawTransponderPacket *tpacket_copy = (RawTransponderPacket *)packet_copy.data;
-    EXPECT_EQ(tpacket_copy->buffer[0], 0x8D7C1BE8u);
-    EXPECT_EQ(tpacket_copy->buffer[1], 0x581B66E9u);
-    EXPECT_EQ(tpacket_copy->buffer[2], 0xBD8CEEDCu);
-    EXPECT_EQ(tpacket_copy->buffer[3], 0x1C9Fu << 16);
+    uint32_t tpacket_copy_buffer[RawTransponderPacket::kMaxPacketLenWords32];
+    tpacket_copy->frame.ToWords32(tpacket_copy_buffer, tpacket_copy->buffer_len_bits);
+    EXPECT_EQ(tpacket_copy_buffer[0], 0x8D7C1BE8u);
+    EXPECT_EQ(tpacket_copy_buffer[1], 0x581B66E9u);
+    EXPECT_EQ(tpacket_copy_buffer[2], 0xBD8CEEDCu);
+    EXPECT_EQ(tpacket_copy_buffer[3], 0x1C9Fu << 16);
     // Poke the checksum and see it fail.
-    tpacket_copy->buffer[0] = tpacket_copy->buffer[0] << 1;
+    tpacket_copy->frame.header_and_parity = tpacket_copy->frame.header_and_parity << 1;
     EXPECT_FALSE(packet_copy.IsValid());
     // Make sure original packet was not affected.
     EXPECT_TRUE(packet.IsValid());
@@ -147,22 +147,23 @@ bool ADSBee::Update() {
 
     // Prune aircraft dictionary. Need to do this up front so that we don't end up with a negative timestamp delta
     // caused by packets being ingested more recently than the timestamp we take at the beginning of this function.
-    if (last_aircraft_dictionary_update_timestamp_ms_ - timestamp_ms > config_.aircraft_dictionary_update_interval_ms) {
+    if (timestamp_ms - last_aircraft_dictionary_update_timestamp_ms_ > config_.aircraft_dictionary_update_interval_ms) {
         aircraft_dictionary.Update(timestamp_ms);
+        last_aircraft_dictionary_update_timestamp_ms_ = timestamp_ms;
     }
 
     // Ingest new packets into the dictionary.
     RawTransponderPacket raw_packet;
     while (transponder_packet_queue.Pop(raw_packet)) {
         uint32_t packet_buffer[RawTransponderPacket::kMaxPacketLenWords32];
+        raw_packet.frame.ToWords32(packet_buffer, raw_packet.buffer_len_bits);
         if (raw_packet.buffer_len_bits == DecodedTransponderPacket::kExtendedSquitterPacketLenBits) {
-            CONSOLE_INFO("ADSBee::Update", "New message: 0x%08x|%08x|%08x|%04x RSSI=%ddBm MLAT=%u",
-                         raw_packet.buffer[0], raw_packet.buffer[1], raw_packet.buffer[2],
-                         (raw_packet.buffer[3]) >> (4 * kBitsPerNibble), raw_packet.rssi_dbm,
-                         raw_packet.mlat_48mhz_64bit_counts);
+            CONSOLE_INFO("ADSBee::Update", "New message: 0x%08x|%08x|%08x|%04x RSSI=%ddBm MLAT=%u", packet_buffer[0],
+                         packet_buffer[1], packet_buffer[2], (packet_buffer[3]) >> (4 * kBitsPerNibble),
+                         raw_packet.rssi_dbm, raw_packet.mlat_48mhz_64bit_counts);
         } else {
-            CONSOLE_INFO("ADSBee::Update", "New message: 0x%08x|%06x RSSI=%ddBm MLAT=%u", raw_packet.buffer[0],
-                         (raw_packet.buffer[1]) >> (2 * kBitsPerNibble), raw_packet.rssi_dbm,
+            CONSOLE_INFO("ADSBee::Update", "New message: 0x%08x|%06x RSSI=%ddBm MLAT=%u", packet_buffer[0],
+                         (packet_buffer[1]) >> (2 * kBitsPerNibble), raw_packet.rssi_dbm,
                          raw_packet.mlat_48mhz_64bit_counts);
         }
 
@@ -191,8 +192,7 @@ bool ADSBee::Update() {
     if (timestamp_ms - stats_last_update_timestamp_ms_ > kStatsUpdateIntervalMs) {
         // kStatsUpdateIntervalMs has elapsed. Time to update stuff!
         // Update statistics for each aircraft.
-        for (auto &itr : aircraft_dictionary.dict) {
-            Aircraft &aircraft = itr.second;
+        for (Aircraft &aircraft : aircraft_dictionary.dict) {
             aircraft.UpdateStats();
         }
         // Update statistics for the dictionary.
@@ -286,8 +286,8 @@ void ADSBee::OnDemodComplete() {
                                   pio_encode_push(false, true));
     }
 
-    // Clear the transponder packet buffer.
-    memset((void *)rx_packet_.buffer, 0x0, RawTransponderPacket::kMaxPacketLenWords32);
+    // Clear the buffer for words read out of the demodulator.
+    uint32_t rx_buffer[RawTransponderPacket::kMaxPacketLenWords32] = {0};
 
     // Pull all words out of the RX FIFO.
     volatile uint16_t packet_num_words =
@@ -304,20 +304,22 @@ void ADSBee::OnDemodComplete() {
     stats_demods_in_last_interval_counter_++;
     // Create a RawTransponderPacket and push it onto the queue.
     for (uint16_t i = 0; i < packet_num_words; i++) {
-        rx_packet_.buffer[i] = pio_sm_get(config_.message_demodulator_pio, message_demodulator_sm_);
+        rx_buffer[i] = pio_sm_get(config_.message_demodulator_pio, message_demodulator_sm_);
         if (i == packet_num_words - 1) {
             // // Trim off extra ingested bit from last word in the packet.
             // word  = word >> 1;
-            // Mask and left align final word based on bit length.
+            // Mask and left align final word based on bit length, then pack the words into a frame.
             switch (packet_num_words) {
                 case DecodedTransponderPacket::kSquitterPacketNumWords32:
-                    rx_packet_.buffer[i] = (rx_packet_.buffer[i] & 0xFFFFFF) << 8;
+                    rx_buffer[i] = (rx_buffer[i] & 0xFFFFFF) << 8;
                     rx_packet_.buffer_len_bits = DecodedTransponderPacket::kSquitterPacketLenBits;
+                    rx_packet_.frame = ModeSFrame(rx_buffer, rx_packet_.buffer_len_bits);
                     transponder_packet_queue.Push(rx_packet_);
                     break;
                 case DecodedTransponderPacket::kExtendedSquitterPacketNumWords32:
-                    rx_packet_.buffer[i] = (rx_packet_.buffer[i] & 0xFFFF) << 16;
+                    rx_buffer[i] = (rx_buffer[i] & 0xFFFF) << 16;
                     rx_packet_.buffer_len_bits = DecodedTransponderPacket::kExtendedSquitterPacketLenBits;
+                    rx_packet_.frame = ModeSFrame(rx_buffer, rx_packet_.buffer_len_bits);
                     transponder_packet_queue.Push(rx_packet_);
                     break;
                 default:
@@ -3,7 +3,7 @@
 
 #include "aircraft_dictionary.hh"
 #include "cpp_at.hh"
-#include "data_structures.hh"  // For PFBQueue.
+#include "data_structures.hh"  // For SPSCQueue.
 #include "hardware/i2c.h"
 #include "hardware/pio.h"
 #include "hardware/watchdog.h"
@@ -234,7 +234,8 @@ class ADSBee {
                          uint16_t tl_learning_start_temperature_mv = kTLLearningStartTemperatureMV,
                          uint16_t tl_min_mv = kTLMinMV, uint16_t tl_max_mv = kTLMaxMV);
 
-    PFBQueue<RawTransponderPacket> transponder_packet_queue = PFBQueue<RawTransponderPacket>(
+    // Pushed by OnDemodComplete (interrupt context), popped by Update (main loop).
+    SPSCQueue<RawTransponderPacket> transponder_packet_queue = SPSCQueue<RawTransponderPacket>(
         {.buf_len_num_elements = kMaxNumTransponderPackets, .buffer = transponder_packet_queue_buffer_});
 
     AircraftDictionary aircraft_dictionary;
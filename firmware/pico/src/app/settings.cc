@@ -38,6 +38,8 @@ bool SettingsManager::Save() {
     settings.receiver_enabled = adsbee.ReceiverIsEnabled();
     settings.tl_mv = adsbee.GetTLMilliVolts();
     settings.bias_tee_enabled = adsbee.BiasTeeIsEnabled();
+    settings.receiver_position_valid = adsbee.aircraft_dictionary.GetReceiverPosition(
+        settings.receiver_latitude_deg_e7, settings.receiver_longitude_deg_e7);
 
     // Save log level.
     settings.log_level = comms_manager.log_level;
@@ -75,6 +77,8 @@ void SettingsManager::Apply() {
     adsbee.SetReceiverEnable(settings.receiver_enabled);
     adsbee.SetTLMilliVolts(settings.tl_mv);
     adsbee.SetBiasTeeEnable(settings.bias_tee_enabled);
+    adsbee.aircraft_dictionary.SetReceiverPosition(settings.receiver_position_valid, settings.receiver_latitude_deg_e7,
+                                                   settings.receiver_longitude_deg_e7);
 
     // Apply log level.
     comms_manager.log_level = settings.log_level;
@@ -38,6 +38,7 @@ class CommsManager {
 
     CPP_AT_CALLBACK(ATBaudrateCallback);
     CPP_AT_CALLBACK(ATBiasTeeEnableCallback);
+    CPP_AT_CALLBACK(ATDictStatsCallback);
     CPP_AT_CALLBACK(ATFeedCallback);
     CPP_AT_CALLBACK(ATFlashESP32Callback);
     CPP_AT_CALLBACK(ATLogLevelCallback);
@@ -45,6 +46,7 @@ class CommsManager {
     CPP_AT_HELP_CALLBACK(ATProtocolHelpCallback);
     CPP_AT_CALLBACK(ATRebootCallback);
     CPP_AT_CALLBACK(ATRxEnableCallback);
+    CPP_AT_CALLBACK(ATRxPositionCallback);
     CPP_AT_CALLBACK(ATSettingsCallback);
     CPP_AT_CALLBACK(ATTLReadCallback);
     CPP_AT_CALLBACK(ATTLSetCallback);
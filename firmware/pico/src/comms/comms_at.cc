@@ -82,6 +82,34 @@ CPP_AT_CALLBACK(CommsManager::ATBiasTeeEnableCallback) {
     CPP_AT_ERROR();  // Should never get here.
 }
 
+/**
+ * AT+DICT_STATS Callback
+ * AT+DICT_STATS?
+ * +DICT_STATS=<value>(<stat>),...
+ *  Counters kept by the aircraft dictionary since boot.
+ */
+CPP_AT_CALLBACK(CommsManager::ATDictStatsCallback) {
+    switch (op) {
+        case '?': {
+            const AircraftDictionary &dictionary = adsbee.aircraft_dictionary;
+            CPP_AT_CMD_PRINTF(
+                "=%lu(adsb_message_cache_hits),%lu(adsb_message_cache_misses),%lu(packets_corrected_1_bit),"
+                "%lu(packets_corrected_2_bit),%lu(aircraft_evicted),%lu(aircraft_rejected),%lu(candidates_promoted),"
+                "%lu(candidates_unallocated),%lu(comm_b_unknown),%lu(comm_b_ambiguous),"
+                "%lu(surface_positions_undecodable)\r\n",
+                dictionary.stats_num_adsb_message_cache_hits, dictionary.stats_num_adsb_message_cache_misses,
+                dictionary.stats_num_packets_corrected_1_bit, dictionary.stats_num_packets_corrected_2_bit,
+                dictionary.stats_num_aircraft_evicted, dictionary.stats_num_aircraft_rejected,
+                dictionary.stats_num_candidates_promoted, dictionary.stats_num_candidates_unallocated,
+                dictionary.stats_num_comm_b_unknown, dictionary.stats_num_comm_b_ambiguous,
+                dictionary.stats_num_surface_positions_undecodable);
+            CPP_AT_SILENT_SUCCESS();
+            break;
+        }
+    }
+    CPP_AT_ERROR("Operator '%c' not supported.", op);
+}
+
 void ATFeedHelpCallback() {
     CPP_AT_PRINTF(
         "\tAT+FEED=<feed_index>,<feed_uri>,<feed_port>,<active>,<protocol>\r\n\tSet details for a "
@@ -292,6 +320,41 @@ CPP_AT_CALLBACK(CommsManager::ATRxEnableCallback) {
     CPP_AT_ERROR("Operator '%c' not supported.", op);
 }
 
+CPP_AT_CALLBACK(CommsManager::ATRxPositionCallback) {
+    switch (op) {
+        case '=': {
+            if (!CPP_AT_HAS_ARG(0)) {
+                CPP_AT_ERROR("Requires at least one argument. AT+RX_POSITION=<valid>,<lat_deg_e7>,<lon_deg_e7>");
+            }
+            bool valid;
+            CPP_AT_TRY_ARG2NUM(0, valid);
+            int32_t latitude_deg_e7, longitude_deg_e7;
+            adsbee.aircraft_dictionary.GetReceiverPosition(latitude_deg_e7, longitude_deg_e7);
+            if (CPP_AT_HAS_ARG(1)) {
+                CPP_AT_TRY_ARG2NUM(1, latitude_deg_e7);
+            }
+            if (CPP_AT_HAS_ARG(2)) {
+                CPP_AT_TRY_ARG2NUM(2, longitude_deg_e7);
+            }
+            if (latitude_deg_e7 < -900000000 || latitude_deg_e7 > 900000000 || longitude_deg_e7 < -1800000000 ||
+                longitude_deg_e7 > 1800000000) {
+                CPP_AT_ERROR("Receiver position out of range.");
+            }
+            adsbee.aircraft_dictionary.SetReceiverPosition(valid, latitude_deg_e7, longitude_deg_e7);
+            CPP_AT_SUCCESS();
+            break;
+        }
+        case '?': {
+            int32_t latitude_deg_e7, longitude_deg_e7;
+            bool valid = adsbee.aircraft_dictionary.GetReceiverPosition(latitude_deg_e7, longitude_deg_e7);
+            CPP_AT_CMD_PRINTF("=%d,%ld,%ld", valid, latitude_deg_e7, longitude_deg_e7);
+            CPP_AT_SILENT_SUCCESS();
+            break;
+        }
+    }
+    CPP_AT_ERROR("Operator '%c' not supported.", op);
+}
+
 CPP_AT_CALLBACK(CommsManager::ATSettingsCallback) {
     switch (op) {
         case '=':
@@ -434,6 +497,12 @@ const CppAT::ATCommandDef_t at_command_list[] = {
      .help_string_buf = "AT+BIAS_TEE_ENABLE=<enabled>\r\n\tEnable or disable the bias "
                         "tee.\r\n\tAT+BIAS_TEE_ENABLE=1\r\n\tAT+BIAS_TEE_ENABLE=0\r\n\tBIAS_TEE_ENABLE?",
      .callback = CPP_AT_BIND_MEMBER_CALLBACK(CommsManager::ATBiasTeeEnableCallback, comms_manager)},
+    {.command_buf = "+DICT_STATS",
+     .min_args = 0,
+     .max_args = 0,
+     .help_string_buf = "AT+DICT_STATS?\r\n\t+DICT_STATS=<value>(<stat>),...\r\n\tQuery the aircraft dictionary "
+                        "counters, including ADS-B message cache hits and misses.",
+     .callback = CPP_AT_BIND_MEMBER_CALLBACK(CommsManager::ATDictStatsCallback, comms_manager)},
     {.command_buf = "+FEED",
      .min_args = 0,
      .max_args = 5,
@@ -470,6 +539,13 @@ const CppAT::ATCommandDef_t at_command_list[] = {
      .callback = CPP_AT_BIND_MEMBER_CALLBACK(CommsManager::ATRxEnableCallback, comms_manager)
 
     },
+    {.command_buf = "+RX_POSITION",
+     .min_args = 0,
+     .max_args = 3,
+     .help_string_buf = "RX_POSITION=<valid [1,0]>,<lat_deg_e7>,<lon_deg_e7>\r\n\tOK\r\n\tSets the receiver position, "
+                        "used to decode surface positions.\r\n\tAT+RX_POSITION?\r\n\t+RX_POSITION=<valid [1,0]>,"
+                        "<lat_deg_e7>,<lon_deg_e7>\r\n\tQuery the receiver position.",
+     .callback = CPP_AT_BIND_MEMBER_CALLBACK(CommsManager::ATRxPositionCallback, comms_manager)},
     {.command_buf = "+SETTINGS",
      .min_args = 0,
      .max_args = 3,
@@ -84,11 +84,11 @@ bool CommsManager::ReportBeast(SettingsManager::SerialInterface iface,
 
 bool CommsManager::ReportCSBee(SettingsManager::SerialInterface iface) {
     // Write out a CSBee Aircraft message for each aircraft in the aircraft dictionary.
-    for (auto &itr : adsbee.aircraft_dictionary.dict) {
-        const Aircraft &aircraft = itr.second;
-
+    adsbee.aircraft_dictionary.DecodePendingMessages();
+    for (const Aircraft &aircraft : adsbee.aircraft_dictionary.dict) {
         char message[kCSBeeMessageStrMaxLen];
-        int16_t message_len = WriteCSBeeAircraftMessageStr(message, aircraft);
+        int16_t message_len = WriteCSBeeAircraftMessageStr(
+            message, aircraft, adsbee.aircraft_dictionary.GetAircraftDetails(aircraft));
         if (message_len < 0) {
             CONSOLE_ERROR("CommsManager::ReportCSBee",
                           "Encountered an error in WriteCSBeeAircraftMessageStr, error code %d.", message_len);
@@ -171,16 +171,15 @@ bool CommsManager::ReportMAVLINK(SettingsManager::SerialInterface iface) {
     uint16_t mavlink_version = reporting_protocols_[iface] == SettingsManager::kMAVLINK1 ? 1 : 2;
     mavlink_set_proto_version(SettingsManager::SerialInterface::kCommsUART, mavlink_version);
 
-    for (auto &itr : adsbee.aircraft_dictionary.dict) {
-        const Aircraft &aircraft = itr.second;
-
+    adsbee.aircraft_dictionary.DecodePendingMessages();
+    for (const Aircraft &aircraft : adsbee.aircraft_dictionary.dict) {
         // Initialize the message
         mavlink_adsb_vehicle_t adsb_vehicle_msg = {
             .ICAO_address = aircraft.icao_address,
             // Latitude [degE7]
-            .lat = static_cast<int32_t>(aircraft.latitude_deg * 1e7f),
+            .lat = aircraft.latitude_deg_e7,
             // Longitude [degE7]
-            .lon = static_cast<int32_t>(aircraft.longitude_deg * 1e7f),
+            .lon = aircraft.longitude_deg_e7,
             // Altitude [mm]
             .altitude = FeetToMeters(aircraft.altitude_source == Aircraft::AltitudeSource::kAltitudeSourceBaro
                                          ? aircraft.baro_altitude_ft
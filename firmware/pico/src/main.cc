@@ -43,8 +43,8 @@ int main() {
     Aircraft test_aircraft;
     test_aircraft.airframe_type = Aircraft::AirframeType::kAirframeTypeSpaceTransatmosphericVehicle;
     strcpy(test_aircraft.callsign, "TST1234");
-    test_aircraft.latitude_deg = 20;
-    test_aircraft.longitude_deg = -140;
+    test_aircraft.latitude_deg_e7 = 20e7;
+    test_aircraft.longitude_deg_e7 = -140e7;
     test_aircraft.baro_altitude_ft = 10000;
     test_aircraft.vertical_rate_fpm = -5;
     test_aircraft.altitude_source = Aircraft::AltitudeSource::kAltitudeSourceBaro;